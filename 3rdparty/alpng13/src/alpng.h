@@ -44,6 +44,14 @@ alpng.h -- Main include file.
 
 extern char* alpng_error_msg;
 
+/* optional profiling hook, called with phase 'B' before and 'E' after inflating,
+   drawing and unfiltering each row (arg is the row or -1) */
+extern void (*alpng_trace)(const char* name, char phase, int arg);
+
+/* optional progress hook, called while inflating with the number of bytes
+   unpacked so far, returning 0 aborts loading */
+extern int (*alpng_progress)(unsigned long done, unsigned long total);
+
 /* registers PNG extension for load/save_bitmap */
 void alpng_init(void);
 
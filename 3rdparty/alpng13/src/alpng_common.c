@@ -37,6 +37,9 @@ alpng_common.c -- Anything which doesn't fit anywhere else.
 
 char* alpng_error_msg = "No error.";
 
+void (*alpng_trace)(const char* name, char phase, int arg) = 0;
+int (*alpng_progress)(unsigned long done, unsigned long total) = 0;
+
 unsigned char ALPNG_PNG_HEADER[] = { 137, 80, 78, 71, 13, 10, 26, 10 };
 int ALPNG_PNG_HEADER_LEN = sizeof(ALPNG_PNG_HEADER);
 
@@ -181,7 +181,9 @@ BITMAP* load_png_pf(PACKFILE *f, RGB *pal) {
         return 0;
     }
     
+    ALPNG_TRACE("png inflate", 'B', -1);
     res = alpng_inflate(&input_data, raw_data, raw_data_length, &alpng_error_msg);
+    ALPNG_TRACE("png inflate", 'E', -1);
     free(input_data.data);
     if (!res) {
         free(raw_data);
@@ -194,11 +196,13 @@ BITMAP* load_png_pf(PACKFILE *f, RGB *pal) {
         return 0;
     }
 
+    ALPNG_TRACE("png draw", 'B', -1);
     if (header.interlace) {
         b = alpng_draw_interlaced(&header, raw_data, &fake_headers);
     } else {
         b = alpng_draw(&header, raw_data, raw_data_length);
     }
+    ALPNG_TRACE("png draw", 'E', -1);
     free(raw_data);
     if (!b) {
         return 0;
@@ -94,9 +94,10 @@ int alpng_unfilter(uint8_t* data, struct alpng_header* header) {
     for (y = 0; y < header->height; y++) {
         i = y * header->byte_width;
         filter_type = data[i];
+        ALPNG_TRACE("png unfilter", 'B', y);
         switch (filter_type) {
             case 0: /* None */
-                continue;
+                break;
             case 1: /* Sub */
                 for (x = filter_delta + 1; x < header->byte_width; x++) {
                     data[i + x] += data[i + x - filter_delta];
@@ -143,9 +144,11 @@ int alpng_unfilter(uint8_t* data, struct alpng_header* header) {
                 }
                 break;
             default:
+                ALPNG_TRACE("png unfilter", 'E', y);
                 alpng_error_msg = "Unknown filter!";
                 return 0;
         }
+        ALPNG_TRACE("png unfilter", 'E', y);
     }
     return 1;
 }
@@ -60,4 +60,7 @@ uint32_t alpng_calc_raw_data_length(struct alpng_header* header);
 int alpng_unfilter(uint8_t* data, struct alpng_header* header);
 uint8_t* alpng_filter(uint8_t* data, uint32_t w, uint32_t h, uint32_t filter_delta);
 
+/* calls the profiling hook if one is set */
+#define ALPNG_TRACE(name, phase, arg) do { if (alpng_trace) alpng_trace(name, phase, arg); } while (0)
+
 #endif  /* ALPNG_INTERNAL_H */
@@ -34,21 +34,48 @@ original_zlib.c -- Wrapper around original zlib implementation.
 #if defined(ALPNG_ZLIB) && (ALPNG_ZLIB == 1)
 
 #include <allegro.h>
+#include <string.h>
 #include <zlib.h>
 #include "../inflate/inflate.h"
 #include "deflate.h"
+#include "../alpng.h"
+
+/* output is unpacked in pieces of this size when alpng_progress is set */
+#define ALPNG_INFLATE_STEP (64 * 1024)
 
 /* Unpacks data. Returns 0 on error, unpacked data length otherwise.
    error_msg is assigned to the text of error message (text "OK" on success).
  */
 unsigned int alpng_inflate(struct input_data* data, unsigned char* unpacked_array, unsigned int unpacked_length, char** error_msg) {
-    uLongf real_length = unpacked_length;
-    int res = uncompress(unpacked_array, &real_length, data->data, data->length);
-    if (res != Z_OK) {
+    z_stream strm;
+    int res;
+
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit(&strm) != Z_OK) {
+        *error_msg = "Cannot decompress data!";
+        return 0;
+    }
+    strm.next_in = data->data;
+    strm.avail_in = data->length;
+    strm.next_out = unpacked_array;
+    do {
+        if (alpng_progress && !alpng_progress(strm.total_out, unpacked_length)) {
+            inflateEnd(&strm);
+            *error_msg = "Aborted!";
+            return 0;
+        }
+        strm.avail_out = unpacked_length - strm.total_out;
+        if (alpng_progress && strm.avail_out > ALPNG_INFLATE_STEP) {
+            strm.avail_out = ALPNG_INFLATE_STEP;
+        }
+        res = inflate(&strm, Z_NO_FLUSH);
+    } while (res == Z_OK && strm.total_out < unpacked_length);
+    inflateEnd(&strm);
+    if (res != Z_OK && res != Z_STREAM_END) {
         *error_msg = "Cannot decompress data!";
         return 0;
     }
-    return real_length;
+    return strm.total_out;
 }
 
 int alpng_deflate(uint8_t* data, uint32_t data_length, uint8_t** compressed_data, uint32_t* compressed_data_length, char** error_msg) {
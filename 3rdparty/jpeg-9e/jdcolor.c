@@ -12,6 +12,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"
 
 
 #if RANGE_BITS < 2
@@ -30,6 +31,7 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+  jsimd_ycc_rgb_ptr ycc_rgb_simd; /* => MMX/SSE2 row converter, or NULL */
 
   /* Private state for RGB->Y conversion */
   INT32 * rgb_y_tab;		/* => table for RGB to Y conversion */
@@ -220,7 +222,14 @@ ycc_rgb_convert (j_decompress_ptr cinfo,
     inptr2 = input_buf[2][input_row];
     input_row++;
     outptr = *output_buf++;
-    for (col = 0; col < num_cols; col++) {
+    col = 0;
+    if (cconvert->ycc_rgb_simd != NULL) {
+      /* SIMD does the leading columns, the loop below the rest */
+      col = (*cconvert->ycc_rgb_simd) (inptr0, inptr1, inptr2, outptr,
+				       num_cols);
+      outptr += col * RGB_PIXELSIZE;
+    }
+    for (; col < num_cols; col++) {
       y  = GETJSAMPLE(inptr0[col]);
       cb = GETJSAMPLE(inptr1[col]);
       cr = GETJSAMPLE(inptr2[col]);
@@ -620,6 +629,7 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
     ((j_common_ptr) cinfo, JPOOL_IMAGE, SIZEOF(my_color_deconverter));
   cinfo->cconvert = &cconvert->pub;
   cconvert->pub.start_pass = start_pass_dcolor;
+  cconvert->ycc_rgb_simd = NULL;
 
   /* Make sure num_components agrees with jpeg_color_space */
   switch (cinfo->jpeg_color_space) {
@@ -697,6 +707,7 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
     case JCS_YCbCr:
       cconvert->pub.color_convert = ycc_rgb_convert;
       build_ycc_rgb_table(cinfo);
+      cconvert->ycc_rgb_simd = jsimd_ycc_rgb(cinfo);
       break;
     case JCS_BG_YCC:
       cconvert->pub.color_convert = ycc_rgb_convert;
@@ -20,6 +20,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"		/* MMX/SSE2 kernels */
 
 
 /*
@@ -256,6 +257,8 @@ start_pass (j_decompress_ptr cinfo)
 	       compptr->DCT_h_scaled_size, compptr->DCT_v_scaled_size);
       break;
     }
+    /* Use the MMX/SSE2 version of the routine if there is one */
+    method_ptr = jsimd_idct(cinfo, compptr, method_ptr);
     idct->pub.inverse_DCT[ci] = method_ptr;
     /* Create multiplier table from quant table.
      * However, we can skip this if the component is uninteresting
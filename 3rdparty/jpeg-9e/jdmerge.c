@@ -36,6 +36,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"
 
 #ifdef UPSAMPLE_MERGING_SUPPORTED
 
@@ -61,6 +62,7 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+  jsimd_merged_ptr simd;	/* => MMX/SSE2 row upsampler, or NULL */
 
   /* For 2:1 vertical sampling, we produce two output rows at a time.
    * We need a "spare" row buffer to hold the second output row if the
@@ -268,7 +270,7 @@ h2v1_merged_upsample (j_decompress_ptr cinfo,
   int cb, cr;
   register JSAMPROW outptr;
   JSAMPROW inptr0, inptr1, inptr2;
-  JDIMENSION col;
+  JDIMENSION col, done;
   /* copy these pointers into registers if possible */
   register JSAMPLE * range_limit = cinfo->sample_range_limit;
   int * Crrtab = upsample->Cr_r_tab;
@@ -281,8 +283,19 @@ h2v1_merged_upsample (j_decompress_ptr cinfo,
   inptr1 = input_buf[1][in_row_group_ctr];
   inptr2 = input_buf[2][in_row_group_ctr];
   outptr = output_buf[0];
+  col = cinfo->output_width >> 1;
+  if (upsample->simd != NULL) {
+    /* SIMD does the leading pixel pairs, the loop below the rest */
+    done = (*upsample->simd) (inptr0, NULL, inptr1, inptr2,
+			      outptr, NULL, col);
+    inptr0 += done * 2;
+    inptr1 += done;
+    inptr2 += done;
+    outptr += done * 2 * RGB_PIXELSIZE;
+    col -= done;
+  }
   /* Loop for each pair of output pixels */
-  for (col = cinfo->output_width >> 1; col > 0; col--) {
+  for (; col > 0; col--) {
     /* Do the chroma part of the calculation */
     cb = GETJSAMPLE(*inptr1++);
     cr = GETJSAMPLE(*inptr2++);
@@ -330,7 +343,7 @@ h2v2_merged_upsample (j_decompress_ptr cinfo,
   int cb, cr;
   register JSAMPROW outptr0, outptr1;
   JSAMPROW inptr00, inptr01, inptr1, inptr2;
-  JDIMENSION col;
+  JDIMENSION col, done;
   /* copy these pointers into registers if possible */
   register JSAMPLE * range_limit = cinfo->sample_range_limit;
   int * Crrtab = upsample->Cr_r_tab;
@@ -345,8 +358,21 @@ h2v2_merged_upsample (j_decompress_ptr cinfo,
   inptr2 = input_buf[2][in_row_group_ctr];
   outptr0 = output_buf[0];
   outptr1 = output_buf[1];
+  col = cinfo->output_width >> 1;
+  if (upsample->simd != NULL) {
+    /* SIMD does the leading pixel pairs, the loop below the rest */
+    done = (*upsample->simd) (inptr00, inptr01, inptr1, inptr2,
+			      outptr0, outptr1, col);
+    inptr00 += done * 2;
+    inptr01 += done * 2;
+    inptr1 += done;
+    inptr2 += done;
+    outptr0 += done * 2 * RGB_PIXELSIZE;
+    outptr1 += done * 2 * RGB_PIXELSIZE;
+    col -= done;
+  }
   /* Loop for each group of output pixels */
-  for (col = cinfo->output_width >> 1; col > 0; col--) {
+  for (; col > 0; col--) {
     /* Do the chroma part of the calculation */
     cb = GETJSAMPLE(*inptr1++);
     cr = GETJSAMPLE(*inptr2++);
@@ -429,10 +455,13 @@ jinit_merged_upsampler (j_decompress_ptr cinfo)
     upsample->spare_row = NULL;
   }
 
-  if (cinfo->jpeg_color_space == JCS_BG_YCC)
+  if (cinfo->jpeg_color_space == JCS_BG_YCC) {
     build_bg_ycc_rgb_table(cinfo);
-  else
+    upsample->simd = NULL;
+  } else {
     build_ycc_rgb_table(cinfo);
+    upsample->simd = jsimd_merged(cinfo);
+  }
 }
 
 #endif /* UPSAMPLE_MERGING_SUPPORTED */
@@ -0,0 +1,567 @@
+/*
+ * jdmmx.c
+ *
+ * This file was added to the IJG software for DosView.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains MMX versions of the LL&M integer IDCTs of jidctint.c
+ * (jpeg_idct_islow, jpeg_idct_16x16 and jpeg_idct_16x8), of YCbCr->RGB
+ * conversion (jdcolor.c) and of merged upsampling (jdmerge.c), for the
+ * Pentium MMX, Pentium II/III and K6 class machines DosView runs on.
+ * jdsimd.c decides whether they are used.
+ *
+ * The arithmetic is that of jdsse2.c (see there) on four words per
+ * register, so a block is done in two halves of four columns or rows.
+ * MMX shares its registers with the FPU: every routine ends with EMMS.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#pragma GCC target("mmx")
+#include <mmintrin.h>
+
+
+/* Scaling of jidctint.c */
+
+#define CONST_BITS  13
+#define PASS1_BITS  2
+
+/* Rounding of the final shifts, added to the DC term; pass 2 also adds
+ * the range center.
+ */
+#define PASS1_BIAS  (ONE << (CONST_BITS-PASS1_BITS-1))
+#define PASS2_BIAS  ((((INT32) RANGE_CENTER << (PASS1_BITS+3)) + \
+		      (ONE << (PASS1_BITS+2))) << CONST_BITS)
+
+/* Constant pair for PMADDWD: interleaved words (x, y) give a*x + b*y */
+#define PAIR(a,b)  _mm_set_pi16(b, a, b, a)
+
+
+/*
+ * Dequantize four columns (h = 0: 0-3, h = 1: 4-7) of a coefficient
+ * block: r[k] is row k.  Returns nonzero words where a product does not
+ * fit in 16 bits.
+ */
+
+static inline __m64
+dequantize (JCOEFPTR coef_block, ISLOW_MULT_TYPE * quantptr, int h,
+	    __m64 r[8])
+{
+  __m64 err = _mm_setzero_si64();
+  __m64 c, q, lo, hi;
+  int k;
+
+  for (k = 0; k < 8; k++) {
+    c = *(const __m64 *) (coef_block + k*DCTSIZE + h*4);
+    q = _mm_packs_pi32(*(const __m64 *) (quantptr + k*DCTSIZE + h*4),
+		       *(const __m64 *) (quantptr + k*DCTSIZE + h*4 + 2));
+    lo = _mm_mullo_pi16(c, q);
+    hi = _mm_mulhi_pi16(c, q);
+    err = _mm_or_si64(err, _mm_xor_si64(hi, _mm_srai_pi16(lo, 15)));
+    r[k] = lo;
+  }
+  return err;
+}
+
+
+/*
+ * 8-point IDCT of two lanes, from the interleaved input pairs (y0,y4),
+ * (y2,y6), (y7,y5) and (y3,y1).  s[k] is output k before descaling.
+ */
+
+static inline void
+idct8_half (__m64 e04, __m64 e26, __m64 o75, __m64 o31,
+	    __m64 bias, __m64 s[8])
+{
+  __m64 tmp0, tmp1, tmp2, tmp3, tmp10, tmp11, tmp12, tmp13;
+
+  /* Even part */
+
+  tmp0 = _mm_add_pi32(_mm_madd_pi16(e04, PAIR(8192, 8192)), bias);
+  tmp1 = _mm_add_pi32(_mm_madd_pi16(e04, PAIR(8192, -8192)), bias);
+  tmp2 = _mm_madd_pi16(e26, PAIR(10703, 4433));
+  tmp3 = _mm_madd_pi16(e26, PAIR(4433, -10704));
+
+  tmp10 = _mm_add_pi32(tmp0, tmp2);
+  tmp13 = _mm_sub_pi32(tmp0, tmp2);
+  tmp11 = _mm_add_pi32(tmp1, tmp3);
+  tmp12 = _mm_sub_pi32(tmp1, tmp3);
+
+  /* Odd part */
+
+  tmp0 = _mm_add_pi32(_mm_madd_pi16(o75, PAIR(-11363, 9633)),
+		      _mm_madd_pi16(o31, PAIR(-6436, 2260)));
+  tmp1 = _mm_add_pi32(_mm_madd_pi16(o75, PAIR(9633, 2261)),
+		      _mm_madd_pi16(o31, PAIR(-11362, 6437)));
+  tmp2 = _mm_add_pi32(_mm_madd_pi16(o75, PAIR(-6436, -11362)),
+		      _mm_madd_pi16(o31, PAIR(-2259, 9633)));
+  tmp3 = _mm_add_pi32(_mm_madd_pi16(o75, PAIR(2260, 6437)),
+		      _mm_madd_pi16(o31, PAIR(9633, 11363)));
+
+  s[0] = _mm_add_pi32(tmp10, tmp3);
+  s[7] = _mm_sub_pi32(tmp10, tmp3);
+  s[1] = _mm_add_pi32(tmp11, tmp2);
+  s[6] = _mm_sub_pi32(tmp11, tmp2);
+  s[2] = _mm_add_pi32(tmp12, tmp1);
+  s[5] = _mm_sub_pi32(tmp12, tmp1);
+  s[3] = _mm_add_pi32(tmp13, tmp0);
+  s[4] = _mm_sub_pi32(tmp13, tmp0);
+}
+
+
+/*
+ * 16-point IDCT of two lanes (jpeg_idct_16x16), from the input pairs
+ * (y0,y4), (y2,y6), (y1,y3) and (y5,y7).
+ */
+
+static inline void
+idct16_half (__m64 e04, __m64 e26, __m64 o13, __m64 o57,
+	     __m64 bias, __m64 s[16])
+{
+  __m64 tmp0, tmp1, tmp2, tmp3, tmp10, tmp11, tmp12, tmp13;
+  __m64 tmp20, tmp21, tmp22, tmp23, tmp24, tmp25, tmp26, tmp27;
+
+  /* Even part */
+
+  tmp10 = _mm_add_pi32(_mm_madd_pi16(e04, PAIR(8192, 10703)), bias);
+  tmp11 = _mm_add_pi32(_mm_madd_pi16(e04, PAIR(8192, -10703)), bias);
+  tmp12 = _mm_add_pi32(_mm_madd_pi16(e04, PAIR(8192, 4433)), bias);
+  tmp13 = _mm_add_pi32(_mm_madd_pi16(e04, PAIR(8192, -4433)), bias);
+
+  tmp0 = _mm_madd_pi16(e26, PAIR(11363, 9632));
+  tmp1 = _mm_madd_pi16(e26, PAIR(9633, -2260));
+  tmp2 = _mm_madd_pi16(e26, PAIR(6437, -11363));
+  tmp3 = _mm_madd_pi16(e26, PAIR(2260, -6436));
+
+  tmp20 = _mm_add_pi32(tmp10, tmp0);
+  tmp27 = _mm_sub_pi32(tmp10, tmp0);
+  tmp21 = _mm_add_pi32(tmp12, tmp1);
+  tmp26 = _mm_sub_pi32(tmp12, tmp1);
+  tmp22 = _mm_add_pi32(tmp13, tmp2);
+  tmp25 = _mm_sub_pi32(tmp13, tmp2);
+  tmp23 = _mm_add_pi32(tmp11, tmp3);
+  tmp24 = _mm_sub_pi32(tmp11, tmp3);
+
+  /* Odd part */
+
+  tmp0  = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(11529, 11086)),
+		       _mm_madd_pi16(o57, PAIR(10217, 8956)));
+  tmp1  = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(11086, 7350)),
+		       _mm_madd_pi16(o57, PAIR(1136, -5461)));
+  tmp2  = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(10217, 1136)),
+		       _mm_madd_pi16(o57, PAIR(-8955, -11086)));
+  tmp3  = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(8956, -5461)),
+		       _mm_madd_pi16(o57, PAIR(-11086, 1137)));
+  tmp10 = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(7350, -10217)),
+		       _mm_madd_pi16(o57, PAIR(-3363, 11529)));
+  tmp11 = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(5461, -11529)),
+		       _mm_madd_pi16(o57, PAIR(7349, 3363)));
+  tmp12 = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(3363, -8955)),
+		       _mm_madd_pi16(o57, PAIR(11529, -10217)));
+  tmp13 = _mm_add_pi32(_mm_madd_pi16(o13, PAIR(1136, -3363)),
+		       _mm_madd_pi16(o57, PAIR(5461, -7350)));
+
+  s[0]  = _mm_add_pi32(tmp20, tmp0);
+  s[15] = _mm_sub_pi32(tmp20, tmp0);
+  s[1]  = _mm_add_pi32(tmp21, tmp1);
+  s[14] = _mm_sub_pi32(tmp21, tmp1);
+  s[2]  = _mm_add_pi32(tmp22, tmp2);
+  s[13] = _mm_sub_pi32(tmp22, tmp2);
+  s[3]  = _mm_add_pi32(tmp23, tmp3);
+  s[12] = _mm_sub_pi32(tmp23, tmp3);
+  s[4]  = _mm_add_pi32(tmp24, tmp10);
+  s[11] = _mm_sub_pi32(tmp24, tmp10);
+  s[5]  = _mm_add_pi32(tmp25, tmp11);
+  s[10] = _mm_sub_pi32(tmp25, tmp11);
+  s[6]  = _mm_add_pi32(tmp26, tmp12);
+  s[9]  = _mm_sub_pi32(tmp26, tmp12);
+  s[7]  = _mm_add_pi32(tmp27, tmp13);
+  s[8]  = _mm_sub_pi32(tmp27, tmp13);
+}
+
+
+/* The IDCTs of all four lanes of in[]: lo[] for lanes 0-1, hi[] for 2-3 */
+
+static inline void
+idct8 (const __m64 in[8], INT32 bias, __m64 lo[8], __m64 hi[8])
+{
+  __m64 b = _mm_set1_pi32(bias);
+
+  idct8_half(_mm_unpacklo_pi16(in[0], in[4]), _mm_unpacklo_pi16(in[2], in[6]),
+	     _mm_unpacklo_pi16(in[7], in[5]), _mm_unpacklo_pi16(in[3], in[1]),
+	     b, lo);
+  idct8_half(_mm_unpackhi_pi16(in[0], in[4]), _mm_unpackhi_pi16(in[2], in[6]),
+	     _mm_unpackhi_pi16(in[7], in[5]), _mm_unpackhi_pi16(in[3], in[1]),
+	     b, hi);
+}
+
+static inline void
+idct16 (const __m64 in[8], INT32 bias, __m64 lo[16], __m64 hi[16])
+{
+  __m64 b = _mm_set1_pi32(bias);
+
+  idct16_half(_mm_unpacklo_pi16(in[0], in[4]), _mm_unpacklo_pi16(in[2], in[6]),
+	      _mm_unpacklo_pi16(in[1], in[3]), _mm_unpacklo_pi16(in[5], in[7]),
+	      b, lo);
+  idct16_half(_mm_unpackhi_pi16(in[0], in[4]), _mm_unpackhi_pi16(in[2], in[6]),
+	      _mm_unpackhi_pi16(in[1], in[3]), _mm_unpackhi_pi16(in[5], in[7]),
+	      b, hi);
+}
+
+
+/*
+ * Descale pass 1 results to words; *err collects a value whose upper
+ * half is nonzero if one of them does not fit.
+ */
+
+static inline __m64
+descale_pass1 (__m64 lo, __m64 hi, __m64 * err)
+{
+  const __m64 half = _mm_set1_pi32(0x8000);
+
+  lo = _mm_srai_pi32(lo, CONST_BITS-PASS1_BITS);
+  hi = _mm_srai_pi32(hi, CONST_BITS-PASS1_BITS);
+  *err = _mm_or_si64(*err, _mm_or_si64(_mm_add_pi32(lo, half),
+				       _mm_add_pi32(hi, half)));
+  return _mm_packs_pi32(lo, hi);
+}
+
+
+/*
+ * Descale pass 2 results to words.  Masking and subtracting RANGE_SUBSET
+ * and then saturating to bytes does what IDCT_range_limit() does.
+ */
+
+static inline __m64
+descale_pass2 (__m64 lo, __m64 hi)
+{
+  const __m64 mask = _mm_set1_pi32(RANGE_MASK);
+  const __m64 subset = _mm_set1_pi32(RANGE_SUBSET);
+
+  lo = _mm_srai_pi32(lo, CONST_BITS+PASS1_BITS+3);
+  hi = _mm_srai_pi32(hi, CONST_BITS+PASS1_BITS+3);
+  lo = _mm_sub_pi32(_mm_and_si64(lo, mask), subset);
+  hi = _mm_sub_pi32(_mm_and_si64(hi, mask), subset);
+  return _mm_packs_pi32(lo, hi);
+}
+
+
+static inline boolean
+all_zero (__m64 x)
+{
+  return _mm_cvtsi64_si32(_mm_or_si64(x, _mm_srli_si64(x, 32))) == 0;
+}
+
+
+/* Transpose a 4x4 matrix of words */
+
+static inline void
+transpose4 (__m64 * v0, __m64 * v1, __m64 * v2, __m64 * v3)
+{
+  __m64 a0 = _mm_unpacklo_pi16(*v0, *v1);
+  __m64 a1 = _mm_unpackhi_pi16(*v0, *v1);
+  __m64 a2 = _mm_unpacklo_pi16(*v2, *v3);
+  __m64 a3 = _mm_unpackhi_pi16(*v2, *v3);
+
+  *v0 = _mm_unpacklo_pi32(a0, a2);
+  *v1 = _mm_unpackhi_pi32(a0, a2);
+  *v2 = _mm_unpacklo_pi32(a1, a3);
+  *v3 = _mm_unpackhi_pi32(a1, a3);
+}
+
+
+/* Transpose an 8x8 matrix of words, kept as rows of two halves */
+
+static inline void
+transpose8 (__m64 v[8][2])
+{
+  __m64 t;
+  int k;
+
+  transpose4(&v[0][0], &v[1][0], &v[2][0], &v[3][0]);
+  transpose4(&v[0][1], &v[1][1], &v[2][1], &v[3][1]);
+  transpose4(&v[4][0], &v[5][0], &v[6][0], &v[7][0]);
+  transpose4(&v[4][1], &v[5][1], &v[6][1], &v[7][1]);
+  for (k = 0; k < 4; k++) {
+    t = v[k][1];
+    v[k][1] = v[k + 4][0];
+    v[k + 4][0] = t;
+  }
+}
+
+
+/*
+ * Pass 1 of all IDCTs: process the columns of the block into ws[] (row k
+ * of the work array in ws[k]).  Returns FALSE if the block is not exact
+ * in 16 bits.
+ */
+
+static inline boolean
+pass1 (jpeg_component_info * compptr, JCOEFPTR coef_block,
+       __m64 ws[][2], int rows)
+{
+  __m64 in[8], lo[16], hi[16];
+  __m64 err1 = _mm_setzero_si64();
+  __m64 err2 = _mm_setzero_si64();
+  int h, k;
+
+  for (h = 0; h < 2; h++) {
+    err1 = _mm_or_si64(err1,
+		       dequantize(coef_block,
+				  (ISLOW_MULT_TYPE *) compptr->dct_table,
+				  h, in));
+    if (rows == 16)
+      idct16(in, PASS1_BIAS, lo, hi);
+    else
+      idct8(in, PASS1_BIAS, lo, hi);
+    for (k = 0; k < rows; k++)
+      ws[k][h] = descale_pass1(lo[k], hi[k], &err2);
+  }
+  return all_zero(_mm_or_si64(err1, _mm_srli_pi32(err2, 16)));
+}
+
+
+/*
+ * Pass 2 of all IDCTs: process eight rows of the work array (transposed
+ * in place) and store 8 or 16 samples of each.
+ */
+
+static inline void
+pass2 (__m64 ws[8][2], int cols, JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m64 in[8], lo[16], hi[16], out[16][2];
+  JSAMPROW outptr;
+  int g, k;
+
+  transpose8(ws);
+  for (g = 0; g < 2; g++) {
+    for (k = 0; k < 8; k++)
+      in[k] = ws[k][g];
+    if (cols == 16)
+      idct16(in, PASS2_BIAS, lo, hi);
+    else
+      idct8(in, PASS2_BIAS, lo, hi);
+    for (k = 0; k < cols; k++)
+      out[k][g] = descale_pass2(lo[k], hi[k]);
+  }
+  transpose8(out);
+  if (cols == 16)
+    transpose8(out + 8);
+  for (k = 0; k < 8; k++) {
+    outptr = output_buf[k] + output_col;
+    *(__m64 *) outptr = _mm_packs_pu16(out[k][0], out[k][1]);
+    if (cols == 16)
+      *(__m64 *) (outptr + 8) = _mm_packs_pu16(out[k + 8][0], out[k + 8][1]);
+  }
+}
+
+
+/*
+ * The IDCT routines.
+ */
+
+GLOBAL(void)
+jsimd_idct_islow_mmx (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m64 ws[8][2];
+
+  if (! pass1(compptr, coef_block, ws, 8)) {
+    _mm_empty();
+    jpeg_idct_islow(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  pass2(ws, 8, output_buf, output_col);
+  _mm_empty();
+}
+
+
+GLOBAL(void)
+jsimd_idct_16x16_mmx (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m64 ws[16][2];
+
+  if (! pass1(compptr, coef_block, ws, 16)) {
+    _mm_empty();
+    jpeg_idct_16x16(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  pass2(ws, 16, output_buf, output_col);
+  pass2(ws + 8, 16, output_buf + 8, output_col);
+  _mm_empty();
+}
+
+
+GLOBAL(void)
+jsimd_idct_16x8_mmx (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		     JCOEFPTR coef_block,
+		     JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m64 ws[8][2];
+
+  if (! pass1(compptr, coef_block, ws, 8)) {
+    _mm_empty();
+    jpeg_idct_16x8(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  pass2(ws, 16, output_buf, output_col);
+  _mm_empty();
+}
+
+
+/*
+ * R, G and B offsets of four centered Cb/Cr values (words), see
+ * chroma_offsets() in jdsse2.c.
+ */
+
+static inline void
+chroma_offsets (__m64 cb, __m64 cr, __m64 * r, __m64 * g, __m64 * b)
+{
+  const __m64 kr = _mm_set1_pi16(26345);
+  const __m64 kb = _mm_set1_pi16(-14942);
+  const __m64 one_half = _mm_set1_pi32(32768);
+  __m64 lo, hi;
+
+  *r = _mm_add_pi16(cr,
+		    _mm_add_pi16(_mm_mulhi_pi16(cr, kr),
+				 _mm_srli_pi16(_mm_mullo_pi16(cr, kr), 15)));
+  *b = _mm_add_pi16(_mm_add_pi16(cb, cb),
+		    _mm_add_pi16(_mm_mulhi_pi16(cb, kb),
+				 _mm_srli_pi16(_mm_mullo_pi16(cb, kb), 15)));
+  lo = _mm_madd_pi16(_mm_unpacklo_pi16(cb, cr), PAIR(-22553, 18734));
+  hi = _mm_madd_pi16(_mm_unpackhi_pi16(cb, cr), PAIR(-22553, 18734));
+  lo = _mm_srai_pi32(_mm_add_pi32(lo, one_half), 16);
+  hi = _mm_srai_pi32(_mm_add_pi32(hi, one_half), 16);
+  *g = _mm_sub_pi16(_mm_packs_pi32(lo, hi), cr);
+}
+
+
+/*
+ * Store 8 RGB pixels.  Each pair is squeezed from 0RGB dwords to 6 bytes
+ * and stored with 8 bytes, so 2 bytes after the 24 are overwritten too.
+ */
+
+static inline void
+store_rgb (JSAMPROW outptr, __m64 r, __m64 g, __m64 b)
+{
+  const __m64 zero = _mm_setzero_si64();
+  const __m64 mask24 = _mm_set_pi32(0, 0x00FFFFFF);
+  const __m64 mask48 = _mm_set_pi32(0x0000FFFF, (int) 0xFF000000);
+  __m64 rg, b0, px[4];
+  int k;
+
+  rg = _mm_unpacklo_pi8(r, g);
+  b0 = _mm_unpacklo_pi8(b, zero);
+  px[0] = _mm_unpacklo_pi16(rg, b0);
+  px[1] = _mm_unpackhi_pi16(rg, b0);
+  rg = _mm_unpackhi_pi8(r, g);
+  b0 = _mm_unpackhi_pi8(b, zero);
+  px[2] = _mm_unpacklo_pi16(rg, b0);
+  px[3] = _mm_unpackhi_pi16(rg, b0);
+
+  for (k = 0; k < 4; k++)
+    *(__m64 *) (outptr + k * 2 * RGB_PIXELSIZE) =
+      _mm_or_si64(_mm_and_si64(px[k], mask24),
+		  _mm_and_si64(_mm_srli_si64(px[k], 8), mask48));
+}
+
+
+/* Add Y to the offsets of 8 pixels and store them */
+
+static inline void
+emit_rgb (JSAMPROW outptr, __m64 y,
+	  __m64 rl, __m64 gl, __m64 bl, __m64 rh, __m64 gh, __m64 bh)
+{
+  const __m64 zero = _mm_setzero_si64();
+  __m64 yl = _mm_unpacklo_pi8(y, zero);
+  __m64 yh = _mm_unpackhi_pi8(y, zero);
+
+  store_rgb(outptr,
+	    _mm_packs_pu16(_mm_add_pi16(yl, rl), _mm_add_pi16(yh, rh)),
+	    _mm_packs_pu16(_mm_add_pi16(yl, gl), _mm_add_pi16(yh, gh)),
+	    _mm_packs_pu16(_mm_add_pi16(yl, bl), _mm_add_pi16(yh, bh)));
+}
+
+
+/*
+ * YCbCr->RGB conversion of one row, 8 pixels at a time.
+ * store_rgb() overshoots by 2 bytes, so 1 more pixel must follow.
+ */
+
+GLOBAL(JDIMENSION)
+jsimd_ycc_rgb_mmx (JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+		   JSAMPROW outptr, JDIMENSION num_cols)
+{
+  const __m64 zero = _mm_setzero_si64();
+  const __m64 center = _mm_set1_pi16(CENTERJSAMPLE);
+  __m64 cb, cr, rl, gl, bl, rh, gh, bh;
+  JDIMENSION col;
+
+  for (col = 0; col + 9 <= num_cols; col += 8) {
+    cb = *(const __m64 *) (inptr1 + col);
+    cr = *(const __m64 *) (inptr2 + col);
+    chroma_offsets(_mm_sub_pi16(_mm_unpacklo_pi8(cb, zero), center),
+		   _mm_sub_pi16(_mm_unpacklo_pi8(cr, zero), center),
+		   &rl, &gl, &bl);
+    chroma_offsets(_mm_sub_pi16(_mm_unpackhi_pi8(cb, zero), center),
+		   _mm_sub_pi16(_mm_unpackhi_pi8(cr, zero), center),
+		   &rh, &gh, &bh);
+    emit_rgb(outptr, *(const __m64 *) (inptr0 + col),
+	     rl, gl, bl, rh, gh, bh);
+    outptr += 8 * RGB_PIXELSIZE;
+  }
+  _mm_empty();
+  return col;
+}
+
+
+/*
+ * Merged upsampling and conversion of one or two rows, 4 Cb/Cr samples
+ * (8 pixels per row) at a time.
+ */
+
+GLOBAL(JDIMENSION)
+jsimd_merged_mmx (JSAMPROW inptr00, JSAMPROW inptr01,
+		  JSAMPROW inptr1, JSAMPROW inptr2,
+		  JSAMPROW outptr0, JSAMPROW outptr1, JDIMENSION num_pairs)
+{
+  const __m64 zero = _mm_setzero_si64();
+  const __m64 center = _mm_set1_pi16(CENTERJSAMPLE);
+  __m64 r, g, b, rl, gl, bl, rh, gh, bh;
+  int cb, cr;
+  JDIMENSION col;
+
+  for (col = 0; col + 5 <= num_pairs; col += 4) {
+    MEMCOPY(&cb, inptr1 + col, 4);
+    MEMCOPY(&cr, inptr2 + col, 4);
+    chroma_offsets(_mm_sub_pi16(_mm_unpacklo_pi8(_mm_cvtsi32_si64(cb), zero),
+				center),
+		   _mm_sub_pi16(_mm_unpacklo_pi8(_mm_cvtsi32_si64(cr), zero),
+				center),
+		   &r, &g, &b);
+    rl = _mm_unpacklo_pi16(r, r);
+    rh = _mm_unpackhi_pi16(r, r);
+    gl = _mm_unpacklo_pi16(g, g);
+    gh = _mm_unpackhi_pi16(g, g);
+    bl = _mm_unpacklo_pi16(b, b);
+    bh = _mm_unpackhi_pi16(b, b);
+    emit_rgb(outptr0 + col * 2 * RGB_PIXELSIZE,
+	     *(const __m64 *) (inptr00 + col * 2), rl, gl, bl, rh, gh, bh);
+    if (inptr01 != NULL)
+      emit_rgb(outptr1 + col * 2 * RGB_PIXELSIZE,
+	       *(const __m64 *) (inptr01 + col * 2), rl, gl, bl, rh, gh, bh);
+  }
+  _mm_empty();
+  return col;
+}
+
+#endif /* JSIMD_SUPPORTED */
@@ -0,0 +1,184 @@
+/*
+ * jdsimd.c
+ *
+ * This file was added to the IJG software for DosView.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file selects the MMX or SSE2 kernels of jdmmx.c and jdsse2.c at
+ * run time.  The instruction set is taken from CPUID.  SSE2 is not used
+ * under DJGPP by default: plain DOS and most DPMI hosts do not enable the
+ * SSE state (CR4.OSFXSR), so SSE2 instructions would fault there, while
+ * MMX needs no help from the operating system.
+ *
+ * The environment variable JPEGSIMD overrides the choice: "none" selects
+ * the C code, "mmx" caps the level at MMX and "sse2" allows SSE2 also
+ * under DJGPP (e.g. in a Windows DOS box).  A level the CPU lacks is
+ * never used.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+#include <cpuid.h>
+#endif
+
+#ifndef NO_GETENV
+#ifndef HAVE_STDLIB_H		/* <stdlib.h> should declare getenv() */
+extern char * getenv JPP((const char * name));
+#endif
+#endif
+
+
+/*
+ * Determine the instruction set to use, once.
+ */
+
+GLOBAL(int)
+jsimd_level (void)
+{
+  static int level = -1;
+#ifdef JSIMD_SUPPORTED
+  unsigned int eax, ebx, ecx, edx;
+  int cpu = JSIMD_NONE;
+#ifndef NO_GETENV
+  char * env;
+#endif
+
+  if (level >= 0)
+    return level;
+
+  /* __get_cpuid() also checks that the CPU has CPUID at all (486 and up) */
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    if (edx & bit_MMX)
+      cpu = JSIMD_MMX;
+    if (edx & bit_SSE2)
+      cpu = JSIMD_SSE2;
+  }
+
+  level = cpu;
+#ifdef __DJGPP__
+  if (level > JSIMD_MMX)
+    level = JSIMD_MMX;
+#endif
+
+#ifndef NO_GETENV
+  if ((env = getenv("JPEGSIMD")) != NULL) {
+    if (strcmp(env, "none") == 0)
+      level = JSIMD_NONE;
+    else if (strcmp(env, "mmx") == 0)
+      level = MIN(cpu, JSIMD_MMX);
+    else if (strcmp(env, "sse2") == 0)
+      level = MIN(cpu, JSIMD_SSE2);
+  }
+#endif
+#else
+  level = JSIMD_NONE;
+#endif /* JSIMD_SUPPORTED */
+
+  return level;
+}
+
+
+#ifdef JSIMD_SUPPORTED
+
+/*
+ * The IDCT kernels load the multipliers as 16-bit words, which holds for
+ * all 8-bit quantization tables but not for every 16-bit one.
+ * A component without a table yet has an all-zero multiplier table.
+ */
+
+LOCAL(boolean)
+quant_fits_16bit (jpeg_component_info * compptr)
+{
+  JQUANT_TBL * qtbl = compptr->quant_table;
+  int i;
+
+  if (qtbl == NULL)
+    return TRUE;
+  for (i = 0; i < DCTSIZE2; i++) {
+    if (qtbl->quantval[i] > 32767)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+#endif /* JSIMD_SUPPORTED */
+
+
+/*
+ * Select the IDCT for a component: the SIMD version of the LL&M 8x8 IDCT
+ * and of the 16x16 and 16x8 IDCTs, which do the fancy upsampling of h2v2
+ * and h2v1 chroma.  Other routines are returned unchanged.
+ */
+
+GLOBAL(inverse_DCT_method_ptr)
+jsimd_idct (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	    inverse_DCT_method_ptr method_ptr)
+{
+#if defined(JSIMD_SUPPORTED) && BITS_IN_JSAMPLE == 8
+  int level = jsimd_level();
+
+  if (level == JSIMD_NONE || SIZEOF(ISLOW_MULT_TYPE) != 4 ||
+      ! quant_fits_16bit(compptr))
+    return method_ptr;
+
+  if (method_ptr == jpeg_idct_islow)
+    return level == JSIMD_SSE2 ? jsimd_idct_islow_sse2 : jsimd_idct_islow_mmx;
+  if (method_ptr == jpeg_idct_16x16)
+    return level == JSIMD_SSE2 ? jsimd_idct_16x16_sse2 : jsimd_idct_16x16_mmx;
+  if (method_ptr == jpeg_idct_16x8)
+    return level == JSIMD_SSE2 ? jsimd_idct_16x8_sse2 : jsimd_idct_16x8_mmx;
+#endif
+
+  return method_ptr;
+}
+
+
+/*
+ * Select the row converter for YCbCr->RGB (jdcolor.c) and for merged
+ * upsampling (jdmerge.c).  Both assume the standard RGB pixel layout and
+ * the standard (not bg-sYCC) YCbCr equations.
+ */
+
+GLOBAL(jsimd_ycc_rgb_ptr)
+jsimd_ycc_rgb (j_decompress_ptr cinfo)
+{
+#if defined(JSIMD_SUPPORTED) && BITS_IN_JSAMPLE == 8 && \
+    RGB_RED == 0 && RGB_GREEN == 1 && RGB_BLUE == 2 && RGB_PIXELSIZE == 3
+  if (cinfo->jpeg_color_space == JCS_YCbCr &&
+      cinfo->out_color_space == JCS_RGB) {
+    switch (jsimd_level()) {
+    case JSIMD_SSE2:
+      return jsimd_ycc_rgb_sse2;
+    case JSIMD_MMX:
+      return jsimd_ycc_rgb_mmx;
+    }
+  }
+#endif
+
+  return NULL;
+}
+
+
+GLOBAL(jsimd_merged_ptr)
+jsimd_merged (j_decompress_ptr cinfo)
+{
+#if defined(JSIMD_SUPPORTED) && BITS_IN_JSAMPLE == 8 && \
+    RGB_RED == 0 && RGB_GREEN == 1 && RGB_BLUE == 2 && RGB_PIXELSIZE == 3
+  if (cinfo->jpeg_color_space == JCS_YCbCr &&
+      cinfo->out_color_space == JCS_RGB) {
+    switch (jsimd_level()) {
+    case JSIMD_SSE2:
+      return jsimd_merged_sse2;
+    case JSIMD_MMX:
+      return jsimd_merged_mmx;
+    }
+  }
+#endif
+
+  return NULL;
+}
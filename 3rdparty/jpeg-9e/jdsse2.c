@@ -0,0 +1,572 @@
+/*
+ * jdsse2.c
+ *
+ * This file was added to the IJG software for DosView.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains SSE2 versions of the LL&M integer IDCTs of jidctint.c
+ * (jpeg_idct_islow, jpeg_idct_16x16 and jpeg_idct_16x8), of YCbCr->RGB
+ * conversion (jdcolor.c) and of merged upsampling (jdmerge.c).  jdsimd.c
+ * decides whether they are used.
+ *
+ * The IDCT works on eight columns (pass 1) or rows (pass 2) at a time.
+ * The rotations of jidctint.c are multiplied out, so that every output is
+ * a sum of products of input pairs with 16-bit constants, which PMADDWD
+ * computes exactly in 32 bits; rounding and descaling are those of the C
+ * code.  This is exact as long as the dequantized coefficients and the
+ * pass 1 results fit in 16 bits.  Blocks where they don't (which a real
+ * encoder never writes) are handed to the C routine.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#pragma GCC target("sse2")
+#include <emmintrin.h>
+
+
+/* Scaling of jidctint.c */
+
+#define CONST_BITS  13
+#define PASS1_BITS  2
+
+/* Rounding of the final shifts, added to the DC term; pass 2 also adds
+ * the range center.
+ */
+#define PASS1_BIAS  (ONE << (CONST_BITS-PASS1_BITS-1))
+#define PASS2_BIAS  ((((INT32) RANGE_CENTER << (PASS1_BITS+3)) + \
+		      (ONE << (PASS1_BITS+2))) << CONST_BITS)
+
+/* Constant pair for PMADDWD: interleaved words (x, y) give a*x + b*y */
+#define PAIR(a,b)  _mm_set_epi16(b, a, b, a, b, a, b, a)
+
+
+/*
+ * Dequantize a coefficient block: r[k] is row k.
+ * Returns nonzero words where a product does not fit in 16 bits.
+ */
+
+static inline __m128i
+dequantize (JCOEFPTR coef_block, ISLOW_MULT_TYPE * quantptr, __m128i r[8])
+{
+  __m128i err = _mm_setzero_si128();
+  __m128i c, q, lo, hi;
+  int k;
+
+  for (k = 0; k < 8; k++) {
+    c = _mm_loadu_si128((const __m128i *) (coef_block + k*DCTSIZE));
+    q = _mm_packs_epi32(
+	  _mm_loadu_si128((const __m128i *) (quantptr + k*DCTSIZE)),
+	  _mm_loadu_si128((const __m128i *) (quantptr + k*DCTSIZE + 4)));
+    lo = _mm_mullo_epi16(c, q);
+    hi = _mm_mulhi_epi16(c, q);
+    err = _mm_or_si128(err, _mm_xor_si128(hi, _mm_srai_epi16(lo, 15)));
+    r[k] = lo;
+  }
+  return err;
+}
+
+
+/*
+ * 8-point IDCT of four lanes, from the interleaved input pairs (y0,y4),
+ * (y2,y6), (y7,y5) and (y3,y1).  s[k] is output k before descaling.
+ * The odd part constants are those of jpeg_idct_islow summed up, e.g.
+ * y7 enters tmp0 with FIX_0_298631336 - FIX_0_899976223 +
+ * FIX_1_175875602 - FIX_1_961570560 = -11363.
+ */
+
+static inline void
+idct8_half (__m128i e04, __m128i e26, __m128i o75, __m128i o31,
+	    __m128i bias, __m128i s[8])
+{
+  __m128i tmp0, tmp1, tmp2, tmp3, tmp10, tmp11, tmp12, tmp13;
+
+  /* Even part */
+
+  tmp0 = _mm_add_epi32(_mm_madd_epi16(e04, PAIR(8192, 8192)), bias);
+  tmp1 = _mm_add_epi32(_mm_madd_epi16(e04, PAIR(8192, -8192)), bias);
+  tmp2 = _mm_madd_epi16(e26, PAIR(10703, 4433));
+  tmp3 = _mm_madd_epi16(e26, PAIR(4433, -10704));
+
+  tmp10 = _mm_add_epi32(tmp0, tmp2);
+  tmp13 = _mm_sub_epi32(tmp0, tmp2);
+  tmp11 = _mm_add_epi32(tmp1, tmp3);
+  tmp12 = _mm_sub_epi32(tmp1, tmp3);
+
+  /* Odd part */
+
+  tmp0 = _mm_add_epi32(_mm_madd_epi16(o75, PAIR(-11363, 9633)),
+		       _mm_madd_epi16(o31, PAIR(-6436, 2260)));
+  tmp1 = _mm_add_epi32(_mm_madd_epi16(o75, PAIR(9633, 2261)),
+		       _mm_madd_epi16(o31, PAIR(-11362, 6437)));
+  tmp2 = _mm_add_epi32(_mm_madd_epi16(o75, PAIR(-6436, -11362)),
+		       _mm_madd_epi16(o31, PAIR(-2259, 9633)));
+  tmp3 = _mm_add_epi32(_mm_madd_epi16(o75, PAIR(2260, 6437)),
+		       _mm_madd_epi16(o31, PAIR(9633, 11363)));
+
+  s[0] = _mm_add_epi32(tmp10, tmp3);
+  s[7] = _mm_sub_epi32(tmp10, tmp3);
+  s[1] = _mm_add_epi32(tmp11, tmp2);
+  s[6] = _mm_sub_epi32(tmp11, tmp2);
+  s[2] = _mm_add_epi32(tmp12, tmp1);
+  s[5] = _mm_sub_epi32(tmp12, tmp1);
+  s[3] = _mm_add_epi32(tmp13, tmp0);
+  s[4] = _mm_sub_epi32(tmp13, tmp0);
+}
+
+
+/*
+ * 16-point IDCT of four lanes (jpeg_idct_16x16), from the input pairs
+ * (y0,y4), (y2,y6), (y1,y3) and (y5,y7).
+ */
+
+static inline void
+idct16_half (__m128i e04, __m128i e26, __m128i o13, __m128i o57,
+	     __m128i bias, __m128i s[16])
+{
+  __m128i tmp0, tmp1, tmp2, tmp3, tmp10, tmp11, tmp12, tmp13;
+  __m128i tmp20, tmp21, tmp22, tmp23, tmp24, tmp25, tmp26, tmp27;
+
+  /* Even part */
+
+  tmp10 = _mm_add_epi32(_mm_madd_epi16(e04, PAIR(8192, 10703)), bias);
+  tmp11 = _mm_add_epi32(_mm_madd_epi16(e04, PAIR(8192, -10703)), bias);
+  tmp12 = _mm_add_epi32(_mm_madd_epi16(e04, PAIR(8192, 4433)), bias);
+  tmp13 = _mm_add_epi32(_mm_madd_epi16(e04, PAIR(8192, -4433)), bias);
+
+  tmp0 = _mm_madd_epi16(e26, PAIR(11363, 9632));
+  tmp1 = _mm_madd_epi16(e26, PAIR(9633, -2260));
+  tmp2 = _mm_madd_epi16(e26, PAIR(6437, -11363));
+  tmp3 = _mm_madd_epi16(e26, PAIR(2260, -6436));
+
+  tmp20 = _mm_add_epi32(tmp10, tmp0);
+  tmp27 = _mm_sub_epi32(tmp10, tmp0);
+  tmp21 = _mm_add_epi32(tmp12, tmp1);
+  tmp26 = _mm_sub_epi32(tmp12, tmp1);
+  tmp22 = _mm_add_epi32(tmp13, tmp2);
+  tmp25 = _mm_sub_epi32(tmp13, tmp2);
+  tmp23 = _mm_add_epi32(tmp11, tmp3);
+  tmp24 = _mm_sub_epi32(tmp11, tmp3);
+
+  /* Odd part */
+
+  tmp0  = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(11529, 11086)),
+			_mm_madd_epi16(o57, PAIR(10217, 8956)));
+  tmp1  = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(11086, 7350)),
+			_mm_madd_epi16(o57, PAIR(1136, -5461)));
+  tmp2  = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(10217, 1136)),
+			_mm_madd_epi16(o57, PAIR(-8955, -11086)));
+  tmp3  = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(8956, -5461)),
+			_mm_madd_epi16(o57, PAIR(-11086, 1137)));
+  tmp10 = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(7350, -10217)),
+			_mm_madd_epi16(o57, PAIR(-3363, 11529)));
+  tmp11 = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(5461, -11529)),
+			_mm_madd_epi16(o57, PAIR(7349, 3363)));
+  tmp12 = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(3363, -8955)),
+			_mm_madd_epi16(o57, PAIR(11529, -10217)));
+  tmp13 = _mm_add_epi32(_mm_madd_epi16(o13, PAIR(1136, -3363)),
+			_mm_madd_epi16(o57, PAIR(5461, -7350)));
+
+  s[0]  = _mm_add_epi32(tmp20, tmp0);
+  s[15] = _mm_sub_epi32(tmp20, tmp0);
+  s[1]  = _mm_add_epi32(tmp21, tmp1);
+  s[14] = _mm_sub_epi32(tmp21, tmp1);
+  s[2]  = _mm_add_epi32(tmp22, tmp2);
+  s[13] = _mm_sub_epi32(tmp22, tmp2);
+  s[3]  = _mm_add_epi32(tmp23, tmp3);
+  s[12] = _mm_sub_epi32(tmp23, tmp3);
+  s[4]  = _mm_add_epi32(tmp24, tmp10);
+  s[11] = _mm_sub_epi32(tmp24, tmp10);
+  s[5]  = _mm_add_epi32(tmp25, tmp11);
+  s[10] = _mm_sub_epi32(tmp25, tmp11);
+  s[6]  = _mm_add_epi32(tmp26, tmp12);
+  s[9]  = _mm_sub_epi32(tmp26, tmp12);
+  s[7]  = _mm_add_epi32(tmp27, tmp13);
+  s[8]  = _mm_sub_epi32(tmp27, tmp13);
+}
+
+
+/* The IDCTs of all eight lanes of in[]: lo[] for lanes 0-3, hi[] for 4-7 */
+
+static inline void
+idct8 (const __m128i in[8], INT32 bias, __m128i lo[8], __m128i hi[8])
+{
+  __m128i b = _mm_set1_epi32(bias);
+
+  idct8_half(_mm_unpacklo_epi16(in[0], in[4]), _mm_unpacklo_epi16(in[2], in[6]),
+	     _mm_unpacklo_epi16(in[7], in[5]), _mm_unpacklo_epi16(in[3], in[1]),
+	     b, lo);
+  idct8_half(_mm_unpackhi_epi16(in[0], in[4]), _mm_unpackhi_epi16(in[2], in[6]),
+	     _mm_unpackhi_epi16(in[7], in[5]), _mm_unpackhi_epi16(in[3], in[1]),
+	     b, hi);
+}
+
+static inline void
+idct16 (const __m128i in[8], INT32 bias, __m128i lo[16], __m128i hi[16])
+{
+  __m128i b = _mm_set1_epi32(bias);
+
+  idct16_half(_mm_unpacklo_epi16(in[0], in[4]), _mm_unpacklo_epi16(in[2], in[6]),
+	      _mm_unpacklo_epi16(in[1], in[3]), _mm_unpacklo_epi16(in[5], in[7]),
+	      b, lo);
+  idct16_half(_mm_unpackhi_epi16(in[0], in[4]), _mm_unpackhi_epi16(in[2], in[6]),
+	      _mm_unpackhi_epi16(in[1], in[3]), _mm_unpackhi_epi16(in[5], in[7]),
+	      b, hi);
+}
+
+
+/*
+ * Descale pass 1 results to words; *err collects a value whose upper
+ * half is nonzero if one of them does not fit.
+ */
+
+static inline __m128i
+descale_pass1 (__m128i lo, __m128i hi, __m128i * err)
+{
+  const __m128i half = _mm_set1_epi32(0x8000);
+
+  lo = _mm_srai_epi32(lo, CONST_BITS-PASS1_BITS);
+  hi = _mm_srai_epi32(hi, CONST_BITS-PASS1_BITS);
+  *err = _mm_or_si128(*err, _mm_or_si128(_mm_add_epi32(lo, half),
+					 _mm_add_epi32(hi, half)));
+  return _mm_packs_epi32(lo, hi);
+}
+
+
+/*
+ * Descale pass 2 results to words.  Masking and subtracting RANGE_SUBSET
+ * and then saturating to bytes does what IDCT_range_limit() does.
+ */
+
+static inline __m128i
+descale_pass2 (__m128i lo, __m128i hi)
+{
+  const __m128i mask = _mm_set1_epi32(RANGE_MASK);
+  const __m128i subset = _mm_set1_epi32(RANGE_SUBSET);
+
+  lo = _mm_srai_epi32(lo, CONST_BITS+PASS1_BITS+3);
+  hi = _mm_srai_epi32(hi, CONST_BITS+PASS1_BITS+3);
+  lo = _mm_sub_epi32(_mm_and_si128(lo, mask), subset);
+  hi = _mm_sub_epi32(_mm_and_si128(hi, mask), subset);
+  return _mm_packs_epi32(lo, hi);
+}
+
+
+static inline boolean
+all_zero (__m128i x)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) == 0xFFFF;
+}
+
+
+/* Transpose an 8x8 matrix of words */
+
+static inline void
+transpose8 (__m128i v[8])
+{
+  __m128i a0, a1, a2, a3, a4, a5, a6, a7;
+  __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+  a0 = _mm_unpacklo_epi16(v[0], v[1]);
+  a1 = _mm_unpackhi_epi16(v[0], v[1]);
+  a2 = _mm_unpacklo_epi16(v[2], v[3]);
+  a3 = _mm_unpackhi_epi16(v[2], v[3]);
+  a4 = _mm_unpacklo_epi16(v[4], v[5]);
+  a5 = _mm_unpackhi_epi16(v[4], v[5]);
+  a6 = _mm_unpacklo_epi16(v[6], v[7]);
+  a7 = _mm_unpackhi_epi16(v[6], v[7]);
+
+  b0 = _mm_unpacklo_epi32(a0, a2);
+  b1 = _mm_unpackhi_epi32(a0, a2);
+  b2 = _mm_unpacklo_epi32(a1, a3);
+  b3 = _mm_unpackhi_epi32(a1, a3);
+  b4 = _mm_unpacklo_epi32(a4, a6);
+  b5 = _mm_unpackhi_epi32(a4, a6);
+  b6 = _mm_unpacklo_epi32(a5, a7);
+  b7 = _mm_unpackhi_epi32(a5, a7);
+
+  v[0] = _mm_unpacklo_epi64(b0, b4);
+  v[1] = _mm_unpackhi_epi64(b0, b4);
+  v[2] = _mm_unpacklo_epi64(b1, b5);
+  v[3] = _mm_unpackhi_epi64(b1, b5);
+  v[4] = _mm_unpacklo_epi64(b2, b6);
+  v[5] = _mm_unpackhi_epi64(b2, b6);
+  v[6] = _mm_unpacklo_epi64(b3, b7);
+  v[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+
+/*
+ * Pass 1 of all IDCTs: process the columns of the block into ws[] (row k
+ * of the work array in ws[k]).  Returns FALSE if the block is not exact
+ * in 16 bits.
+ */
+
+static inline boolean
+pass1 (jpeg_component_info * compptr, JCOEFPTR coef_block,
+       __m128i ws[], int rows)
+{
+  __m128i in[8], lo[16], hi[16];
+  __m128i err2 = _mm_setzero_si128();
+  __m128i err1;
+  int k;
+
+  err1 = dequantize(coef_block, (ISLOW_MULT_TYPE *) compptr->dct_table, in);
+  if (rows == 16)
+    idct16(in, PASS1_BIAS, lo, hi);
+  else
+    idct8(in, PASS1_BIAS, lo, hi);
+  for (k = 0; k < rows; k++)
+    ws[k] = descale_pass1(lo[k], hi[k], &err2);
+  return all_zero(_mm_or_si128(err1, _mm_srli_epi32(err2, 16)));
+}
+
+
+/*
+ * Pass 2 of all IDCTs: process eight rows of the work array (transposed
+ * in place) and store 8 or 16 samples of each.
+ */
+
+static inline void
+pass2 (__m128i ws[8], int cols, JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i lo[16], hi[16], out[16];
+  __m128i px;
+  int k;
+
+  transpose8(ws);
+  if (cols == 16) {
+    idct16(ws, PASS2_BIAS, lo, hi);
+    for (k = 0; k < 16; k++)
+      out[k] = descale_pass2(lo[k], hi[k]);
+    transpose8(out);
+    transpose8(out + 8);
+    for (k = 0; k < 8; k++)
+      _mm_storeu_si128((__m128i *) (output_buf[k] + output_col),
+		       _mm_packus_epi16(out[k], out[k + 8]));
+  } else {
+    idct8(ws, PASS2_BIAS, lo, hi);
+    for (k = 0; k < 8; k++)
+      out[k] = descale_pass2(lo[k], hi[k]);
+    transpose8(out);
+    for (k = 0; k < 8; k += 2) {
+      px = _mm_packus_epi16(out[k], out[k + 1]);
+      _mm_storel_epi64((__m128i *) (output_buf[k] + output_col), px);
+      _mm_storel_epi64((__m128i *) (output_buf[k + 1] + output_col),
+		       _mm_unpackhi_epi64(px, px));
+    }
+  }
+}
+
+
+/*
+ * The IDCT routines.
+ */
+
+GLOBAL(void)
+jsimd_idct_islow_sse2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		       JCOEFPTR coef_block,
+		       JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i ws[8];
+
+  if (! pass1(compptr, coef_block, ws, 8)) {
+    jpeg_idct_islow(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  pass2(ws, 8, output_buf, output_col);
+}
+
+
+GLOBAL(void)
+jsimd_idct_16x16_sse2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		       JCOEFPTR coef_block,
+		       JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i ws[16];
+
+  if (! pass1(compptr, coef_block, ws, 16)) {
+    jpeg_idct_16x16(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  pass2(ws, 16, output_buf, output_col);
+  pass2(ws + 8, 16, output_buf + 8, output_col);
+}
+
+
+GLOBAL(void)
+jsimd_idct_16x8_sse2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i ws[8];
+
+  if (! pass1(compptr, coef_block, ws, 8)) {
+    jpeg_idct_16x8(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  pass2(ws, 16, output_buf, output_col);
+}
+
+
+/*
+ * R, G and B offsets of eight centered Cb/Cr values (words), computed as
+ * jdcolor.c's tables do with FIX(1.402) = 65536 + 26345, FIX(1.772) =
+ * 131072 - 14942, FIX(0.714136286) = 65536 - 18734 and FIX(0.344136286) =
+ * 22553.  (c * x + ONE_HALF) >> 16 of a 16-bit c is the high word of the
+ * product plus the top bit of the low word.
+ */
+
+static inline void
+chroma_offsets (__m128i cb, __m128i cr, __m128i * r, __m128i * g, __m128i * b)
+{
+  const __m128i kr = _mm_set1_epi16(26345);
+  const __m128i kb = _mm_set1_epi16(-14942);
+  const __m128i one_half = _mm_set1_epi32(32768);
+  __m128i lo, hi;
+
+  *r = _mm_add_epi16(cr,
+		     _mm_add_epi16(_mm_mulhi_epi16(cr, kr),
+				   _mm_srli_epi16(_mm_mullo_epi16(cr, kr), 15)));
+  *b = _mm_add_epi16(_mm_add_epi16(cb, cb),
+		     _mm_add_epi16(_mm_mulhi_epi16(cb, kb),
+				   _mm_srli_epi16(_mm_mullo_epi16(cb, kb), 15)));
+  lo = _mm_madd_epi16(_mm_unpacklo_epi16(cb, cr), PAIR(-22553, 18734));
+  hi = _mm_madd_epi16(_mm_unpackhi_epi16(cb, cr), PAIR(-22553, 18734));
+  lo = _mm_srai_epi32(_mm_add_epi32(lo, one_half), 16);
+  hi = _mm_srai_epi32(_mm_add_epi32(hi, one_half), 16);
+  *g = _mm_sub_epi16(_mm_packs_epi32(lo, hi), cr);
+}
+
+
+/*
+ * Store 16 RGB pixels.  Each group of four is squeezed from 0RGB dwords
+ * to 12 bytes and stored with 16 bytes, so 4 bytes after the 48 are
+ * overwritten too.
+ */
+
+static inline void
+store_rgb (JSAMPROW outptr, __m128i r, __m128i g, __m128i b)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask24 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+  const __m128i mask48 = _mm_set_epi32(0x0000FFFF, (int) 0xFF000000,
+				       0x0000FFFF, (int) 0xFF000000);
+  const __m128i lane0 = _mm_set_epi32(0, 0, -1, -1);
+  const __m128i lane1 = _mm_set_epi32(-1, -1, 0, 0);
+  __m128i rg, b0, px[4], q;
+  int k;
+
+  rg = _mm_unpacklo_epi8(r, g);
+  b0 = _mm_unpacklo_epi8(b, zero);
+  px[0] = _mm_unpacklo_epi16(rg, b0);
+  px[1] = _mm_unpackhi_epi16(rg, b0);
+  rg = _mm_unpackhi_epi8(r, g);
+  b0 = _mm_unpackhi_epi8(b, zero);
+  px[2] = _mm_unpacklo_epi16(rg, b0);
+  px[3] = _mm_unpackhi_epi16(rg, b0);
+
+  for (k = 0; k < 4; k++) {
+    /* two pixels to 6 bytes in each quadword, then the quadwords */
+    q = _mm_or_si128(_mm_and_si128(px[k], mask24),
+		     _mm_and_si128(_mm_srli_epi64(px[k], 8), mask48));
+    q = _mm_or_si128(_mm_and_si128(q, lane0),
+		     _mm_srli_si128(_mm_and_si128(q, lane1), 2));
+    _mm_storeu_si128((__m128i *) (outptr + k * 4 * RGB_PIXELSIZE), q);
+  }
+}
+
+
+/* Add Y to the offsets of 16 pixels and store them */
+
+static inline void
+emit_rgb (JSAMPROW outptr, __m128i y,
+	  __m128i rl, __m128i gl, __m128i bl,
+	  __m128i rh, __m128i gh, __m128i bh)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i yl = _mm_unpacklo_epi8(y, zero);
+  __m128i yh = _mm_unpackhi_epi8(y, zero);
+
+  store_rgb(outptr,
+	    _mm_packus_epi16(_mm_add_epi16(yl, rl), _mm_add_epi16(yh, rh)),
+	    _mm_packus_epi16(_mm_add_epi16(yl, gl), _mm_add_epi16(yh, gh)),
+	    _mm_packus_epi16(_mm_add_epi16(yl, bl), _mm_add_epi16(yh, bh)));
+}
+
+
+/*
+ * YCbCr->RGB conversion of one row, 16 pixels at a time.
+ * store_rgb() overshoots by 4 bytes, so 2 more pixels must follow.
+ */
+
+GLOBAL(JDIMENSION)
+jsimd_ycc_rgb_sse2 (JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+		    JSAMPROW outptr, JDIMENSION num_cols)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i center = _mm_set1_epi16(CENTERJSAMPLE);
+  __m128i cb, cr, rl, gl, bl, rh, gh, bh;
+  JDIMENSION col;
+
+  for (col = 0; col + 18 <= num_cols; col += 16) {
+    cb = _mm_loadu_si128((const __m128i *) (inptr1 + col));
+    cr = _mm_loadu_si128((const __m128i *) (inptr2 + col));
+    chroma_offsets(_mm_sub_epi16(_mm_unpacklo_epi8(cb, zero), center),
+		   _mm_sub_epi16(_mm_unpacklo_epi8(cr, zero), center),
+		   &rl, &gl, &bl);
+    chroma_offsets(_mm_sub_epi16(_mm_unpackhi_epi8(cb, zero), center),
+		   _mm_sub_epi16(_mm_unpackhi_epi8(cr, zero), center),
+		   &rh, &gh, &bh);
+    emit_rgb(outptr, _mm_loadu_si128((const __m128i *) (inptr0 + col)),
+	     rl, gl, bl, rh, gh, bh);
+    outptr += 16 * RGB_PIXELSIZE;
+  }
+  return col;
+}
+
+
+/*
+ * Merged upsampling and conversion of one or two rows, 8 Cb/Cr samples
+ * (16 pixels per row) at a time.
+ */
+
+GLOBAL(JDIMENSION)
+jsimd_merged_sse2 (JSAMPROW inptr00, JSAMPROW inptr01,
+		   JSAMPROW inptr1, JSAMPROW inptr2,
+		   JSAMPROW outptr0, JSAMPROW outptr1, JDIMENSION num_pairs)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i center = _mm_set1_epi16(CENTERJSAMPLE);
+  __m128i cb, cr, r, g, b, rl, gl, bl, rh, gh, bh;
+  JDIMENSION col;
+
+  for (col = 0; col + 9 <= num_pairs; col += 8) {
+    cb = _mm_loadl_epi64((const __m128i *) (inptr1 + col));
+    cr = _mm_loadl_epi64((const __m128i *) (inptr2 + col));
+    chroma_offsets(_mm_sub_epi16(_mm_unpacklo_epi8(cb, zero), center),
+		   _mm_sub_epi16(_mm_unpacklo_epi8(cr, zero), center),
+		   &r, &g, &b);
+    rl = _mm_unpacklo_epi16(r, r);
+    rh = _mm_unpackhi_epi16(r, r);
+    gl = _mm_unpacklo_epi16(g, g);
+    gh = _mm_unpackhi_epi16(g, g);
+    bl = _mm_unpacklo_epi16(b, b);
+    bh = _mm_unpackhi_epi16(b, b);
+    emit_rgb(outptr0 + col * 2 * RGB_PIXELSIZE,
+	     _mm_loadu_si128((const __m128i *) (inptr00 + col * 2)),
+	     rl, gl, bl, rh, gh, bh);
+    if (inptr01 != NULL)
+      emit_rgb(outptr1 + col * 2 * RGB_PIXELSIZE,
+	       _mm_loadu_si128((const __m128i *) (inptr01 + col * 2)),
+	       rl, gl, bl, rh, gh, bh);
+  }
+  return col;
+}
+
+#endif /* JSIMD_SUPPORTED */
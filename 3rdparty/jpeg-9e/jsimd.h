@@ -0,0 +1,118 @@
+/*
+ * jsimd.h
+ *
+ * This file was added to the IJG software for DosView.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file declares the MMX and SSE2 versions of the decompressor's
+ * hottest routines (jdmmx.c, jdsse2.c) and the functions that pick them
+ * at run time (jdsimd.c).  Every kernel produces exactly the samples of
+ * the C routine it replaces and hands over to the C code wherever that
+ * cannot be guaranteed, e.g. for coefficients that overflow 16 bits.
+ */
+
+
+/* The kernels need GCC's x86 intrinsics and target pragmas (GCC 4.9 on). */
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#if (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    !defined(__clang__) && !defined(NO_JSIMD)
+#define JSIMD_SUPPORTED
+#endif
+#endif
+
+
+/* Instruction set levels, see jsimd_level() */
+
+#define JSIMD_NONE	0
+#define JSIMD_MMX	1
+#define JSIMD_SSE2	2
+
+
+/* A row converter does as many leading columns as it can (a multiple of
+ * its vector width) and returns their number; the caller's C loop
+ * converts the rest.  The merged upsampler counts Cb/Cr samples, i.e.
+ * pairs of output pixels; inptr01 and outptr1 are NULL for h2v1.
+ */
+
+typedef JDIMENSION (*jsimd_ycc_rgb_ptr)
+    JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	 JSAMPROW outptr, JDIMENSION num_cols));
+typedef JDIMENSION (*jsimd_merged_ptr)
+    JPP((JSAMPROW inptr00, JSAMPROW inptr01,
+	 JSAMPROW inptr1, JSAMPROW inptr2,
+	 JSAMPROW outptr0, JSAMPROW outptr1, JDIMENSION num_pairs));
+
+
+/* Short forms of external names for systems with brain-damaged linkers. */
+
+#ifdef NEED_SHORT_EXTERNAL_NAMES
+#define jsimd_level		jSlevel
+#define jsimd_idct		jSidct
+#define jsimd_ycc_rgb		jSyccrgb
+#define jsimd_merged		jSmerged
+#define jsimd_idct_islow_mmx	jSMislow
+#define jsimd_idct_16x16_mmx	jSM16x16
+#define jsimd_idct_16x8_mmx	jSM16x8
+#define jsimd_ycc_rgb_mmx	jSMyccrgb
+#define jsimd_merged_mmx	jSMmerged
+#define jsimd_idct_islow_sse2	jSSislow
+#define jsimd_idct_16x16_sse2	jSS16x16
+#define jsimd_idct_16x8_sse2	jSS16x8
+#define jsimd_ycc_rgb_sse2	jSSyccrgb
+#define jsimd_merged_sse2	jSSmerged
+#endif /* NEED_SHORT_EXTERNAL_NAMES */
+
+
+/* Selection: these return the routine to use, which is the C one (or NULL
+ * for the row converters) if no SIMD version applies.
+ */
+
+EXTERN(int) jsimd_level JPP((void));
+EXTERN(inverse_DCT_method_ptr) jsimd_idct
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 inverse_DCT_method_ptr method_ptr));
+EXTERN(jsimd_ycc_rgb_ptr) jsimd_ycc_rgb JPP((j_decompress_ptr cinfo));
+EXTERN(jsimd_merged_ptr) jsimd_merged JPP((j_decompress_ptr cinfo));
+
+#ifdef JSIMD_SUPPORTED
+
+/* MMX kernels (Pentium MMX and up) */
+
+EXTERN(void) jsimd_idct_islow_mmx
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x16_mmx
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x8_mmx
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(JDIMENSION) jsimd_ycc_rgb_mmx
+    JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	 JSAMPROW outptr, JDIMENSION num_cols));
+EXTERN(JDIMENSION) jsimd_merged_mmx
+    JPP((JSAMPROW inptr00, JSAMPROW inptr01,
+	 JSAMPROW inptr1, JSAMPROW inptr2,
+	 JSAMPROW outptr0, JSAMPROW outptr1, JDIMENSION num_pairs));
+
+/* SSE2 kernels (Pentium 4 and up, all x86-64 CPUs) */
+
+EXTERN(void) jsimd_idct_islow_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x16_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x8_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(JDIMENSION) jsimd_ycc_rgb_sse2
+    JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	 JSAMPROW outptr, JDIMENSION num_cols));
+EXTERN(JDIMENSION) jsimd_merged_sse2
+    JPP((JSAMPROW inptr00, JSAMPROW inptr01,
+	 JSAMPROW inptr1, JSAMPROW inptr2,
+	 JSAMPROW outptr0, JSAMPROW outptr1, JDIMENSION num_pairs));
+
+#endif /* JSIMD_SUPPORTED */
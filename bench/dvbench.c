@@ -0,0 +1,627 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Codec benchmark for the Linux host build (see Makefile.linux).
+ *
+ * Every image is loaded, then saved in each output format (lossy formats at several quality levels) and the result is
+ * decoded again. Synthetic images up to 8K are measured the same way. For every step the fastest of several runs,
+ * the throughput, the peak heap and the output size are reported. The results can be written as JSON baseline and a
+ * later run can be compared against it.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "main.h"
+#include "util.h"
+#include "sniff.h"
+#include "alpng.h"
+#include "algif.h"
+#include "format-gif.h"
+#include "format-qoi.h"
+#include "format-webp.h"
+#include "format-jpeg.h"
+#include "format-tiff.h"
+#include "format-jasper.h"
+#include "format-stb.h"
+#include "tilestore.h"
+#include "stats.h"
+#include "loader.h"
+
+/************
+** defines **
+************/
+#define BN_MIN_TIME 200000          //!< a measurement is repeated at least this long [us]
+#define BN_MAX_RESULTS 4096         //!< results kept for the comparison with a baseline
+#define BN_DEFAULT_FORMATS "BMP,PCX,TGA,PNG,GIF,QOI,WEB,JPG,TIF,JP2,PPM"
+#define BN_DEFAULT_QUALITIES "50,75,95"
+
+/************
+** structs **
+************/
+//! one measurement
+typedef struct __bn_result {
+    char image[256];  //!< the source image
+    char op[8];       //!< "load", "encode" or "decode"
+    char format[8];   //!< file format
+    int quality;      //!< quality level or -1 for lossless formats
+    int width;        //!< image width
+    int height;       //!< image height
+    double ms;        //!< fastest run [ms]
+    size_t heap;      //!< peak heap during the run [bytes]
+    uint64_t size;    //!< size of the file [bytes]
+} bn_result_t;
+
+//! an output format
+typedef struct __bn_format {
+    const char *format;  //!< name as used by sniff.c
+    const char *ext;     //!< extension used for saving
+    bool lossy;          //!< quality levels apply
+} bn_format_t;
+
+/************
+** globals **
+************/
+int output_quality = 95;
+int load_depth = 32;
+int load_shrink = 1;
+tile_store_t *load_tiles = NULL;
+bool load_preview = false;
+int load_quality = LOAD_NORMAL;
+bool (*load_scan)(BITMAP *bm, RGB *pal, bool temporary) = NULL;
+bool (*load_progress)(uint32_t done, uint32_t total) = NULL;
+
+static int bn_runs = 3;                     //!< runs per measurement
+static char bn_tmp[256];                    //!< file the encoders write to
+static bn_result_t bn_results[BN_MAX_RESULTS];  //!< all measurements
+static int bn_num_results;                  //!< number of measurements
+static const char *bn_jpeg_qualities = "";  //!< JPEG decoding qualities measured besides normal (-j)
+
+static const bn_format_t bn_formats[] = {
+    {"BMP", "bmp", false}, {"PCX", "pcx", false}, {"TGA", "tga", false}, {"PNG", "png", false},
+    {"GIF", "gif", false}, {"QOI", "qoi", false}, {"WEB", "web", true},  {"JPG", "jpg", true},
+    {"TIF", "tif", false}, {"JP2", "jp2", true},  {"PPM", "ppm", false}, {NULL, NULL, false},
+};
+
+static const int bn_sizes[][2] = {{640, 480}, {1920, 1080}, {3840, 2160}, {7680, 4320}, {0, 0}};  //!< synthetic images
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief print usage info and exit.
+ */
+static void bn_usage(void) {
+    fputs("Usage: dvbench [options] [<file or directory>...]\n", stderr);
+    fputs("  -o <file> : write the results as JSON baseline.\n", stderr);
+    fputs("  -c <file> : compare the results with a baseline written by -o.\n", stderr);
+    fputs("  -t <pct>  : only report differences above this many percent, default 10.\n", stderr);
+    fputs("  -n <runs> : runs per measurement, the fastest one counts, default 3.\n", stderr);
+    fputs("  -f <list> : output formats, default " BN_DEFAULT_FORMATS ".\n", stderr);
+    fputs("  -q <list> : quality levels of lossy formats, default " BN_DEFAULT_QUALITIES ".\n", stderr);
+    fputs("  -s <w>    : width of the largest synthetic image, default 7680 (0 for none).\n", stderr);
+    fputs("  -j <list> : also decode JPEGs with these qualities (fast,best), reported as JPG:f and JPG:b.\n", stderr);
+    fputs("  -d <bpp>  : color depth to load to, default 32.\n", stderr);
+    fputs("Without files all images in 'images' are used.\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief check if a name is in a comma separated list.
+ *
+ * @param list the list.
+ * @param name the name.
+ *
+ * @return true if it is in the list.
+ */
+static bool bn_in_list(const char *list, const char *name) {
+    size_t len = strlen(name);
+    for (const char *s = list; s; s = strchr(s, ',') ? strchr(s, ',') + 1 : NULL) {
+        if (!strncasecmp(s, name, len) && ((s[len] == ',') || (s[len] == 0))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief size of a file.
+ *
+ * @param name the file.
+ *
+ * @return size in bytes, 0 if it does not exist.
+ */
+static uint64_t bn_file_size(const char *name) {
+    struct stat st;
+    return stat(name, &st) ? 0 : st.st_size;
+}
+
+/**
+ * @brief compare two file names for qsort().
+ */
+static int bn_compare_names(const void *a, const void *b) { return strcmp(*(char *const *)a, *(char *const *)b); }
+
+/**
+ * @brief add the images in a directory to the list.
+ *
+ * @param dir the directory.
+ * @param files the list.
+ * @param num number of entries in the list.
+ *
+ * @return the list.
+ */
+static char **bn_scan_dir(const char *dir, char **files, int *num) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "Can't open %s: %s\n", dir, strerror(errno));
+        return files;
+    }
+
+    int first = *num;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        char *name = malloc(strlen(dir) + strlen(de->d_name) + 2);
+        sprintf(name, "%s/%s", dir, de->d_name);
+        sniff_t s;
+        if (!sn_sniff(name, &s) || !sn_loader(s.format)) {
+            free(name);
+            continue;
+        }
+        files = realloc(files, (*num + 1) * sizeof(char *));
+        files[(*num)++] = name;
+    }
+    closedir(d);
+
+    qsort(&files[first], *num - first, sizeof(char *), bn_compare_names);
+    return files;
+}
+
+/**
+ * @brief store a measurement and print it.
+ *
+ * @param image the source image.
+ * @param op "load", "encode" or "decode".
+ * @param format file format.
+ * @param quality quality level or -1.
+ * @param bm the image (for its size).
+ * @param us fastest run [us].
+ * @param heap peak heap [bytes].
+ * @param size file size [bytes].
+ */
+static void bn_add(const char *image, const char *op, const char *format, int quality, BITMAP *bm, uint64_t us, size_t heap, uint64_t size) {
+    if (bn_num_results >= BN_MAX_RESULTS) {
+        return;
+    }
+    bn_result_t *r = &bn_results[bn_num_results++];
+    snprintf(r->image, sizeof(r->image), "%s", image);
+    snprintf(r->op, sizeof(r->op), "%s", op);
+    snprintf(r->format, sizeof(r->format), "%s", format);
+    r->quality = quality;
+    r->width = bm->w;
+    r->height = bm->h;
+    r->ms = us / 1000.0;
+    r->heap = heap;
+    r->size = size;
+
+    char q[12] = "-";
+    if (quality >= 0) {
+        snprintf(q, sizeof(q), "%d", quality);
+    }
+    double mpix = (double)r->width * r->height / MAX(us, 1);
+    printf("%-32s %-6s %-3s %3s %5dx%-5d %10.3f ms %8.2f MPix/s %10lu heap %10lu bytes\n", r->image, r->op, r->format, q, r->width, r->height,
+           r->ms, mpix, (unsigned long)r->heap, (unsigned long)r->size);
+    fflush(stdout);
+}
+
+/**
+ * @brief load an image several times and measure the fastest run.
+ *
+ * @param name the file.
+ * @param pal returns the palette.
+ * @param us returns the fastest run [us].
+ * @param heap returns the peak heap [bytes].
+ *
+ * @return the image of the last run or NULL.
+ */
+static BITMAP *bn_load(const char *name, RGB *pal, uint64_t *us, size_t *heap) {
+    BITMAP *bm = NULL;
+    uint64_t total = 0;
+
+    *us = UINT64_MAX;
+    *heap = 0;
+    for (int i = 0; (i < bn_runs) || (total < BN_MIN_TIME && i < 10 * bn_runs); i++) {
+        if (bm) {
+            destroy_bitmap(bm);
+        }
+        size_t base = st_heap_current();
+        st_heap_reset_peak();
+        uint64_t start = ut_time_us();
+        bm = sn_load(name, pal);
+        uint64_t t = ut_time_us() - start;
+        if (!bm) {
+            return NULL;
+        }
+        total += t;
+        *us = MIN(*us, t);
+        *heap = MAX(*heap, st_heap_peak() - base);
+    }
+    return bm;
+}
+
+/**
+ * @brief load a JPEG with the other decoding qualities selected by -j and measure them like bn_load().
+ *
+ * @param image name of the image for the report.
+ * @param op "load" or "decode".
+ * @param name the file.
+ * @param quality quality level the file was saved with or -1.
+ * @param size file size [bytes].
+ */
+static void bn_load_qualities(const char *image, const char *op, const char *name, int quality, uint64_t size) {
+    for (int q = LOAD_FAST; q <= LOAD_BEST; q++) {
+        if ((q == LOAD_NORMAL) || !bn_in_list(bn_jpeg_qualities, ld_quality_name(q))) {
+            continue;
+        }
+        uint64_t us;
+        size_t heap;
+        PALETTE pal;
+        char format[8];
+        snprintf(format, sizeof(format), "JPG:%c", ld_quality_name(q)[0]);
+
+        load_quality = q;
+        BITMAP *bm = bn_load(name, pal, &us, &heap);
+        load_quality = LOAD_NORMAL;
+        if (bm) {
+            bn_add(image, op, format, quality, bm, us, heap, size);
+            destroy_bitmap(bm);
+        }
+    }
+}
+
+/**
+ * @brief save an image several times and measure the fastest run.
+ *
+ * @param bm the image.
+ * @param pal its palette.
+ * @param us returns the fastest run [us].
+ * @param heap returns the peak heap [bytes].
+ *
+ * @return true for success.
+ */
+static bool bn_save(BITMAP *bm, RGB *pal, uint64_t *us, size_t *heap) {
+    uint64_t total = 0;
+
+    *us = UINT64_MAX;
+    *heap = 0;
+    for (int i = 0; (i < bn_runs) || (total < BN_MIN_TIME && i < 10 * bn_runs); i++) {
+        size_t base = st_heap_current();
+        st_heap_reset_peak();
+        uint64_t start = ut_time_us();
+        int ret = save_bitmap(bn_tmp, bm, pal);
+        uint64_t t = ut_time_us() - start;
+        if (ret != 0) {
+            return false;
+        }
+        total += t;
+        *us = MIN(*us, t);
+        *heap = MAX(*heap, st_heap_peak() - base);
+    }
+    return true;
+}
+
+/**
+ * @brief save an image in all selected formats and decode the results again.
+ *
+ * @param image name of the image for the report.
+ * @param bm the image.
+ * @param pal its palette.
+ * @param formats selected formats.
+ * @param qualities quality levels of lossy formats.
+ */
+static void bn_roundtrip(const char *image, BITMAP *bm, RGB *pal, const char *formats, const char *qualities) {
+    uint64_t us;
+    size_t heap;
+
+    for (int f = 0; bn_formats[f].format; f++) {
+        if (!bn_in_list(formats, bn_formats[f].format)) {
+            continue;
+        }
+        snprintf(bn_tmp, sizeof(bn_tmp), "%s/dvbench.%s", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp", bn_formats[f].ext);
+
+        const char *q = bn_formats[f].lossy ? qualities : NULL;
+        do {
+            int quality = q ? atoi(q) : -1;
+            output_quality = q ? quality : 95;
+            if (!bn_save(bm, pal, &us, &heap)) {
+                fprintf(stderr, "%s: saving as %s failed\n", image, bn_formats[f].format);
+                break;
+            }
+            uint64_t size = bn_file_size(bn_tmp);
+            bn_add(image, "encode", bn_formats[f].format, quality, bm, us, heap, size);
+
+            PALETTE tmp_pal;
+            BITMAP *dec = bn_load(bn_tmp, tmp_pal, &us, &heap);
+            if (dec) {
+                bn_add(image, "decode", bn_formats[f].format, quality, dec, us, heap, size);
+                destroy_bitmap(dec);
+                if (!strcmp(bn_formats[f].format, "JPG")) {
+                    bn_load_qualities(image, "decode", bn_tmp, quality, size);
+                }
+            } else {
+                fprintf(stderr, "%s: decoding %s failed\n", image, bn_formats[f].format);
+            }
+            q = (q && strchr(q, ',')) ? strchr(q, ',') + 1 : NULL;
+        } while (q);
+        remove(bn_tmp);
+    }
+}
+
+/**
+ * @brief create a synthetic test image: smooth gradients, hard edges and fine detail.
+ *
+ * @param w width.
+ * @param h height.
+ *
+ * @return the 32bpp image or NULL.
+ */
+static BITMAP *bn_synthetic(int w, int h) {
+    BITMAP *bm = create_bitmap_ex(32, w, h);
+    if (!bm) {
+        return NULL;
+    }
+    uint32_t seed = 1;
+    for (int y = 0; y < h; y++) {
+        uint32_t *row = (uint32_t *)bm->line[y];
+        for (int x = 0; x < w; x++) {
+            seed = seed * 1103515245 + 12345;
+            int r = x * 255 / w;
+            int g = y * 255 / h;
+            int b = (((x / 64) ^ (y / 64)) & 1) ? 200 : 40;
+            if ((x + y) % (w / 4 + 1) < w / 16) {
+                // a band of noise, the worst case for every codec
+                r = (r + (seed >> 24)) & 0xFF;
+                g = (g + (seed >> 16)) & 0xFF;
+            }
+            row[x] = makecol32(r, g, b);
+        }
+    }
+    return bm;
+}
+
+/**
+ * @brief write all results as JSON, one result per line so baselines can be diffed.
+ *
+ * @param name the file.
+ */
+static void bn_write_json(const char *name) {
+    FILE *f = fopen(name, "w");
+    if (!f) {
+        fprintf(stderr, "Can't write %s: %s\n", name, strerror(errno));
+        return;
+    }
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(f, "{\"date\":\"%s\",\"compiler\":\"%s\",\"runs\":%d,\"results\":[\n", date, __VERSION__, bn_runs);
+    for (int i = 0; i < bn_num_results; i++) {
+        bn_result_t *r = &bn_results[i];
+        fprintf(f, "{\"image\":\"%s\",\"op\":\"%s\",\"format\":\"%s\",\"quality\":", r->image, r->op, r->format);
+        if (r->quality >= 0) {
+            fprintf(f, "%d", r->quality);
+        } else {
+            fputs("null", f);
+        }
+        fprintf(f, ",\"width\":%d,\"height\":%d,\"ms\":%.3f,\"mpix_per_s\":%.3f,\"peak_heap\":%lu,\"size\":%lu}%s\n", r->width, r->height, r->ms,
+                (double)r->width * r->height / MAX(r->ms * 1000.0, 1), (unsigned long)r->heap, (unsigned long)r->size,
+                (i < bn_num_results - 1) ? "," : "");
+    }
+    fputs("]}\n", f);
+    fclose(f);
+}
+
+/**
+ * @brief compare the results with a baseline written by bn_write_json().
+ *
+ * @param name the baseline file.
+ * @param threshold differences in percent that are reported.
+ *
+ * @return number of results that got slower, 1 if the baseline can't be read or no result was found in it.
+ */
+static int bn_compare(const char *name, double threshold) {
+    char line[1024];
+    int slower = 0;
+    int matched = 0;
+
+    FILE *f = fopen(name, "r");
+    if (!f) {
+        fprintf(stderr, "Can't read %s: %s\n", name, strerror(errno));
+        return 1;
+    }
+    printf("\ncompared with %s (differences above %.0f%%):\n", name, threshold);
+    while (fgets(line, sizeof(line), f)) {
+        bn_result_t b;
+        char quality[8];
+        if (sscanf(line, "{\"image\":\"%255[^\"]\",\"op\":\"%7[^\"]\",\"format\":\"%7[^\"]\",\"quality\":%7[^,],\"width\":%d,\"height\":%d,\"ms\":%lf", b.image,
+                   b.op, b.format, quality, &b.width, &b.height, &b.ms) != 7) {
+            continue;
+        }
+        b.quality = strcmp(quality, "null") ? atoi(quality) : -1;
+        for (int i = 0; i < bn_num_results; i++) {
+            bn_result_t *r = &bn_results[i];
+            if (strcmp(r->image, b.image) || strcmp(r->op, b.op) || strcmp(r->format, b.format) || (r->quality != b.quality)) {
+                continue;
+            }
+            matched++;
+            double diff = (r->ms - b.ms) * 100.0 / MAX(b.ms, 0.001);
+            if (fabs(diff) > threshold) {
+                printf("%-32s %-6s %-3s %10.3f -> %10.3f ms %+7.1f%%%s\n", r->image, r->op, r->format, b.ms, r->ms, diff, (diff > 0) ? "  SLOWER" : "");
+                slower += diff > 0;
+            }
+            break;
+        }
+    }
+    fclose(f);
+
+    // a check that compared nothing must not pass
+    if (!matched) {
+        fprintf(stderr, "Nothing to compare in %s\n", name);
+        return 1;
+    }
+    return slower;
+}
+
+/**
+ * @brief register the file formats like dosview does.
+ */
+static void bn_register_formats(void) {
+    alpng_init();
+    algif_init();
+    register_bitmap_file_type("gif", load_gif8, save_gif, NULL);
+    register_bitmap_file_type("qoi", load_qoi, save_qoi, NULL);
+    register_bitmap_file_type("web", load_webp, save_webp, NULL);
+    register_bitmap_file_type("jpg", load_jpeg, save_jpeg, NULL);
+    register_bitmap_file_type("tif", load_tiff, save_tiff, NULL);
+    register_bitmap_file_type("jp2", load_jasper, save_jasper, NULL);
+    register_bitmap_file_type("ppm", load_jasper, save_jasper, NULL);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief run the benchmark.
+ *
+ * @param argc number of arguments.
+ * @param argv the arguments.
+ *
+ * @return 0 if nothing got slower than the baseline.
+ */
+int main(int argc, char **argv) {
+    const char *out = NULL;
+    const char *baseline = NULL;
+    const char *formats = BN_DEFAULT_FORMATS;
+    const char *qualities = BN_DEFAULT_QUALITIES;
+    double threshold = 10;
+    int max_width = 7680;
+    int depth = 32;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:c:t:n:f:q:s:j:d:h")) != -1) {
+        switch (opt) {
+            case 'o':
+                out = optarg;
+                break;
+            case 'c':
+                baseline = optarg;
+                break;
+            case 't':
+                threshold = atof(optarg);
+                break;
+            case 'n':
+                bn_runs = MAX(1, atoi(optarg));
+                break;
+            case 'f':
+                formats = optarg;
+                break;
+            case 'q':
+                qualities = optarg;
+                break;
+            case 's':
+                max_width = atoi(optarg);
+                break;
+            case 'j':
+                bn_jpeg_qualities = optarg;
+                break;
+            case 'd':
+                depth = atoi(optarg);
+                break;
+            default:
+                bn_usage();
+        }
+    }
+
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    set_color_depth(depth);
+    load_depth = depth;
+    bn_register_formats();
+
+    int num_files = 0;
+    char **files = NULL;
+    if (optind == argc) {
+        files = bn_scan_dir("images", files, &num_files);
+    }
+    for (int i = optind; i < argc; i++) {
+        struct stat st;
+        if (!stat(argv[i], &st) && S_ISDIR(st.st_mode)) {
+            files = bn_scan_dir(argv[i], files, &num_files);
+        } else {
+            files = realloc(files, (num_files + 1) * sizeof(char *));
+            files[num_files++] = ut_clone_string(argv[i]);
+        }
+    }
+
+    for (int i = 0; i < num_files; i++) {
+        uint64_t us;
+        size_t heap;
+        PALETTE pal;
+        sniff_t s;
+
+        sn_sniff(files[i], &s);
+        BITMAP *bm = bn_load(files[i], pal, &us, &heap);
+        if (!bm) {
+            fprintf(stderr, "%s: loading failed\n", files[i]);
+            continue;
+        }
+        bn_add(files[i], "load", s.format, -1, bm, us, heap, s.file_size);
+        if (!strcmp(s.format, "JPG")) {
+            bn_load_qualities(files[i], "load", files[i], -1, s.file_size);
+        }
+        bn_roundtrip(files[i], bm, pal, formats, qualities);
+        destroy_bitmap(bm);
+    }
+
+    for (int i = 0; bn_sizes[i][0] && (bn_sizes[i][0] <= max_width); i++) {
+        char name[32];
+        PALETTE pal;
+        snprintf(name, sizeof(name), "synthetic-%dx%d", bn_sizes[i][0], bn_sizes[i][1]);
+        BITMAP *bm = bn_synthetic(bn_sizes[i][0], bn_sizes[i][1]);
+        if (!bm) {
+            fprintf(stderr, "%s: out of memory\n", name);
+            continue;
+        }
+        get_palette(pal);
+        bn_roundtrip(name, bm, pal, formats, qualities);
+        destroy_bitmap(bm);
+    }
+
+    if (out) {
+        bn_write_json(out);
+    }
+    return (baseline && bn_compare(baseline, threshold)) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,620 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Pixel kernel micro benchmark, builds for the Linux host (Makefile.linux) and for DOS (make kernbench).
+ *
+ * Every kernel runs on memory bitmaps of the given size for all combinations of the given color depths: Allegro's
+ * blit() between depths (blit_from_32() and friends), the dithering blit, stretch_blit() (cstretch.c or the compiled
+ * i386 stretcher on DOS), the filters of resample.c, the mipmap reduction and the row conversions of sink.c that all
+ * decoders use. A kernel is repeated in batches until the fastest batch did not get faster for a while, the result is
+ * reported in ns per (destination) pixel. Results can be written as JSON baseline and a later run can be compared
+ * against it.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "util.h"
+#include "sink.h"
+#include "mipmap.h"
+#include "resample.h"
+#include "tilestore.h"
+
+/************
+** defines **
+************/
+#define KB_BATCH_TIME 10000      //!< a kernel is repeated at least this long per batch [us]
+#define KB_STABLE_BATCHES 8      //!< measuring stops when this many batches in a row were not faster...
+#define KB_STABLE_PERCENT 1.0    //!< ...by more than this
+#define KB_MAX_BATCHES 256       //!< upper limit of batches per measurement
+#define KB_MAX_RESULTS 1024      //!< results kept for the comparison with a baseline
+#define KB_DEFAULT_DEPTHS "8,15,16,24,32"
+
+#define KB_PAIR 0   //!< kernel converts from a source depth to a destination depth
+#define KB_SAME 1   //!< kernel works on one depth
+#define KB_WRITE 2  //!< kernel stores rows of a sink format in a bitmap
+#define KB_READ 3   //!< kernel reads rows of a sink format from a bitmap
+
+/************
+** structs **
+************/
+struct __kb_kernel;
+
+//! everything a kernel works on
+typedef struct __kb_ctx {
+    const struct __kb_kernel *kernel;  //!< the kernel
+    BITMAP *src;                       //!< source bitmap (NULL for KB_WRITE)
+    BITMAP *dst;                       //!< destination bitmap (NULL for KB_READ and kernels that create their own)
+    uint8_t *rows;                     //!< src->h rows in the sink format (KB_WRITE and KB_READ)
+    int format;                        //!< sink format
+    int width;                         //!< source width
+    int height;                        //!< source height
+    int depth;                         //!< destination depth
+} kb_ctx_t;
+
+//! a kernel
+typedef struct __kb_kernel {
+    const char *name;                //!< name for -k and the results
+    int type;                        //!< KB_PAIR, KB_SAME, KB_WRITE or KB_READ
+    void (*run)(kb_ctx_t *ctx);      //!< runs the kernel once
+    float factor;                    //!< scaling factor, destination pixels are counted
+    int param;                       //!< color conversion, filter or sink format
+} kb_kernel_t;
+
+//! one measurement
+typedef struct __kb_result {
+    char kernel[32];  //!< kernel name
+    char src[8];      //!< source depth or sink format
+    char dst[8];      //!< destination depth or sink format
+    int width;        //!< source width
+    int height;       //!< source height
+    double ns;        //!< fastest batch [ns/pixel]
+    double median;    //!< median of all batches [ns/pixel]
+    int batches;      //!< number of batches
+} kb_result_t;
+
+/************
+** globals **
+************/
+int output_quality = 95;
+int load_depth = 32;
+int load_shrink = 1;
+tile_store_t *load_tiles = NULL;
+bool load_preview = false;
+int load_quality = LOAD_NORMAL;
+bool (*load_scan)(BITMAP *bm, RGB *pal, bool temporary) = NULL;
+bool (*load_progress)(uint32_t done, uint32_t total) = NULL;
+
+static PALETTE kb_pal;                           //!< 3-3-2 palette used for all 8bpp bitmaps
+static RGB_MAP kb_rgb_table;                     //!< rgb_map for kb_pal
+static uint64_t kb_max_time = 2000000;           //!< upper limit per measurement [us]
+static kb_result_t kb_results[KB_MAX_RESULTS];  //!< all measurements
+static int kb_num_results;                       //!< number of measurements
+
+static const char *kb_format_names[] = {NULL, "gray", NULL, "rgb", "rgba"};  //!< indexed by SK_GRAY..SK_RGBA
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief blit() between two depths, the conversion flags are set by kb_measure().
+ */
+static void kb_blit(kb_ctx_t *ctx) { blit(ctx->src, ctx->dst, 0, 0, 0, 0, ctx->width, ctx->height); }
+
+/**
+ * @brief stretch_blit() the source into the destination.
+ */
+static void kb_stretch(kb_ctx_t *ctx) { stretch_blit(ctx->src, ctx->dst, 0, 0, ctx->width, ctx->height, 0, 0, ctx->dst->w, ctx->dst->h); }
+
+/**
+ * @brief scale the source into the destination with a filter of resample.c.
+ */
+static void kb_resample(kb_ctx_t *ctx) {
+    rs_stretch(ctx->src, ctx->dst, 0, 0, ctx->width, ctx->height, 0, 0, ctx->dst->w, ctx->dst->h, ctx->kernel->param, false);
+}
+
+/**
+ * @brief reduce the source to half its size like the image pyramid does.
+ */
+static void kb_mipmap(kb_ctx_t *ctx) {
+    BITMAP *bm = mm_reduce(ctx->src, false);
+    if (bm) {
+        destroy_bitmap(bm);
+    }
+}
+
+/**
+ * @brief store all rows in the destination with sk_write_row().
+ */
+static void kb_write_rows(kb_ctx_t *ctx) {
+    int stride = ctx->width * ctx->format;
+    for (int y = 0; y < ctx->height; y++) {
+        sk_write_row(ctx->dst, y, ctx->rows + y * stride, ctx->format);
+    }
+}
+
+/**
+ * @brief read all rows from the source with sk_read_row().
+ */
+static void kb_read_rows(kb_ctx_t *ctx) {
+    int stride = ctx->width * ctx->format;
+    for (int y = 0; y < ctx->height; y++) {
+        sk_read_row(ctx->src, y, ctx->rows + y * stride, ctx->format, kb_pal);
+    }
+}
+
+/**
+ * @brief put all rows into a sink that reduces them to half the size, the resulting bitmap is discarded.
+ */
+static void kb_sink_shrink(kb_ctx_t *ctx) {
+    sink_t sk;
+    int stride = ctx->width * ctx->format;
+
+    load_depth = ctx->depth;
+    if (!sk_begin(&sk, ctx->width, ctx->height, NULL, ctx->format, 2)) {
+        return;
+    }
+    for (int y = 0; y < ctx->height; y++) {
+        sk_put_row(&sk, y, ctx->rows + y * stride);
+    }
+    BITMAP *bm = sk_finish(&sk);
+    if (bm) {
+        destroy_bitmap(bm);
+    }
+}
+
+//! all kernels
+static const kb_kernel_t kb_kernels[] = {
+    {"blit", KB_PAIR, kb_blit, 1.0f, COLORCONV_TOTAL},
+    {"dither_blit", KB_PAIR, kb_blit, 1.0f, COLORCONV_TOTAL | COLORCONV_DITHER},
+    {"stretch_x0.5", KB_SAME, kb_stretch, 0.5f, 0},
+    {"stretch_x2", KB_SAME, kb_stretch, 2.0f, 0},
+    {"box_x0.5", KB_SAME, kb_resample, 0.5f, RS_BOX},
+    {"bilinear_x0.5", KB_SAME, kb_resample, 0.5f, RS_BILINEAR},
+    {"bilinear_x2", KB_SAME, kb_resample, 2.0f, RS_BILINEAR},
+    {"bicubic_x0.5", KB_SAME, kb_resample, 0.5f, RS_BICUBIC},
+    {"lanczos3_x0.5", KB_SAME, kb_resample, 0.5f, RS_LANCZOS3},
+    {"mipmap", KB_SAME, kb_mipmap, 1.0f, 0},
+    {"write_gray", KB_WRITE, kb_write_rows, 1.0f, SK_GRAY},
+    {"write_rgb", KB_WRITE, kb_write_rows, 1.0f, SK_RGB},
+    {"write_rgba", KB_WRITE, kb_write_rows, 1.0f, SK_RGBA},
+    {"read_rgb", KB_READ, kb_read_rows, 1.0f, SK_RGB},
+    {"read_rgba", KB_READ, kb_read_rows, 1.0f, SK_RGBA},
+    {"sink_shrink2", KB_WRITE, kb_sink_shrink, 1.0f, SK_RGB},
+    {NULL, 0, NULL, 0, 0},
+};
+
+/**
+ * @brief print usage info and exit.
+ */
+static void kb_usage(void) {
+    fputs("Usage: dvkern [options]\n", stderr);
+    fputs("  -s <w>x<h> : size of the source bitmaps, default 640x480.\n", stderr);
+    fputs("  -d <list>  : color depths, default " KB_DEFAULT_DEPTHS ".\n", stderr);
+    fputs("  -k <list>  : kernels, default all of:\n", stderr);
+    for (int i = 0; kb_kernels[i].name; i++) {
+        fprintf(stderr, "%s%s", (i % 6) ? ", " : "\n               ", kb_kernels[i].name);
+    }
+    fputs("\n", stderr);
+    fputs("  -m <ms>    : max time per measurement, default 2000.\n", stderr);
+    fputs("  -o <file>  : write the results as JSON baseline.\n", stderr);
+    fputs("  -c <file>  : compare the results with a baseline written by -o.\n", stderr);
+    fputs("  -t <pct>   : only report differences above this many percent, default 5.\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief check if a name is in a comma separated list.
+ *
+ * @param list the list.
+ * @param name the name.
+ *
+ * @return true if it is in the list.
+ */
+static bool kb_in_list(const char *list, const char *name) {
+    size_t len = strlen(name);
+    for (const char *s = list; s; s = strchr(s, ',') ? strchr(s, ',') + 1 : NULL) {
+        if (!strncasecmp(s, name, len) && ((s[len] == ',') || (s[len] == 0))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief create the source image: gradients, a checkerboard and a band of noise so no conversion takes a shortcut.
+ *
+ * @param w width.
+ * @param h height.
+ * @param depth color depth.
+ *
+ * @return the bitmap or NULL if out of memory.
+ */
+static BITMAP *kb_source(int w, int h, int depth) {
+    BITMAP *bm = create_bitmap_ex(depth, w, h);
+    if (!bm) {
+        return NULL;
+    }
+    uint32_t seed = 0x12345678;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            seed = seed * 1103515245 + 12345;
+            int r = x * 255 / w;
+            int g = y * 255 / h;
+            int b = (((x / 32) ^ (y / 32)) & 1) ? 200 : 40;
+            if ((x + y) % (w / 4 + 1) < w / 16) {
+                r = (r + (seed >> 24)) & 0xFF;
+                g = (g + (seed >> 16)) & 0xFF;
+            }
+            putpixel(bm, x, y, makecol_depth(depth, r, g, b));
+        }
+    }
+    return bm;
+}
+
+/**
+ * @brief compare two doubles for qsort().
+ */
+static int kb_cmp_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * @brief run a kernel in batches until the timing is stable and record the result.
+ *
+ * @param ctx the kernel and its bitmaps.
+ * @param src name of the source depth/format.
+ * @param dst name of the destination depth/format.
+ */
+static void kb_measure(kb_ctx_t *ctx, const char *src, const char *dst) {
+    static double batch_ns[KB_MAX_BATCHES];
+    const kb_kernel_t *k = ctx->kernel;
+    double pixels = (double)ctx->width * ctx->height;
+    if (k->factor != 1.0f) {
+        pixels = (double)ctx->dst->w * ctx->dst->h;
+    }
+
+    set_color_conversion((k->type == KB_PAIR) ? k->param : COLORCONV_TOTAL);
+    k->run(ctx);  // warm up caches and lazily created tables
+
+    int batches = 0;
+    int unchanged = 0;
+    double best = 0;
+    uint64_t total = ut_time_us();
+    while ((batches < KB_MAX_BATCHES) && (unchanged < KB_STABLE_BATCHES) && (ut_time_us() - total < kb_max_time)) {
+        int runs = 0;
+        uint64_t start = ut_time_us();
+        uint64_t elapsed;
+        do {
+            k->run(ctx);
+            runs++;
+            elapsed = ut_time_us() - start;
+        } while (elapsed < KB_BATCH_TIME);
+
+        double ns = elapsed * 1000.0 / (runs * pixels);
+        batch_ns[batches++] = ns;
+        if (!best || (ns < best * (1.0 - KB_STABLE_PERCENT / 100.0))) {
+            unchanged = 0;
+        } else {
+            unchanged++;
+        }
+        if (!best || ns < best) {
+            best = ns;
+        }
+    }
+    qsort(batch_ns, batches, sizeof(double), kb_cmp_double);
+
+    if (kb_num_results < KB_MAX_RESULTS) {
+        kb_result_t *r = &kb_results[kb_num_results++];
+        snprintf(r->kernel, sizeof(r->kernel), "%s", k->name);
+        snprintf(r->src, sizeof(r->src), "%s", src);
+        snprintf(r->dst, sizeof(r->dst), "%s", dst);
+        r->width = ctx->width;
+        r->height = ctx->height;
+        r->ns = best;
+        r->median = batch_ns[batches / 2];
+        r->batches = batches;
+    }
+    printf("%-14s %-5s -> %-5s %9.3f ns/pixel %9.2f Mpixel/s  (median %.3f, %d batches%s)\n", k->name, src, dst, best, 1000.0 / best,
+           batch_ns[batches / 2], batches, (unchanged < KB_STABLE_BATCHES) ? ", not stable" : "");
+    fflush(stdout);
+}
+
+/**
+ * @brief run one kernel for all requested depths.
+ *
+ * @param k the kernel.
+ * @param sources source bitmaps indexed by depth.
+ * @param depths comma separated list of depths.
+ */
+static void kb_run_kernel(const kb_kernel_t *k, BITMAP *sources[33], const char *depths) {
+    static const int all_depths[] = {8, 15, 16, 24, 32, 0};
+    kb_ctx_t ctx = {0};
+    char src_name[8];
+    char dst_name[8];
+
+    ctx.kernel = k;
+    ctx.width = sources[32]->w;
+    ctx.height = sources[32]->h;
+
+    for (int s = 0; all_depths[s]; s++) {
+        for (int d = 0; all_depths[d]; d++) {
+            int src_depth = all_depths[s];
+            int dst_depth = all_depths[d];
+            snprintf(src_name, sizeof(src_name), "%d", src_depth);
+            snprintf(dst_name, sizeof(dst_name), "%d", dst_depth);
+            // row kernels have a sink format on one side, only the depth on the other side is filtered
+            bool src_ok = (k->type == KB_WRITE) || kb_in_list(depths, src_name);
+            bool dst_ok = (k->type == KB_READ) || kb_in_list(depths, dst_name);
+            if (!src_ok || !dst_ok) {
+                continue;
+            }
+
+            ctx.src = NULL;
+            ctx.dst = NULL;
+            ctx.rows = NULL;
+            ctx.format = k->param;
+            ctx.depth = dst_depth;
+
+            switch (k->type) {
+                case KB_PAIR:
+                    if ((k->param & COLORCONV_DITHER) && ((src_depth == 8) || (dst_depth > 16) || (src_depth <= dst_depth))) {
+                        continue;  // nothing to dither
+                    }
+                    ctx.src = sources[src_depth];
+                    ctx.dst = create_bitmap_ex(dst_depth, ctx.width, ctx.height);
+                    break;
+                case KB_SAME:
+                    if (s != d) {
+                        continue;
+                    }
+                    ctx.src = sources[src_depth];
+                    if (k->run != kb_mipmap) {
+                        ctx.dst = create_bitmap_ex(dst_depth, MAX(1, (int)(ctx.width * k->factor)), MAX(1, (int)(ctx.height * k->factor)));
+                    }
+                    break;
+                case KB_WRITE:
+                    // the sink stores gray rows as 8bpp only
+                    if ((s != 0) || ((k->param == SK_GRAY) && (dst_depth != 8))) {
+                        continue;
+                    }
+                    snprintf(src_name, sizeof(src_name), "%s", kb_format_names[k->param]);
+                    ctx.src = sources[32];
+                    if (k->run == kb_write_rows) {
+                        load_depth = dst_depth;
+                        ctx.dst = sk_create_bitmap(ctx.width, ctx.height, NULL, k->param);
+                    }
+                    break;
+                case KB_READ:
+                    if (d != 0) {
+                        continue;
+                    }
+                    snprintf(dst_name, sizeof(dst_name), "%s", kb_format_names[k->param]);
+                    ctx.src = sources[src_depth];
+                    break;
+            }
+
+            bool ok = (ctx.dst || (k->run == kb_mipmap) || (k->type == KB_READ) || (k->run == kb_sink_shrink));
+            if (ok && ((k->type == KB_WRITE) || (k->type == KB_READ))) {
+                ctx.rows = malloc((size_t)ctx.width * ctx.height * k->param);
+                if (ctx.rows) {
+                    // rows with the contents of the source image
+                    for (int y = 0; y < ctx.height; y++) {
+                        sk_read_row(sources[32], y, ctx.rows + y * ctx.width * k->param, k->param, kb_pal);
+                    }
+                } else {
+                    ok = false;
+                }
+            }
+
+            if (ok) {
+                kb_measure(&ctx, src_name, dst_name);
+            } else {
+                printf("%-14s %-5s -> %-5s out of memory\n", k->name, src_name, dst_name);
+            }
+
+            if (ctx.dst) {
+                destroy_bitmap(ctx.dst);
+            }
+            free(ctx.rows);
+        }
+    }
+}
+
+/**
+ * @brief write all results as JSON, one result per line so baselines can be diffed.
+ *
+ * @param name the file.
+ */
+static void kb_write_json(const char *name) {
+    FILE *f = fopen(name, "w");
+    if (!f) {
+        fprintf(stderr, "Can't write %s: %s\n", name, strerror(errno));
+        return;
+    }
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(f, "{\"date\":\"%s\",\"compiler\":\"%s\",\"results\":[\n", date, __VERSION__);
+    for (int i = 0; i < kb_num_results; i++) {
+        kb_result_t *r = &kb_results[i];
+        fprintf(f, "{\"kernel\":\"%s\",\"src\":\"%s\",\"dst\":\"%s\",\"width\":%d,\"height\":%d,\"ns_per_pixel\":%.4f,\"median\":%.4f,\"batches\":%d}%s\n",
+                r->kernel, r->src, r->dst, r->width, r->height, r->ns, r->median, r->batches, (i < kb_num_results - 1) ? "," : "");
+    }
+    fputs("]}\n", f);
+    fclose(f);
+}
+
+/**
+ * @brief compare the results with a baseline written by kb_write_json().
+ *
+ * @param name the baseline file.
+ * @param threshold differences in percent that are reported.
+ *
+ * @return number of results that got slower, 1 if the baseline can't be read or no result was found in it.
+ */
+static int kb_compare(const char *name, double threshold) {
+    char line[512];
+    int slower = 0;
+    int matched = 0;
+
+    FILE *f = fopen(name, "r");
+    if (!f) {
+        fprintf(stderr, "Can't read %s: %s\n", name, strerror(errno));
+        return 1;
+    }
+    printf("\ncompared with %s (differences above %.0f%%):\n", name, threshold);
+    while (fgets(line, sizeof(line), f)) {
+        kb_result_t b;
+        if (sscanf(line, "{\"kernel\":\"%31[^\"]\",\"src\":\"%7[^\"]\",\"dst\":\"%7[^\"]\",\"width\":%d,\"height\":%d,\"ns_per_pixel\":%lf", b.kernel, b.src,
+                   b.dst, &b.width, &b.height, &b.ns) != 6) {
+            continue;
+        }
+        for (int i = 0; i < kb_num_results; i++) {
+            kb_result_t *r = &kb_results[i];
+            if (strcmp(r->kernel, b.kernel) || strcmp(r->src, b.src) || strcmp(r->dst, b.dst) || (r->width != b.width) || (r->height != b.height)) {
+                continue;
+            }
+            matched++;
+            double diff = (r->ns - b.ns) * 100.0 / MAX(b.ns, 0.0001);
+            if (fabs(diff) > threshold) {
+                printf("%-14s %-5s -> %-5s %9.3f -> %9.3f ns/pixel %+7.1f%%%s\n", r->kernel, r->src, r->dst, b.ns, r->ns, diff, (diff > 0) ? "  SLOWER" : "");
+                slower += diff > 0;
+            }
+            break;
+        }
+    }
+    fclose(f);
+
+    // a check that compared nothing must not pass
+    if (!matched) {
+        fprintf(stderr, "Nothing to compare in %s\n", name);
+        return 1;
+    }
+    return slower;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief run the benchmark.
+ *
+ * @param argc number of arguments.
+ * @param argv the arguments.
+ *
+ * @return 0 if nothing got slower than the baseline.
+ */
+int main(int argc, char **argv) {
+    const char *out = NULL;
+    const char *baseline = NULL;
+    const char *depths = KB_DEFAULT_DEPTHS;
+    const char *kernels = NULL;
+    double threshold = 5;
+    int width = 640;
+    int height = 480;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:k:m:o:c:t:h")) != -1) {
+        switch (opt) {
+            case 's':
+                if ((sscanf(optarg, "%dx%d", &width, &height) != 2) || (width < 2) || (height < 2)) {
+                    kb_usage();
+                }
+                break;
+            case 'd':
+                depths = optarg;
+                break;
+            case 'k':
+                kernels = optarg;
+                break;
+            case 'm':
+                kb_max_time = (uint64_t)MAX(1, atoi(optarg)) * 1000;
+                break;
+            case 'o':
+                out = optarg;
+                break;
+            case 'c':
+                baseline = optarg;
+                break;
+            case 't':
+                threshold = atof(optarg);
+                break;
+            default:
+                kb_usage();
+        }
+    }
+
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+
+    // 8bpp bitmaps use a 3-3-2 palette like the sink does
+    generate_332_palette(kb_pal);
+    select_palette(kb_pal);
+    create_rgb_table(&kb_rgb_table, kb_pal, NULL);
+    rgb_map = &kb_rgb_table;
+
+    BITMAP *sources[33] = {0};
+    BITMAP *base = kb_source(width, height, 32);
+    if (!base) {
+        fputs("Out of memory.\n", stderr);
+        return EXIT_FAILURE;
+    }
+    sources[32] = base;
+    static const int src_depths[] = {8, 15, 16, 24, 0};
+    for (int i = 0; src_depths[i]; i++) {
+        sources[src_depths[i]] = create_bitmap_ex(src_depths[i], width, height);
+        if (!sources[src_depths[i]]) {
+            fputs("Out of memory.\n", stderr);
+            return EXIT_FAILURE;
+        }
+        set_color_conversion(COLORCONV_TOTAL);
+        blit(base, sources[src_depths[i]], 0, 0, 0, 0, width, height);
+    }
+
+    printf("Pixel kernels on %dx%d memory bitmaps, compiled with gcc %s\n", width, height, __VERSION__);
+    for (int i = 0; kb_kernels[i].name; i++) {
+        if (!kernels || kb_in_list(kernels, kb_kernels[i].name)) {
+            kb_run_kernel(&kb_kernels[i], sources, depths);
+        }
+    }
+
+    for (int i = 0; i < 33; i++) {
+        if (sources[i]) {
+            destroy_bitmap(sources[i]);
+        }
+    }
+
+    if (out) {
+        kb_write_json(out);
+    }
+    return (baseline && kb_compare(baseline, threshold)) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
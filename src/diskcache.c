@@ -0,0 +1,293 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "diskcache.h"
+
+/************
+** defines **
+************/
+#define DC_MAGIC "DVC1"   //!< first bytes of a cache entry
+#define DC_EXT ".DVC"     //!< extension of cache entries
+#define DC_TMP_EXT ".TMP" //!< extension of entries being written
+
+#ifndef PATH_MAX
+#define PATH_MAX 260  //!< max length of a path
+#endif
+
+/************
+** structs **
+************/
+//! header of a cache entry, followed by the canonical path of the image and the pixel rows
+typedef struct __dc_header {
+    char magic[4];          //!< DC_MAGIC
+    uint64_t file_size;     //!< size of the image file
+    int64_t mtime;          //!< modification time of the image file
+    uint32_t depth;         //!< color depth the image was loaded for
+    uint32_t shrink;        //!< size reduction the image was loaded with
+    uint32_t quality;       //!< speed/quality trade-off the image was decoded with (load_quality)
+    uint32_t path_len;      //!< length of the path following the header
+    uint32_t width;         //!< width of the bitmap
+    uint32_t height;        //!< height of the bitmap
+    uint32_t bitmap_depth;  //!< color depth of the bitmap
+    RGB pal[PAL_SIZE];      //!< palette for 8bpp bitmaps
+} dc_header_t;
+
+//! a cache entry found by dc_trim()
+typedef struct __dc_entry {
+    char name[PATH_MAX];  //!< path of the entry
+    uint64_t size;        //!< size in bytes
+    time_t mtime;         //!< last use
+} dc_entry_t;
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief fill in the key of a cache entry for an image and get the name of the entry.
+ * Entries are named by a hash of path, size, modification time and load parameters, so the names are valid 8.3 file names.
+ *
+ * @param dir cache directory.
+ * @param filename the image file.
+ * @param depth requested color depth.
+ * @param shrink requested size reduction.
+ * @param hdr the header to fill in.
+ * @param path returns the canonical path of the image (PATH_MAX bytes).
+ * @param entry returns the path of the cache entry without extension (PATH_MAX bytes).
+ *
+ * @return false if the image file does not exist or the path of the entry (with extension) is too long.
+ */
+static bool dc_key(const char *dir, const char *filename, int depth, int shrink, dc_header_t *hdr, char *path, char *entry) {
+    struct stat st;
+
+    if (stat(filename, &st) != 0) {
+        return false;
+    }
+
+    fix_filename_path(path, filename, PATH_MAX);
+
+    memset(hdr, 0, sizeof(dc_header_t));
+    memcpy(hdr->magic, DC_MAGIC, sizeof(hdr->magic));
+    hdr->file_size = st.st_size;
+    hdr->mtime = st.st_mtime;
+    hdr->depth = depth;
+    hdr->shrink = shrink;
+    hdr->quality = load_quality;
+    hdr->path_len = strlen(path);
+
+    // FNV-1a over everything that identifies the entry
+    uint32_t hash = 2166136261u;
+    for (const char *p = path; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    }
+    const uint8_t *k = (const uint8_t *)&hdr->file_size;
+    for (size_t i = 0; i < offsetof(dc_header_t, path_len) - offsetof(dc_header_t, file_size); i++) {
+        hash = (hash ^ k[i]) * 16777619u;
+    }
+
+    // a truncated name would hit another entry
+    int len = snprintf(entry, PATH_MAX, "%s/%08lX", dir, (unsigned long)hash);
+    return (len >= 0) && (len + strlen(DC_EXT) < PATH_MAX);
+}
+
+/**
+ * @brief compare two entries by the time of their last use.
+ */
+static int dc_compare(const void *a, const void *b) {
+    time_t ta = ((const dc_entry_t *)a)->mtime;
+    time_t tb = ((const dc_entry_t *)b)->mtime;
+    return (ta < tb) ? -1 : (ta > tb);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief load an image from the cache.
+ *
+ * @param dir cache directory.
+ * @param filename the image file.
+ * @param depth color depth the image is loaded for (load_depth).
+ * @param shrink size reduction the image is loaded with (load_shrink).
+ * @param pal returns the palette of 8bpp images.
+ *
+ * @return the bitmap or NULL if the image is not in the cache (or changed since it was cached).
+ */
+BITMAP *dc_load(const char *dir, const char *filename, int depth, int shrink, RGB *pal) {
+    dc_header_t key, hdr;
+    char path[PATH_MAX], entry[PATH_MAX], stored[PATH_MAX];
+
+    if (!dc_key(dir, filename, depth, shrink, &key, path, entry)) {
+        return NULL;
+    }
+    strncat(entry, DC_EXT, PATH_MAX - strlen(entry) - 1);
+
+    FILE *f = fopen(entry, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    // the hash only finds the entry, the header must match exactly
+    if ((fread(&hdr, sizeof(hdr), 1, f) != 1) || (memcmp(&hdr, &key, offsetof(dc_header_t, width)) != 0) || (hdr.path_len != key.path_len) ||
+        (fread(stored, hdr.path_len, 1, f) != 1) || (memcmp(stored, path, hdr.path_len) != 0)) {
+        DEBUGF("cache entry %s does not match %s\n", entry, path);
+        fclose(f);
+        return NULL;
+    }
+
+    BITMAP *bm = create_bitmap_ex(hdr.bitmap_depth, hdr.width, hdr.height);
+    if (!bm) {
+        fclose(f);
+        return NULL;
+    }
+    int line_bytes = hdr.width * ((hdr.bitmap_depth + 7) / 8);
+    for (int y = 0; y < bm->h; y++) {
+        if (fread(bm->line[y], line_bytes, 1, f) != 1) {
+            DEBUGF("cache entry %s is truncated\n", entry);
+            destroy_bitmap(bm);
+            fclose(f);
+            return NULL;
+        }
+    }
+    fclose(f);
+
+    if (pal) {
+        memcpy(pal, hdr.pal, sizeof(hdr.pal));
+    }
+
+    // mark as recently used
+    utime(entry, NULL);
+
+    DEBUGF("loaded %s from cache entry %s\n", filename, entry);
+    return bm;
+}
+
+/**
+ * @brief store a loaded image in the cache. Errors are ignored, the cache is only an optimization.
+ *
+ * @param dir cache directory.
+ * @param filename the image file.
+ * @param depth color depth the image was loaded for (load_depth).
+ * @param shrink size reduction the image was loaded with (load_shrink).
+ * @param bm the loaded bitmap.
+ * @param pal palette of 8bpp bitmaps (may be NULL).
+ */
+void dc_store(const char *dir, const char *filename, int depth, int shrink, BITMAP *bm, AL_CONST RGB *pal) {
+    dc_header_t hdr;
+    char path[PATH_MAX], entry[PATH_MAX], tmp[PATH_MAX + sizeof(DC_TMP_EXT)];
+
+    if (!dc_key(dir, filename, depth, shrink, &hdr, path, entry)) {
+        return;
+    }
+    hdr.width = bm->w;
+    hdr.height = bm->h;
+    hdr.bitmap_depth = bitmap_color_depth(bm);
+    if (pal && (hdr.bitmap_depth == 8)) {
+        memcpy(hdr.pal, pal, sizeof(hdr.pal));
+    }
+
+    // write to a temporary name so an interrupted write never leaves a broken entry
+    snprintf(tmp, sizeof(tmp), "%s%s", entry, DC_TMP_EXT);
+    strncat(entry, DC_EXT, PATH_MAX - strlen(entry) - 1);
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        DEBUGF("Can't create cache entry %s\n", tmp);
+        return;
+    }
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1) && (fwrite(path, hdr.path_len, 1, f) == 1);
+    int line_bytes = bm->w * ((hdr.bitmap_depth + 7) / 8);
+    for (int y = 0; ok && (y < bm->h); y++) {
+        ok = (fwrite(bm->line[y], line_bytes, 1, f) == 1);
+    }
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+
+    remove(entry);
+    if (!ok || (rename(tmp, entry) != 0)) {
+        DEBUGF("Can't write cache entry %s\n", entry);
+        remove(tmp);
+        return;
+    }
+    DEBUGF("stored %s in cache entry %s\n", filename, entry);
+}
+
+/**
+ * @brief delete the least recently used entries until the cache is smaller than the limit.
+ *
+ * @param dir cache directory.
+ * @param max_bytes size limit.
+ */
+void dc_trim(const char *dir, uint64_t max_bytes) {
+    dc_entry_t *entries = NULL;
+    int num = 0;
+    uint64_t total = 0;
+
+    DIR *d = opendir(dir);
+    if (!d) {
+        return;
+    }
+
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        // only touch our own files
+        size_t len = strlen(de->d_name);
+        if ((len < strlen(DC_EXT)) || strcasecmp(&de->d_name[len - strlen(DC_EXT)], DC_EXT)) {
+            continue;
+        }
+
+        dc_entry_t *e = realloc(entries, (num + 1) * sizeof(dc_entry_t));
+        if (!e) {
+            break;
+        }
+        entries = e;
+        e = &entries[num];
+
+        struct stat st;
+        snprintf(e->name, sizeof(e->name), "%s/%s", dir, de->d_name);
+        if (stat(e->name, &st) != 0) {
+            continue;
+        }
+        e->size = st.st_size;
+        e->mtime = st.st_mtime;
+        total += e->size;
+        num++;
+    }
+    closedir(d);
+
+    qsort(entries, num, sizeof(dc_entry_t), dc_compare);
+    for (int i = 0; (i < num) && (total > max_bytes); i++) {
+        DEBUGF("evicting cache entry %s\n", entries[i].name);
+        if (remove(entries[i].name) == 0) {
+            total -= entries[i].size;
+        }
+    }
+    free(entries);
+}
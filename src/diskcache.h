@@ -0,0 +1,40 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __DISKCACHE_H__
+#define __DISKCACHE_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#define DC_DEFAULT_SIZE 64  //!< default size limit of the cache directory in MiB
+
+/***********************
+** exported functions **
+***********************/
+extern BITMAP *dc_load(const char *dir, const char *filename, int depth, int shrink, RGB *pal);
+extern void dc_store(const char *dir, const char *filename, int depth, int shrink, BITMAP *bm, AL_CONST RGB *pal);
+extern void dc_trim(const char *dir, uint64_t max_bytes);
+
+#endif  // __DISKCACHE_H__
@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "display.h"
+
+/************
+** defines **
+************/
+#define NUM_PAGES 2  //!< number of video pages needed for page flipping
+
+/************
+** globals **
+************/
+static BITMAP *back_buffer;           //!< system memory bitmap every frame is composed in
+static BITMAP *video_page[NUM_PAGES];  //!< video pages for page flipping, NULL if not available
+static int current_page;              //!< index of the currently hidden video page
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief set up the back buffer for the given screen size.
+ * Frames are always composed in a system memory bitmap because reading/writing video memory is slow.
+ * If the driver can provide two video pages the finished frame is copied to the hidden page and flipped, else it is copied to the screen in one go.
+ * If no graphics mode is set (screen == NULL) the back buffer is a plain memory bitmap and presenting is a no-op (headless rendering).
+ *
+ * @param width screen width.
+ * @param height screen height.
+ * @param depth color depth of the back buffer.
+ *
+ * @return true if the back buffer could be created, else false.
+ */
+bool dp_init(int width, int height, int depth) {
+    dp_exit();
+
+    back_buffer = create_bitmap_ex(depth, width, height);
+    if (!back_buffer) {
+        DEBUGF("Can't create back buffer: %s\n", allegro_error);
+        return false;
+    }
+    clear_to_color(back_buffer, 0);
+
+    if (screen) {
+        for (int i = 0; i < NUM_PAGES; i++) {
+            video_page[i] = create_video_bitmap(width, height);
+            if (!video_page[i]) {
+                DEBUGF("Only %d video pages available, no page flipping\n", i);
+                for (int p = 0; p < i; p++) {
+                    destroy_bitmap(video_page[p]);
+                    video_page[p] = NULL;
+                }
+                break;
+            }
+        }
+
+        if (video_page[0]) {
+            // the first page is shown, so we start drawing into the second one
+            clear_to_color(video_page[0], 0);
+            show_video_bitmap(video_page[0]);
+            current_page = 1;
+        }
+    }
+    DEBUGF("display mode is '%s'\n", dp_get_mode());
+
+    return true;
+}
+
+/**
+ * @brief get the bitmap the next frame should be drawn into.
+ *
+ * @return the back buffer or NULL if dp_init() was not called.
+ */
+BITMAP *dp_get_buffer(void) { return back_buffer; }
+
+/**
+ * @brief show the composed frame on screen with a single sequential copy (and a page flip if available).
+ */
+void dp_present(void) {
+    if (!back_buffer || !screen) {
+        return;
+    }
+
+    if (video_page[0]) {
+        blit(back_buffer, video_page[current_page], 0, 0, 0, 0, back_buffer->w, back_buffer->h);
+        show_video_bitmap(video_page[current_page]);
+        current_page = (current_page + 1) % NUM_PAGES;
+    } else {
+        acquire_screen();
+        blit(back_buffer, screen, 0, 0, 0, 0, back_buffer->w, back_buffer->h);
+        release_screen();
+    }
+}
+
+/**
+ * @brief get a short description of the current presentation method (for the image info).
+ *
+ * @return a static string.
+ */
+const char *dp_get_mode(void) {
+    if (!back_buffer) {
+        return "none";
+    } else if (!screen) {
+        return "headless";
+    } else if (video_page[0]) {
+        return "page flip";
+    } else {
+        return "double buffer";
+    }
+}
+
+/**
+ * @brief free the back buffer and all video pages.
+ */
+void dp_exit(void) {
+    for (int i = 0; i < NUM_PAGES; i++) {
+        if (video_page[i]) {
+            destroy_bitmap(video_page[i]);
+            video_page[i] = NULL;
+        }
+    }
+    if (back_buffer) {
+        destroy_bitmap(back_buffer);
+        back_buffer = NULL;
+    }
+    current_page = 0;
+}
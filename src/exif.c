@@ -0,0 +1,163 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Reads the EXIF block a camera puts into the APP1 marker of a JPEG: "Exif\0\0" followed by a small TIFF file.
+ * Only the orientation (IFD0) and the JPEG thumbnail (IFD1) are used, everything is bounds checked because the
+ * blocks written by cameras and editors are often broken.
+ */
+#include <string.h>
+
+#include "exif.h"
+
+/************
+** defines **
+************/
+#define EX_HEADER_SIZE 6            //!< size of "Exif\0\0" in front of the TIFF header
+#define EX_IFD_ENTRY_SIZE 12        //!< tag, type, count and value/offset
+#define EX_TAG_ORIENTATION 0x0112   //!< IFD0: orientation (SHORT)
+#define EX_TAG_THUMB_OFFSET 0x0201  //!< IFD1: offset of the JPEG thumbnail (LONG)
+#define EX_TAG_THUMB_LENGTH 0x0202  //!< IFD1: size of the JPEG thumbnail (LONG)
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief read a 16 bit value in the byte order of the block.
+ */
+static uint16_t ex_get16(const uint8_t *p, bool big_endian) { return big_endian ? (p[0] << 8) | p[1] : (p[1] << 8) | p[0]; }
+
+/**
+ * @brief read a 32 bit value in the byte order of the block.
+ */
+static uint32_t ex_get32(const uint8_t *p, bool big_endian) {
+    return big_endian ? ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]
+                      : ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+/**
+ * @brief check that an IFD is inside the TIFF data.
+ *
+ * @param tiff the TIFF data.
+ * @param size its size.
+ * @param ifd offset of the IFD.
+ * @param big_endian byte order.
+ *
+ * @return the number of entries, 0 if the IFD is broken.
+ */
+static int ex_ifd_entries(const uint8_t *tiff, uint32_t size, uint32_t ifd, bool big_endian) {
+    if ((ifd < 8) || (ifd > size - 2)) {
+        return 0;
+    }
+    int num = ex_get16(&tiff[ifd], big_endian);
+    if ((uint64_t)ifd + 2 + (uint64_t)num * EX_IFD_ENTRY_SIZE + 4 > size) {
+        return 0;
+    }
+    return num;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief parse the payload of an APP1 marker.
+ *
+ * @param data the marker data (without marker and length).
+ * @param size its size.
+ * @param ex the result, the thumbnail points into data.
+ *
+ * @return true if this is an EXIF block, false for other APP1 data (e.g. XMP).
+ */
+bool ex_parse(const uint8_t *data, uint32_t size, exif_t *ex) {
+    memset(ex, 0, sizeof(exif_t));
+    ex->orientation = EX_TOP_LEFT;
+
+    if ((size < EX_HEADER_SIZE + 8) || memcmp(data, "Exif\0\0", EX_HEADER_SIZE)) {
+        return false;
+    }
+    const uint8_t *tiff = data + EX_HEADER_SIZE;
+    size -= EX_HEADER_SIZE;
+    if (!memcmp(tiff, "MM\0*", 4)) {
+        ex->big_endian = true;
+    } else if (memcmp(tiff, "II*\0", 4)) {
+        return false;
+    }
+    bool be = ex->big_endian;
+
+    // IFD0 has the orientation and points to IFD1
+    uint32_t ifd = ex_get32(&tiff[4], be);
+    int num = ex_ifd_entries(tiff, size, ifd, be);
+    for (int i = 0; i < num; i++) {
+        const uint8_t *e = &tiff[ifd + 2 + i * EX_IFD_ENTRY_SIZE];
+        if (ex_get16(e, be) == EX_TAG_ORIENTATION) {
+            int orientation = ex_get16(&e[8], be);
+            if ((orientation >= EX_TOP_LEFT) && (orientation <= EX_LEFT_BOTTOM)) {
+                ex->orientation = orientation;
+                ex->orientation_pos = EX_HEADER_SIZE + (e + 8 - tiff);
+            }
+        }
+    }
+    if (!num) {
+        return true;
+    }
+
+    // IFD1 describes the thumbnail
+    ifd = ex_get32(&tiff[ifd + 2 + num * EX_IFD_ENTRY_SIZE], be);
+    num = ex_ifd_entries(tiff, size, ifd, be);
+    uint32_t thumb_offset = 0;
+    uint32_t thumb_size = 0;
+    for (int i = 0; i < num; i++) {
+        const uint8_t *e = &tiff[ifd + 2 + i * EX_IFD_ENTRY_SIZE];
+        if (ex_get16(e, be) == EX_TAG_THUMB_OFFSET) {
+            thumb_offset = ex_get32(&e[8], be);
+        } else if (ex_get16(e, be) == EX_TAG_THUMB_LENGTH) {
+            thumb_size = ex_get32(&e[8], be);
+        }
+    }
+    if (thumb_offset && (thumb_size > 2) && (thumb_offset < size) && (thumb_size <= size - thumb_offset) && (tiff[thumb_offset] == 0xFF) &&
+        (tiff[thumb_offset + 1] == 0xD8)) {
+        ex->thumb = &tiff[thumb_offset];
+        ex->thumb_size = thumb_size;
+    }
+    return true;
+}
+
+/**
+ * @brief change the orientation tag in place, e.g. after the image was rotated. Nothing happens if there is no tag.
+ *
+ * @param data the block passed to ex_parse().
+ * @param ex the result of ex_parse().
+ * @param orientation the new orientation.
+ */
+void ex_set_orientation(uint8_t *data, const exif_t *ex, int orientation) {
+    if (!ex->orientation_pos) {
+        return;
+    }
+    uint8_t *p = &data[ex->orientation_pos];
+    if (ex->big_endian) {
+        p[0] = 0;
+        p[1] = orientation;
+    } else {
+        p[0] = orientation;
+        p[1] = 0;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __EXIF_H__
+#define __EXIF_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#define EX_TOP_LEFT 1      //!< orientation: the image is stored as it is shown
+#define EX_TOP_RIGHT 2     //!< orientation: mirrored horizontally
+#define EX_BOTTOM_RIGHT 3  //!< orientation: rotated by 180 degrees
+#define EX_BOTTOM_LEFT 4   //!< orientation: mirrored vertically
+#define EX_LEFT_TOP 5      //!< orientation: transposed (mirrored across the top left to bottom right diagonal)
+#define EX_RIGHT_TOP 6     //!< orientation: must be rotated 90 degrees clockwise
+#define EX_RIGHT_BOTTOM 7  //!< orientation: transversed (mirrored across the top right to bottom left diagonal)
+#define EX_LEFT_BOTTOM 8   //!< orientation: must be rotated 90 degrees counter clockwise
+
+/************
+** structs **
+************/
+//! what is used of the EXIF block of a JPEG (APP1 marker)
+typedef struct __exif {
+    int orientation;           //!< EX_TOP_LEFT..EX_LEFT_BOTTOM, EX_TOP_LEFT if there is no tag
+    uint32_t orientation_pos;  //!< offset of the orientation value in the block, 0 if there is no tag
+    bool big_endian;           //!< the block is in Motorola byte order
+    const uint8_t *thumb;      //!< embedded JPEG thumbnail (inside the block) or NULL
+    uint32_t thumb_size;       //!< size of the thumbnail in bytes
+} exif_t;
+
+/***********************
+** exported functions **
+***********************/
+extern bool ex_parse(const uint8_t *data, uint32_t size, exif_t *ex);
+extern void ex_set_orientation(uint8_t *data, const exif_t *ex, int orientation);
+
+#endif  // __EXIF_H__
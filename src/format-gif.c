@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "main.h"
+#include "format-gif.h"
+
+#include "algif.h"
+
+/**
+ * @brief load a GIF as 8bpp bitmap with its palette.
+ * algif's load_gif() renders into the current color depth, this keeps still images paletted. Animations are still
+ * rendered by algif because every frame can have its own palette.
+ *
+ * @param filename the name of the file
+ * @param pal receives the palette of the image
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_gif8(AL_CONST char *filename, RGB *pal) {
+    PALETTE tmppal;
+
+    GIF_ANIMATION *gif = algif_load_raw_animation(filename);
+    if (!gif) {
+        return NULL;
+    }
+    if (gif->frames_count != 1) {
+        DEBUGF("GIF has %d frames\n", gif->frames_count);
+        algif_destroy_raw_animation(gif);
+        return load_gif(filename, pal);
+    }
+
+    GIF_FRAME *f = &gif->frames[0];
+    GIF_PALETTE *gifpal = (f->palette.colors_count > 0) ? &f->palette : &gif->palette;
+
+    if (!pal) {
+        pal = tmppal;
+    }
+    for (int i = 0; i < PAL_SIZE; i++) {
+        if (i < gifpal->colors_count) {
+            pal[i].r = gifpal->colors[i].r / 4;
+            pal[i].g = gifpal->colors[i].g / 4;
+            pal[i].b = gifpal->colors[i].b / 4;
+        } else {
+            pal[i].r = pal[i].g = pal[i].b = 0;
+        }
+    }
+
+    DEBUGF("GIF is %dx%d with %d colors\n", gif->width, gif->height, gifpal->colors_count);
+    BITMAP *bm = create_bitmap_ex(8, gif->width, gif->height);
+    if (!bm) {
+        algif_destroy_raw_animation(gif);
+        return NULL;
+    }
+    clear_to_color(bm, gif->background_index);
+
+    // copy the frame indices, transparent pixels show the background
+    BITMAP *src = f->bitmap_8_bit;
+    for (int y = 0; y < src->h; y++) {
+        int dy = y + f->yoff;
+        if (dy < 0 || dy >= bm->h) {
+            continue;
+        }
+        for (int x = 0; x < src->w; x++) {
+            int dx = x + f->xoff;
+            int c = src->line[y][x];
+            if (dx >= 0 && dx < bm->w && c != f->transparent_index) {
+                bm->line[dy][dx] = c;
+            }
+        }
+    }
+
+    algif_destroy_raw_animation(gif);
+    return bm;
+}
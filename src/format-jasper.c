@@ -1,6 +1,7 @@
 #include "main.h"
 #include "jasper/jasper.h"
 #include "format-jasper.h"
+#include "sink.h"
 
 #ifdef DEBUG_ENABLED
 static int jp2_vlogmsgf_stdout(jas_logtype_t type, const char *fmt, va_list ap) {
@@ -10,7 +11,92 @@ static int jp2_vlogmsgf_stdout(jas_logtype_t type, const char *fmt, va_list ap)
 }
 #endif
 
-BITMAP *load_jasper(AL_CONST char *filename, RGB *pal) {
+/**
+ * @brief read the image size from the SIZ marker of a JPEG 2000 codestream.
+ *
+ * @param b the bytes following the SOC and SIZ markers.
+ * @param n number of bytes in b.
+ * @param p the probe to fill in.
+ *
+ * @return true for success.
+ */
+static bool jp2_siz(const uint8_t *b, size_t n, probe_t *p) {
+    // Lsiz, Rsiz, Xsiz, Ysiz, XOsiz, YOsiz, XTsiz, YTsiz, XTOsiz, YTOsiz, Csiz, Ssiz...
+    if (n < 39) {
+        return false;
+    }
+    uint32_t w = ((uint32_t)b[4] << 24) | (b[5] << 16) | (b[6] << 8) | b[7];
+    uint32_t h = ((uint32_t)b[8] << 24) | (b[9] << 16) | (b[10] << 8) | b[11];
+    uint32_t x0 = ((uint32_t)b[12] << 24) | (b[13] << 16) | (b[14] << 8) | b[15];
+    uint32_t y0 = ((uint32_t)b[16] << 24) | (b[17] << 16) | (b[18] << 8) | b[19];
+    p->width = w - x0;
+    p->height = h - y0;
+    p->components = (b[36] << 8) | b[37];
+    p->bits = (b[38] & 0x7F) + 1;
+    return (p->width > 0) && (p->height > 0);
+}
+
+/**
+ * @brief read size and layout of a JPEG 2000 image from its header.
+ * JasPer has no header only mode and allocates all components in jas_image_decode(), so the boxes of a JP2 file (or the
+ * SIZ marker of a raw codestream) are read directly.
+ *
+ * @param in the file
+ * @param p the probe to fill in
+ *
+ * @return true for success
+ */
+bool probe_jasper(input_t *in, probe_t *p) {
+    uint8_t b[64];
+
+    p->frames = 1;
+    strcpy(p->compression, "jpeg2000");
+
+    bool ret = false;
+    in_seek(in, 0);
+    size_t n = in_read(in, b, sizeof(b));
+    if ((n >= 4) && (b[0] == 0xFF) && (b[1] == 0x4F) && (b[2] == 0xFF) && (b[3] == 0x51)) {
+        ret = jp2_siz(&b[4], n - 4, p);
+    } else {
+        // walk the boxes until the image header box, 'jp2h' is a super box so its children are walked as well
+        uint64_t pos = 0;
+        while (in_seek(in, pos) && (in_read(in, b, 22) == 22)) {
+            uint32_t len = ((uint32_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+            if (!memcmp(&b[4], "jp2h", 4)) {
+                pos += 8;
+            } else if (!memcmp(&b[4], "ihdr", 4)) {
+                p->height = ((uint32_t)b[8] << 24) | (b[9] << 16) | (b[10] << 8) | b[11];
+                p->width = ((uint32_t)b[12] << 24) | (b[13] << 16) | (b[14] << 8) | b[15];
+                p->components = (b[16] << 8) | b[17];
+                p->bits = (b[18] == 0xFF) ? 0 : (b[18] & 0x7F) + 1;
+                ret = (p->width > 0) && (p->height > 0);
+                break;
+            } else if (len < 8) {
+                break;  // box extends to the end of the file or has a 64 bit length, the header comes before those
+            } else {
+                pos += len;
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief decode a JPEG 2000 (or other JasPer format) image from an input.
+ * JasPer streams can't be backed by callbacks, so the decoder reads the whole file from memory.
+ *
+ * @param in the file
+ * @param pal pallette (is ignored)
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_jasper_in(input_t *in, RGB *pal) {
+    const uint8_t *data = in_contents(in);
+    if (!data || !in->size) {
+        return NULL;
+    }
+
+
     // init jasper
     jas_conf_clear();
     static jas_std_allocator_t allocator;
@@ -36,24 +122,25 @@ BITMAP *load_jasper(AL_CONST char *filename, RGB *pal) {
 
     DEBUGF("LOAD: jasper initialized\n");
 
-    // open image stream
-    jas_stream_t *in;
-    if (!(in = jas_stream_fopen(filename, "rb"))) {
-        DEBUGF("error: cannot open input image file %s\n", filename);
+    // open image stream, the stream only reads from the buffer
+    jas_stream_t *stream;
+    if (!(stream = jas_stream_memopen((char *)data, in->size))) {
+        DEBUGF("error: cannot open input image file %s\n", in->filename);
         jas_cleanup_thread();
         jas_cleanup_library();
         return NULL;
     }
 
-    // load image data
+    // load image data, previews only decode the first quality layer
     jas_image_t *image;
-    if (!(image = jas_image_decode(in, -1, ""))) {
+    if (!(image = jas_image_decode(stream, -1, load_preview ? "maxlyrs=1" : ""))) {
         DEBUGF("error: cannot load image data\n");
+        jas_stream_close(stream);
         jas_cleanup_thread();
         jas_cleanup_library();
         return NULL;
     }
-    jas_stream_close(in);
+    jas_stream_close(stream);
 
     int components = jas_image_numcmpts(image);
     DEBUGF("num components = %d\n", components);
@@ -92,8 +179,8 @@ BITMAP *load_jasper(AL_CONST char *filename, RGB *pal) {
     jas_cmprof_destroy(outprof);
 
     // create bitmap
-    BITMAP *bm = create_bitmap_ex(32, width, height);
-    if (!bm) {
+    sink_t sk;
+    if (!sk_begin(&sk, width, height, pal, SK_RGB, load_shrink)) {
         DEBUGF("Can't create bitmap\n");
         jas_image_destroy(image);
         jas_image_destroy(altimage);
@@ -101,13 +188,25 @@ BITMAP *load_jasper(AL_CONST char *filename, RGB *pal) {
         jas_cleanup_library();
         return NULL;
     }
-    DEBUGF("bm = %p\n", bm);
+    DEBUGF("bm = %p\n", sk.bm);
 
     int comp_r, comp_g, comp_b;
     if ((comp_r = jas_image_getcmptbytype(altimage, JAS_IMAGE_CT_COLOR(JAS_CLRSPC_CHANIND_RGB_R))) < 0 ||
         (comp_g = jas_image_getcmptbytype(altimage, JAS_IMAGE_CT_COLOR(JAS_CLRSPC_CHANIND_RGB_G))) < 0 ||
         (comp_b = jas_image_getcmptbytype(altimage, JAS_IMAGE_CT_COLOR(JAS_CLRSPC_CHANIND_RGB_B))) < 0) {
         DEBUGF("Can't create components\n");
+        sk_abort(&sk);
+        jas_image_destroy(image);
+        jas_image_destroy(altimage);
+        jas_cleanup_thread();
+        jas_cleanup_library();
+        return NULL;
+    }
+
+    uint8_t *row = malloc(width * SK_RGB);
+    if (!row) {
+        DEBUGF("Can't allocate row\n");
+        sk_abort(&sk);
         jas_image_destroy(image);
         jas_image_destroy(altimage);
         jas_cleanup_thread();
@@ -116,22 +215,43 @@ BITMAP *load_jasper(AL_CONST char *filename, RGB *pal) {
     }
 
     for (int y = 0; y < height; y++) {
+        if (!sk_progress(y, height)) {
+            free(row);
+            sk_abort(&sk);
+            jas_image_destroy(image);
+            jas_image_destroy(altimage);
+            jas_cleanup_thread();
+            jas_cleanup_library();
+            return NULL;
+        }
+        uint8_t *ptr = row;
         for (int x = 0; x < width; x++) {
-            bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = jas_image_readcmptsample(image, comp_r, x, y);
-            bm->line[y][x * 4 + _rgb_g_shift_32 / 8] = jas_image_readcmptsample(image, comp_g, x, y);
-            bm->line[y][x * 4 + _rgb_b_shift_32 / 8] = jas_image_readcmptsample(image, comp_b, x, y);
-            bm->line[y][x * 4 + _rgb_a_shift_32 / 8] = 0xFF;
+            *ptr++ = jas_image_readcmptsample(image, comp_r, x, y);
+            *ptr++ = jas_image_readcmptsample(image, comp_g, x, y);
+            *ptr++ = jas_image_readcmptsample(image, comp_b, x, y);
         }
+        sk_put_row(&sk, y, row);
     }
+    free(row);
 
     jas_image_destroy(image);
     jas_image_destroy(altimage);
     jas_cleanup_thread();
     jas_cleanup_library();
 
-    return bm;
+    return sk_finish(&sk);
 }
 
+/**
+ * @brief load from file system.
+ *
+ * @param filename the name of the file
+ * @param pal pallette (is ignored)
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_jasper(AL_CONST char *filename, RGB *pal) { return in_load(filename, pal, load_jasper_in); }
+
 int save_jasper(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
     char outopts[100];
     snprintf(outopts, sizeof(outopts), "rate=%f", (float)output_quality / 100.0f);
@@ -218,21 +338,31 @@ int save_jasper(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
         }
     }
 
+    uint8_t *row = malloc(bm->w * SK_RGB);
+    if (!row) {
+        DEBUGF("error: cannot allocate row\n");
+        for (int cmptno = 0; cmptno < NUM_COMPONENTS; ++cmptno) {
+            jas_matrix_destroy(data[cmptno]);
+        }
+        jas_image_destroy(image);
+        jas_stream_close(out);
+        jas_cleanup_thread();
+        jas_cleanup_library();
+        return -1;
+    }
+
     for (int y = 0; y < bm->h; ++y) {
+        sk_read_row(bm, y, row, SK_RGB, pal);
         for (int x = 0; x < bm->w; ++x) {
-            uint32_t argb = getpixel(bm, x, y);
-            int_fast64_t r = (argb >> 16) & 0xFF;
-            int_fast64_t g = (argb >> 8) & 0xFF;
-            int_fast64_t b = argb & 0xFF;
-
-            jas_matrix_set(data[0], 0, x, r);
-            jas_matrix_set(data[1], 0, x, g);
-            jas_matrix_set(data[2], 0, x, b);
+            jas_matrix_set(data[0], 0, x, row[x * SK_RGB + 0]);
+            jas_matrix_set(data[1], 0, x, row[x * SK_RGB + 1]);
+            jas_matrix_set(data[2], 0, x, row[x * SK_RGB + 2]);
         }
 
         for (int cmptno = 0; cmptno < NUM_COMPONENTS; ++cmptno) {
             if (jas_image_writecmpt(image, cmptno, 0, y, bm->w, 1, data[cmptno])) {
                 DEBUGF("error: cannot write component\n");
+                free(row);
                 for (int cmptno = 0; cmptno < NUM_COMPONENTS; ++cmptno) {
                     jas_matrix_destroy(data[cmptno]);
                 }
@@ -245,6 +375,8 @@ int save_jasper(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
         }
     }
 
+    free(row);
+
     if (jas_image_encode(image, out, outfmt, outopts)) {
         DEBUGF("error: cannot encode image\n");
         for (int cmptno = 0; cmptno < NUM_COMPONENTS; ++cmptno) {
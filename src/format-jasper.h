@@ -24,8 +24,12 @@ SOFTWARE.
 #define __FORMAT_JASPER__
 
 #include "main.h"
+#include "probe.h"
+#include "input.h"
 
 extern BITMAP *load_jasper(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_jasper_in(input_t *in, RGB *pal);
+extern bool probe_jasper(input_t *in, probe_t *p);
 extern int save_jasper(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal);
 
 #endif  // __FORMAT_JASPER__
@@ -1,5 +1,11 @@
 #include "main.h"
 #include "format-jpeg.h"
+#include "sink.h"
+#include "util.h"
+#include "stats.h"
+#include "trace.h"
+#include "exif.h"
+#include "thumbs.h"
 
 /*
  * Include file for users of JPEG library.
@@ -10,6 +16,8 @@
  */
 
 #include "jpeglib.h"
+#include "jerror.h"
+#include "transupp.h"
 
 /*
  * <setjmp.h> is used for the optional error recovery mechanism shown in
@@ -66,7 +74,385 @@ my_error_exit(j_common_ptr cinfo) {
     longjmp(myerr->setjmp_buffer, 1);
 }
 
-BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
+/*
+ * DATA SOURCE:
+ *
+ * Instead of jpeg_stdio_src() the compressed data comes from an input_t. The
+ * buffer of the input (or the mapped file) is handed to the library directly,
+ * so nothing is copied between the file and the decoder.
+ */
+
+//! libjpeg data source reading from an input
+typedef struct __jpeg_input_src {
+    struct jpeg_source_mgr pub;  //!< "public" fields
+    input_t *in;                 //!< the input
+} jpeg_input_src_t;
+
+static const JOCTET jpeg_eoi[2] = {0xFF, JPEG_EOI};  //!< inserted at the end of a truncated file
+
+METHODDEF(void)
+jpeg_input_init(j_decompress_ptr cinfo) {}
+
+METHODDEF(boolean)
+jpeg_input_fill(j_decompress_ptr cinfo) {
+    jpeg_input_src_t *src = (jpeg_input_src_t *)cinfo->src;
+    size_t avail;
+
+    const uint8_t *data = in_data(src->in, &avail);
+    if (!data) {
+        // a truncated file is ended with an EOI marker, like jpeg_stdio_src() does
+        WARNMS(cinfo, JWRN_JPEG_EOF);
+        src->pub.next_input_byte = jpeg_eoi;
+        src->pub.bytes_in_buffer = sizeof(jpeg_eoi);
+        return TRUE;
+    }
+    in_skip(src->in, avail);
+    src->pub.next_input_byte = data;
+    src->pub.bytes_in_buffer = avail;
+    return TRUE;
+}
+
+METHODDEF(void)
+jpeg_input_skip(j_decompress_ptr cinfo, long num_bytes) {
+    jpeg_input_src_t *src = (jpeg_input_src_t *)cinfo->src;
+
+    if (num_bytes <= 0) {
+        return;
+    }
+    if ((size_t)num_bytes <= src->pub.bytes_in_buffer) {
+        src->pub.next_input_byte += num_bytes;
+        src->pub.bytes_in_buffer -= num_bytes;
+    } else {
+        // large markers (e.g. EXIF thumbnails) are skipped without reading them
+        in_skip(src->in, num_bytes - src->pub.bytes_in_buffer);
+        src->pub.next_input_byte = NULL;
+        src->pub.bytes_in_buffer = 0;
+    }
+}
+
+METHODDEF(void)
+jpeg_input_term(j_decompress_ptr cinfo) {}
+
+/**
+ * @brief use an input as data source, replaces jpeg_stdio_src().
+ *
+ * @param cinfo the decompressor.
+ * @param in the input, reading starts at the beginning of the file.
+ */
+static void jpeg_input_src(j_decompress_ptr cinfo, input_t *in) {
+    jpeg_input_src_t *src = (jpeg_input_src_t *)(*cinfo->mem->alloc_small)((j_common_ptr)cinfo, JPOOL_PERMANENT, sizeof(jpeg_input_src_t));
+    src->pub.init_source = jpeg_input_init;
+    src->pub.fill_input_buffer = jpeg_input_fill;
+    src->pub.skip_input_data = jpeg_input_skip;
+    src->pub.resync_to_restart = jpeg_resync_to_restart;
+    src->pub.term_source = jpeg_input_term;
+    src->pub.next_input_byte = NULL;
+    src->pub.bytes_in_buffer = 0;
+    src->in = in;
+    cinfo->src = &src->pub;
+    in_seek(in, 0);
+}
+
+/*
+ * EXIF ORIENTATION:
+ *
+ * Cameras store the pixels as the sensor saw them and put the way the image
+ * is meant to be shown into the EXIF block. Loaded images are turned with
+ * sk_orient(), lossless transforms rearrange the DCT blocks instead.
+ */
+
+//! how to show an image with an EXIF orientation
+typedef struct __jpeg_orientation {
+    bool transpose;  //!< sk_orient(): swap rows and columns
+    bool mirror_h;   //!< sk_orient(): then mirror left and right
+    bool mirror_v;   //!< sk_orient(): then mirror top and bottom
+    bool flip;       //!< lossless: mirror left and right
+    int rotate;      //!< lossless: then rotate clockwise by this many degrees
+} jpeg_orientation_t;
+
+//! indexed by EXIF orientation (EX_TOP_LEFT..EX_LEFT_BOTTOM)
+static const jpeg_orientation_t jpeg_orientations[EX_LEFT_BOTTOM + 1] = {
+    {false, false, false, false, 0},   // unused
+    {false, false, false, false, 0},   // EX_TOP_LEFT
+    {false, true, false, true, 0},     // EX_TOP_RIGHT
+    {false, true, true, false, 180},   // EX_BOTTOM_RIGHT
+    {false, false, true, true, 180},   // EX_BOTTOM_LEFT
+    {true, false, false, true, 270},   // EX_LEFT_TOP
+    {true, true, false, false, 90},    // EX_RIGHT_TOP
+    {true, true, true, true, 90},      // EX_RIGHT_BOTTOM
+    {true, false, true, false, 270},   // EX_LEFT_BOTTOM
+};
+
+/**
+ * @brief find the EXIF block among the markers saved by jpeg_save_markers().
+ *
+ * @param cinfo the decompressor after jpeg_read_header().
+ * @param ex the parsed block, orientation EX_TOP_LEFT and no thumbnail if there is none.
+ *
+ * @return the marker with the block or NULL.
+ */
+static jpeg_saved_marker_ptr jpeg_read_exif(j_decompress_ptr cinfo, exif_t *ex) {
+    for (jpeg_saved_marker_ptr m = cinfo->marker_list; m; m = m->next) {
+        if ((m->marker == JPEG_APP0 + 1) && ex_parse(m->data, m->data_length, ex)) {
+            DEBUGF("EXIF orientation %d, thumbnail %lu bytes\n", ex->orientation, (unsigned long)ex->thumb_size);
+            return m;
+        }
+    }
+    ex_parse(NULL, 0, ex);
+    return NULL;
+}
+
+/**
+ * @brief turn a loaded image the way the EXIF orientation says.
+ *
+ * @param bm the image, it is destroyed if a new one is returned.
+ * @param orientation EX_TOP_LEFT..EX_LEFT_BOTTOM.
+ *
+ * @return the turned image.
+ */
+static BITMAP *jpeg_orient(BITMAP *bm, int orientation) {
+    const jpeg_orientation_t *o = &jpeg_orientations[orientation];
+    return sk_orient(bm, o->transpose, o->mirror_h, o->mirror_v);
+}
+
+/**
+ * @brief decode the JPEG thumbnail of an EXIF block, it is small enough to be decoded in one go.
+ *
+ * @param data the thumbnail.
+ * @param size its size.
+ * @param pal palette for 8bpp images.
+ *
+ * @return BITMAP* or NULL if decoding fails.
+ */
+static BITMAP *jpeg_load_thumbnail(const uint8_t *data, uint32_t size, RGB *pal) {
+    struct jpeg_decompress_struct cinfo;
+    struct my_error_mgr jerr;
+    sink_t sk;
+
+    memset(&sk, 0, sizeof(sk));
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = my_error_exit;
+    if (setjmp(jerr.setjmp_buffer)) {
+        sk_abort(&sk);
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (unsigned char *)data, size);
+    (void)jpeg_read_header(&cinfo, TRUE);
+    cinfo.dct_method = JDCT_IFAST;
+    (void)jpeg_start_decompress(&cinfo);
+
+    if (((cinfo.output_components != 1) && (cinfo.output_components != 3)) ||
+        !sk_begin(&sk, cinfo.output_width, cinfo.output_height, pal, cinfo.output_components == 1 ? SK_GRAY : SK_RGB, 1)) {
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+    JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.output_width * cinfo.output_components, 1);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        (void)jpeg_read_scanlines(&cinfo, buffer, 1);
+        sk_put_row(&sk, cinfo.output_scanline - 1, buffer[0]);
+    }
+    (void)jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return sk_finish(&sk);
+}
+
+/**
+ * @brief pass the EXIF thumbnail to load_scan(), so there is something to look at while the image is decoded.
+ *
+ * @param ex the EXIF block with a thumbnail.
+ * @param pal palette passed to the loader.
+ *
+ * @return false if loading was aborted.
+ */
+static bool jpeg_show_thumbnail(const exif_t *ex, RGB *pal) {
+    BITMAP *thumb = jpeg_load_thumbnail(ex->thumb, ex->thumb_size, pal);
+    if (!thumb) {
+        return true;
+    }
+    thumb = jpeg_orient(thumb, ex->orientation);
+    DEBUGF("EXIF thumbnail is %dx%d\n", thumb->w, thumb->h);
+
+    st_push(ST_OTHER);
+    bool go_on = load_scan(thumb, pal, true);
+    st_pop();
+    destroy_bitmap(thumb);
+    return go_on;
+}
+
+/**
+ * @brief use the EXIF thumbnail as the preview of an image (see load_preview), the entropy data is not decoded at all then.
+ * Thumbnails smaller than TH_SIZE or with an other aspect ratio than the image (black bars) are not used.
+ *
+ * @param cinfo the decompressor after jpeg_read_header().
+ * @param ex the EXIF block with a thumbnail.
+ * @param pal palette passed to the loader.
+ *
+ * @return the oriented thumbnail or NULL if the image must be decoded.
+ */
+static BITMAP *jpeg_preview_thumbnail(j_decompress_ptr cinfo, const exif_t *ex, RGB *pal) {
+    BITMAP *thumb = jpeg_load_thumbnail(ex->thumb, ex->thumb_size, pal);
+    if (!thumb) {
+        return NULL;
+    }
+
+    // the thumbnail is stored like the image, both are turned afterwards
+    long iw = cinfo->image_width;
+    long ih = cinfo->image_height;
+    if ((MAX(thumb->w, thumb->h) < TH_SIZE) || (labs(thumb->w * ih - thumb->h * iw) > MAX(iw, ih))) {
+        DEBUGF("EXIF thumbnail %dx%d can't replace %ldx%ld\n", thumb->w, thumb->h, iw, ih);
+        destroy_bitmap(thumb);
+        return NULL;
+    }
+    return jpeg_orient(thumb, ex->orientation);
+}
+
+/*
+ * DECODING QUALITY:
+ *
+ * load_quality picks the IDCT, chroma upsampling and block smoothing, see
+ * jpeg_set_decoding(). The rows are fetched JPEG_READ_ROWS at a time, so one
+ * jpeg_read_scanlines() call hands over a whole iMCU row (8 or 16 lines).
+ */
+
+#define JPEG_READ_ROWS 16  //!< rows passed to jpeg_read_scanlines() at once
+
+/**
+ * @brief set the speed/quality trade-off of the decompressor.
+ * LOAD_FAST uses the inexact integer IDCT, plain pixel replication for chroma and no block smoothing for progressive scans.
+ * LOAD_NORMAL keeps the library defaults (accurate integer IDCT, fancy upsampling, block smoothing).
+ * LOAD_BEST uses the float IDCT if there is an FPU, the color quantization for 8bpp is set up by the caller.
+ *
+ * @param cinfo the decompressor after jpeg_read_header().
+ * @param quality LOAD_FAST, LOAD_NORMAL or LOAD_BEST.
+ */
+static void jpeg_set_decoding(j_decompress_ptr cinfo, int quality) {
+    switch (quality) {
+        case LOAD_FAST:
+            cinfo->dct_method = JDCT_IFAST;
+            cinfo->do_fancy_upsampling = FALSE;
+            cinfo->do_block_smoothing = FALSE;
+            break;
+        case LOAD_BEST:
+            // without FPU the float IDCT is emulated and takes ages
+            if (cpu_capabilities & CPU_FPU) {
+                cinfo->dct_method = JDCT_FLOAT;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief run one output pass of the decompressor and put all rows into the sink.
+ *
+ * @param cinfo the decompressor.
+ * @param sk the sink.
+ * @param buffer JPEG_READ_ROWS rows of output_width * output_components samples.
+ * @param done progress reported for the first row, see sk_progress().
+ * @param total total progress, 0 to report nothing.
+ *
+ * @return false if loading was aborted.
+ */
+static bool jpeg_read_rows(j_decompress_ptr cinfo, sink_t *sk, JSAMPARRAY buffer, uint32_t done, uint32_t total) {
+    /* Here we use the library's state variable cinfo.output_scanline as the
+     * loop counter, so that we don't have to keep track ourselves.
+     */
+    while (cinfo->output_scanline < cinfo->output_height) {
+        if (total && !sk_progress(done + cinfo->output_scanline, total)) {
+            return false;
+        }
+
+        /* jpeg_read_scanlines expects an array of pointers to scanlines.
+         * It returns at most one iMCU row, so fewer rows than asked for may come back.
+         */
+        JDIMENSION first = cinfo->output_scanline;
+        TRACE_BEGIN_ARG("jpeg scanlines", first);
+        JDIMENSION numread = jpeg_read_scanlines(cinfo, buffer, JPEG_READ_ROWS);
+        TRACE_END("jpeg scanlines");
+
+        for (JDIMENSION i = 0; i < numread; i++) {
+            sk_put_row(sk, first + i, buffer[i]);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief decode a progressive JPEG scan by scan in buffered-image mode, load_scan() gets the image after each scan if previews are wanted.
+ * Every preview is a complete output pass (IDCT and color conversion of the whole image). To keep the total time in check a scan
+ * is only shown if absorbing the scans since the last preview took at least as long as that preview, the final scan is always decoded.
+ * Absorbing the file counts as the first half of the progress, the final output pass as the second.
+ *
+ * @param cinfo the decompressor, started with buffered_image set.
+ * @param sk the sink.
+ * @param buffer JPEG_READ_ROWS rows of output_width * output_components samples.
+ * @param pal palette passed to the loader.
+ * @param previews pass the scans to load_scan().
+ *
+ * @return false if loading was aborted.
+ */
+static bool jpeg_read_scans(j_decompress_ptr cinfo, sink_t *sk, JSAMPARRAY buffer, RGB *pal, bool previews) {
+    input_t *in = ((jpeg_input_src_t *)cinfo->src)->in;
+    uint32_t height = cinfo->output_height;
+    J_DCT_METHOD dct_method = cinfo->dct_method;
+    uint64_t pass_time = 0;
+    uint64_t since = ut_time_us();
+    bool final = false;
+
+    while (!final) {
+        // absorb the next scan, the input stops at the start of the following one or at the end of the file
+        int ret;
+        TRACE_BEGIN_ARG("jpeg scan", cinfo->input_scan_number);
+        do {
+            ret = jpeg_consume_input(cinfo);
+            uint64_t pos = in->pos - cinfo->src->bytes_in_buffer;
+            if (!sk_progress(in->size ? (uint32_t)(pos * height / in->size) : 0, 2 * height)) {
+                TRACE_END("jpeg scan");
+                return false;
+            }
+        } while ((ret == JPEG_ROW_COMPLETED) || (ret == JPEG_SCAN_COMPLETED));
+        TRACE_END("jpeg scan");
+        final = (ret != JPEG_REACHED_SOS);
+        if (!final && (!previews || (ut_time_us() - since < pass_time))) {
+            continue;
+        }
+
+        // the previews don't need the accurate IDCT, the scan just started is not shown before it is complete
+        uint64_t start = ut_time_us();
+        cinfo->dct_method = final ? dct_method : JDCT_IFAST;
+        (void)jpeg_start_output(cinfo, final ? cinfo->input_scan_number : cinfo->input_scan_number - 1);
+        if (!jpeg_read_rows(cinfo, sk, buffer, height, final ? 2 * height : 0)) {
+            return false;
+        }
+        (void)jpeg_finish_output(cinfo);
+        DEBUGF("JPEG scan %d (%s) took %luus\n", cinfo->output_scan_number, final ? "final" : "preview", (unsigned long)(ut_time_us() - start));
+
+        if (!final) {
+            st_push(ST_OTHER);
+            bool go_on = load_scan(sk->bm, pal, false);
+            st_pop();
+            if (!go_on) {
+                return false;
+            }
+            pass_time = ut_time_us() - start;
+            since = ut_time_us();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief decode a JPEG from an input.
+ *
+ * @param in the file
+ * @param pal pallette for 8bpp images
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_jpeg_in(input_t *in, RGB *pal) {
     /* This struct contains the JPEG decompression parameters and pointers to
      * working space (which is allocated as needed by the JPEG library).
      */
@@ -77,20 +463,11 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
      */
     struct my_error_mgr jerr;
     /* More stuff */
-    FILE *infile;      /* source file */
     JSAMPARRAY buffer; /* Output row buffer */
     int row_stride;    /* physical row width in output buffer */
+    sink_t sk;         /* receives the decoded rows */
 
-    /* In this example we want to open the input file before doing anything else,
-     * so that the setjmp() error recovery below can assume the file is open.
-     * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-     * requires it in order to read binary files.
-     */
-
-    if ((infile = fopen(filename, "rb")) == NULL) {
-        DEBUGF("can't open %s\n", filename);
-        return NULL;
-    }
+    memset(&sk, 0, sizeof(sk));
 
     /* Step 1: allocate and initialize JPEG decompression object */
 
@@ -102,8 +479,8 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
         /* If we get here, the JPEG code has signaled an error.
          * We need to clean up the JPEG object, close the input file, and return.
          */
+        sk_abort(&sk);
         jpeg_destroy_decompress(&cinfo);
-        fclose(infile);
         return NULL;
     }
     /* Now we can initialize the JPEG decompression object. */
@@ -111,10 +488,11 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
 
     /* Step 2: specify data source (eg, a file) */
 
-    jpeg_stdio_src(&cinfo, infile);
+    jpeg_input_src(&cinfo, in);
 
     /* Step 3: read file parameters with jpeg_read_header() */
 
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
     (void)jpeg_read_header(&cinfo, TRUE);
     /* We can ignore the return value from jpeg_read_header since
      *   (a) suspension is not possible with the stdio data source, and
@@ -122,11 +500,57 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
      * See libjpeg.txt for more info.
      */
 
+    /* The camera's thumbnail is a ready made preview, else it is shown until the first scan or the whole image is there */
+    exif_t ex;
+    jpeg_read_exif(&cinfo, &ex);
+    if (load_preview && ex.thumb && !load_tiles) {
+        BITMAP *thumb = jpeg_preview_thumbnail(&cinfo, &ex, pal);
+        if (thumb) {
+            jpeg_destroy_decompress(&cinfo);
+            return thumb;
+        }
+    }
+    if (load_scan && ex.thumb && !load_tiles && !jpeg_show_thumbnail(&ex, pal)) {
+        DEBUG("JPEG loading aborted\n");
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+
     /* Step 4: set parameters for decompression */
 
-    /* In this example, we don't need to change any of the defaults set by
-     * jpeg_read_header(), so we do nothing here.
+    /* libjpeg can reduce by 1/2, 1/4 and 1/8 while decoding, which is much
+     * cheaper than decoding the full image. The sink does the rest.
+     * The tile store needs the full size rows.
      */
+    int shrink = MAX(load_shrink, 1);
+    int native = 1;
+    while (!load_tiles && (native < 8) && (shrink % (native * 2) == 0)) {
+        native *= 2;
+    }
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = native;
+    shrink /= native;
+
+    /* Previews don't need the accurate IDCT and upsampling */
+    jpeg_set_decoding(&cinfo, load_preview ? LOAD_FAST : load_quality);
+
+    /* At 8bpp the best quality is a palette made for the image (two passes, Floyd-Steinberg dithered) instead of the
+     * fixed 3-3-2 palette of the sink. The indices can't be averaged, so this only works without further reduction.
+     */
+    bool quantize = (load_quality == LOAD_BEST) && !load_preview && (load_depth == 8) && pal && (cinfo.out_color_space == JCS_RGB) &&
+                    (shrink == 1) && !load_tiles;
+    if (quantize) {
+        cinfo.quantize_colors = TRUE;
+        cinfo.two_pass_quantize = TRUE;
+        cinfo.dither_mode = JDITHER_FS;
+        cinfo.desired_number_of_colors = PAL_SIZE;
+    }
+
+    /* Progressive images are absorbed scan by scan if someone wants to see them or how far loading is (not for the tile store
+     * and the quantizer), else jpeg_start_decompress() reads the whole file at once.
+     */
+    bool scans = (load_scan || load_progress) && !load_tiles && !quantize && jpeg_has_multiple_scans(&cinfo);
+    cinfo.buffered_image = scans;
 
     /* Step 5: Start decompressor */
 
@@ -140,17 +564,25 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
     if ((cinfo.num_components != 1) && (cinfo.num_components != 3)) {
         DEBUGF("Wrong number of components: %d", cinfo.num_components);
         jpeg_destroy_decompress(&cinfo);
-        fclose(infile);
         return NULL;
     }
 
-    BITMAP *bm = create_bitmap_ex(32, cinfo.output_width, cinfo.output_height);
-    if (!bm) {
+    /* Quantized rows are palette indices, the sink copies them unchanged like gray rows */
+    int format = (cinfo.output_components == 1) ? SK_GRAY : SK_RGB;
+    if (!sk_begin(&sk, cinfo.output_width, cinfo.output_height, pal, format, shrink)) {
         DEBUGF("Can't create bitmap: %s", allegro_error);
         jpeg_destroy_decompress(&cinfo);
-        fclose(infile);
         return NULL;
     }
+    if (quantize) {
+        DEBUGF("JPEG quantized to %d colors\n", cinfo.actual_number_of_colors);
+        for (int i = 0; i < PAL_SIZE; i++) {
+            bool used = i < cinfo.actual_number_of_colors;
+            pal[i].r = used ? cinfo.colormap[0][i] >> 2 : 0;
+            pal[i].g = used ? cinfo.colormap[1][i] >> 2 : 0;
+            pal[i].b = used ? cinfo.colormap[2][i] >> 2 : 0;
+        }
+    }
 
     /* We may need to do some setup of our own at this point before reading
      * the data.  After jpeg_start_decompress() we have the correct scaled
@@ -160,38 +592,19 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
      */
     /* JSAMPLEs per row in output buffer */
     row_stride = cinfo.output_width * cinfo.output_components;
-    /* Make a one-row-high sample array that will go away when done with image */
-    buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, 1);
+    /* Make a sample array for JPEG_READ_ROWS rows that will go away when done with image */
+    buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, JPEG_READ_ROWS);
 
     /* Step 6: while (scan lines remain to be read) */
     /*           jpeg_read_scanlines(...); */
-
-    /* Here we use the library's state variable cinfo.output_scanline as the
-     * loop counter, so that we don't have to keep track ourselves.
-     */
-    while (cinfo.output_scanline < cinfo.output_height) {
-        /* jpeg_read_scanlines expects an array of pointers to scanlines.
-         * Here the array is only one element long, but you could ask for
-         * more than one scanline at a time if that's more convenient.
-         */
-        int numread = jpeg_read_scanlines(&cinfo, buffer, 1);
-        (void)numread;
-        // DEBUGF("num read = %d, current = %d\n", numread, cinfo.output_scanline);
-        /* Assume put_scanline_someplace wants a pointer and sample count. */
-        // put_scanline_someplace(buffer[0], row_stride);
-
-        for (int x = 0; x < cinfo.output_width; x++) {
-            unsigned int xIdx = x * cinfo.output_components;
-            if (cinfo.num_components == 1) {
-                bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_r_shift_32 / 8] = bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_g_shift_32 / 8] =
-                    bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_b_shift_32 / 8] = buffer[0][xIdx];
-            } else {
-                bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_r_shift_32 / 8] = buffer[0][0 + xIdx];
-                bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_g_shift_32 / 8] = buffer[0][1 + xIdx];
-                bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_b_shift_32 / 8] = buffer[0][2 + xIdx];
-            }
-            bm->line[cinfo.output_scanline - 1][x * 4 + _rgb_a_shift_32 / 8] = 0xFF;
-        }
+    /* Scans of a turned image would be shown sideways, the thumbnail has to do */
+    bool previews = load_scan && (ex.orientation == EX_TOP_LEFT);
+    bool ok = scans ? jpeg_read_scans(&cinfo, &sk, buffer, pal, previews) : jpeg_read_rows(&cinfo, &sk, buffer, 0, cinfo.output_height);
+    if (!ok) {
+        DEBUG("JPEG loading aborted\n");
+        sk_abort(&sk);
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
     }
 
     /* Step 7: Finish decompression */
@@ -206,23 +619,34 @@ BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) {
     /* This is an important step since it will release a good deal of memory. */
     jpeg_destroy_decompress(&cinfo);
 
-    /* After finish_decompress, we can close the input file.
-     * Here we postpone it until after no more JPEG errors are possible,
-     * so as to simplify the setjmp error logic above.  (Actually, I don't
-     * think that jpeg_destroy can do an error exit, but why assume anything...)
-     */
-    fclose(infile);
-
     /* At this point you may want to check to see whether any corrupt-data
      * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
      */
 
+    /* The tile store keeps the image as it is stored */
+    BITMAP *bm = sk_finish(&sk);
+    if (bm && !load_tiles && (ex.orientation != EX_TOP_LEFT)) {
+        bm = jpeg_orient(bm, ex.orientation);
+    }
+
     /* And we're done! */
     return bm;
 }
 
+/**
+ * @brief load from file system.
+ *
+ * @param filename the name of the file
+ * @param pal pallette for 8bpp images
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal) { return in_load(filename, pal, load_jpeg_in); }
+
 int save_jpeg(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
-    const int NUM_COMPONENTS = 3;
+    // 8bpp gray images are written as grayscale JPEG
+    const bool gray = (bitmap_color_depth(bm) == 8) && sk_is_gray(pal ? pal : _current_palette);
+    const int NUM_COMPONENTS = gray ? 1 : 3;
 
     /* This struct contains the JPEG compression parameters and pointers to
      * working space (which is allocated as needed by the JPEG library).
@@ -278,7 +702,7 @@ int save_jpeg(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
     cinfo.image_width = bm->w; /* image width and height, in pixels */
     cinfo.image_height = bm->h;
     cinfo.input_components = NUM_COMPONENTS; /* # of color components per pixel */
-    cinfo.in_color_space = JCS_RGB;          /* colorspace of input image */
+    cinfo.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB; /* colorspace of input image */
     /* Now use the library's routine to set default compression parameters.
      * (You must set at least cinfo.in_color_space before calling this,
      * since the defaults depend on the source color space.)
@@ -306,7 +730,7 @@ int save_jpeg(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
      */
     row_stride = bm->w * NUM_COMPONENTS; /* JSAMPLEs per row in image_buffer */
 
-    uint8_t *rgba = malloc(row_stride * NUM_COMPONENTS);
+    uint8_t *rgba = malloc(row_stride);
     if (!rgba) {
         fclose(outfile);
         jpeg_destroy_compress(&cinfo);
@@ -318,22 +742,13 @@ int save_jpeg(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
          * Here the array is only one element long, but you could pass
          * more than one scanline at a time if that's more convenient.
          */
-        uint8_t *ptr = rgba;
-        int y = cinfo.next_scanline;
-        for (int x = 0; x < bm->w; x++) {
-            uint32_t argb = getpixel(bm, x, y);
-            uint8_t r = (argb >> 16) & 0xFF;
-            uint8_t g = (argb >> 8) & 0xFF;
-            uint8_t b = argb & 0xFF;
-
-            *ptr++ = r;
-            *ptr++ = g;
-            *ptr++ = b;
-        }
+        sk_read_row(bm, cinfo.next_scanline, rgba, gray ? SK_GRAY : SK_RGB, pal);
         row_pointer[0] = rgba;
         (void)jpeg_write_scanlines(&cinfo, row_pointer, 1);
     }
 
+    free(rgba);
+
     /* Step 6: Finish compression */
 
     jpeg_finish_compress(&cinfo);
@@ -348,3 +763,184 @@ int save_jpeg(AL_CONST char *filename, BITMAP *bm, AL_CONST RGB *pal) {
     /* And we're done! */
     return 0;
 }
+
+/**
+ * @brief map rotation and flip to the transform of transupp.c, the flip is done first.
+ *
+ * @param flip mirror left and right.
+ * @param rotate clockwise rotation in degrees, a multiple of 90 (may be negative).
+ *
+ * @return the transform code.
+ */
+static JXFORM_CODE jpeg_transform_code(bool flip, int rotate) {
+    // [flip][rotate / 90]
+    static const JXFORM_CODE codes[2][4] = {
+        {JXFORM_NONE, JXFORM_ROT_90, JXFORM_ROT_180, JXFORM_ROT_270},
+        {JXFORM_FLIP_H, JXFORM_TRANSVERSE, JXFORM_FLIP_V, JXFORM_TRANSPOSE},
+    };
+    int rot = ((rotate / 90) % 4 + 4) % 4;
+    return codes[flip ? 1 : 0][rot];
+}
+
+/**
+ * @brief the transform code for an EXIF orientation followed by the user's transformation.
+ *
+ * @param orientation EXIF orientation of the source.
+ * @param t the user's transformation.
+ *
+ * @return the transform code.
+ */
+static JXFORM_CODE jpeg_compose_transform(int orientation, const jpeg_transform_t *t) {
+    const jpeg_orientation_t *o = &jpeg_orientations[orientation];
+
+    // a vertical flip is a horizontal one rotated by 180 degrees
+    bool flip = t->flip != 0;
+    int rotate = t->rotate + ((t->flip == 'v') ? 180 : 0);
+
+    // a flip after a rotation is the flip before the opposite rotation
+    return jpeg_transform_code(o->flip != flip, rotate + (flip ? -o->rotate : o->rotate));
+}
+
+/**
+ * @brief rotate, flip and/or crop a JPEG without decoding it: the DCT coefficients are rearranged and written to a new file,
+ * so there is no generation loss and no pixel is touched. All markers (EXIF, ICC profile, comments) are copied.
+ * Partial MCUs at the right and bottom edge can't be transformed, they are trimmed (up to 15 pixels), the crop offset
+ * is rounded down to a multiple of the MCU size.
+ * The EXIF orientation of the source is applied first and reset in the copy, so the result looks like on screen.
+ *
+ * @param infile the JPEG to transform.
+ * @param outfile the file to write.
+ * @param t the transformation.
+ *
+ * @return true for success.
+ */
+bool transform_jpeg(const char *infile, const char *outfile, const jpeg_transform_t *t) {
+    struct jpeg_decompress_struct srcinfo;
+    struct jpeg_compress_struct dstinfo;
+    struct my_error_mgr jerr;
+    jpeg_transform_info transform;
+    input_t in;
+    FILE *volatile out = NULL;
+
+    memset(&transform, 0, sizeof(transform));
+    transform.trim = TRUE;
+    if (t->crop && !jtransform_parse_crop_spec(&transform, t->crop)) {
+        DEBUGF("invalid crop %s\n", t->crop);
+        return false;
+    }
+
+    if (!in_open(&in, infile)) {
+        return false;
+    }
+
+    /* Both objects share the error handler, an error in either ends here. */
+    st_push(ST_DECODE);
+    srcinfo.err = jpeg_std_error(&jerr.pub);
+    dstinfo.err = &jerr.pub;
+    jerr.pub.error_exit = my_error_exit;
+    if (setjmp(jerr.setjmp_buffer)) {
+        st_pop();
+        jpeg_destroy_compress(&dstinfo);
+        jpeg_destroy_decompress(&srcinfo);
+        in_close(&in);
+        if (out) {
+            fclose(out);
+            remove(outfile);
+        }
+        return false;
+    }
+    jpeg_create_decompress(&srcinfo);
+    jpeg_create_compress(&dstinfo);
+
+    /* Read the coefficients, the workspace must be requested before that. */
+    jpeg_input_src(&srcinfo, &in);
+    jcopy_markers_setup(&srcinfo, JCOPYOPT_ALL);
+    (void)jpeg_read_header(&srcinfo, TRUE);
+    exif_t ex;
+    jpeg_saved_marker_ptr exif = jpeg_read_exif(&srcinfo, &ex);
+    transform.transform = jpeg_compose_transform(ex.orientation, t);
+    if (exif) {
+        ex_set_orientation(exif->data, &ex, EX_TOP_LEFT);
+    }
+    if (!jtransform_request_workspace(&srcinfo, &transform)) {
+        DEBUGF("transformation not possible for %s\n", infile);
+        st_pop();
+        jpeg_destroy_compress(&dstinfo);
+        jpeg_destroy_decompress(&srcinfo);
+        in_close(&in);
+        return false;
+    }
+    jvirt_barray_ptr *src_coef_arrays = jpeg_read_coefficients(&srcinfo);
+
+    /* The destination gets the parameters of the source, adjusted for the transformation. */
+    st_pop();
+    st_push(ST_ENCODE);
+    jpeg_copy_critical_parameters(&srcinfo, &dstinfo);
+    jvirt_barray_ptr *dst_coef_arrays = jtransform_adjust_parameters(&srcinfo, &dstinfo, src_coef_arrays, &transform);
+    DEBUGF("JPEG %dx%d transformed to %dx%d\n", srcinfo.image_width, srcinfo.image_height, dstinfo.image_width, dstinfo.image_height);
+
+    if ((out = fopen(outfile, "wb")) == NULL) {
+        DEBUGF("can't open %s\n", outfile);
+        st_pop();
+        jpeg_destroy_compress(&dstinfo);
+        jpeg_destroy_decompress(&srcinfo);
+        in_close(&in);
+        return false;
+    }
+    jpeg_stdio_dest(&dstinfo, out);
+
+    /* Start the compressor (no image data is written yet), copy the extra markers and move the coefficients. */
+    jpeg_write_coefficients(&dstinfo, dst_coef_arrays);
+    jcopy_markers_execute(&srcinfo, &dstinfo, JCOPYOPT_ALL);
+    jtransform_execute_transform(&srcinfo, &dstinfo, src_coef_arrays, &transform);
+
+    jpeg_finish_compress(&dstinfo);
+    st_pop();
+    jpeg_destroy_compress(&dstinfo);
+    (void)jpeg_finish_decompress(&srcinfo);
+    jpeg_destroy_decompress(&srcinfo);
+    fclose(out);
+    in_close(&in);
+
+    return true;
+}
+
+/**
+ * @brief read size and layout of a JPEG from its header.
+ *
+ * @param in the file
+ * @param p the probe to fill in
+ *
+ * @return true for success
+ */
+bool probe_jpeg(input_t *in, probe_t *p) {
+    struct jpeg_decompress_struct cinfo;
+    struct my_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = my_error_exit;
+    if (setjmp(jerr.setjmp_buffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_input_src(&cinfo, in);
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+    (void)jpeg_read_header(&cinfo, TRUE);
+
+    // the size as shown
+    exif_t ex;
+    jpeg_read_exif(&cinfo, &ex);
+    bool turned = jpeg_orientations[ex.orientation].transpose;
+    p->width = turned ? cinfo.image_height : cinfo.image_width;
+    p->height = turned ? cinfo.image_width : cinfo.image_height;
+    p->turned = turned;
+    p->components = cinfo.num_components;
+    p->progressive = cinfo.progressive_mode;
+    p->bits = cinfo.data_precision;
+    p->frames = 1;
+    strcpy(p->compression, cinfo.arith_code ? "arithmetic" : (cinfo.progressive_mode ? "progressive" : "baseline"));
+
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
@@ -24,8 +24,20 @@ SOFTWARE.
 #define __FORMAT_JPEG__
 
 #include "main.h"
+#include "probe.h"
+#include "input.h"
+
+//! a lossless transformation of a JPEG, see transform_jpeg()
+typedef struct __jpeg_transform {
+    int rotate;        //!< clockwise rotation in degrees: 0, 90, 180 or 270
+    char flip;         //!< mirror 'h'orizontally or 'v'ertically before rotating, 0 for none
+    const char *crop;  //!< region WxH+X+Y of the result to keep or NULL
+} jpeg_transform_t;
 
 extern BITMAP *load_jpeg(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_jpeg_in(input_t *in, RGB *pal);
+extern bool probe_jpeg(input_t *in, probe_t *p);
 extern int save_jpeg(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal);
+extern bool transform_jpeg(const char *infile, const char *outfile, const jpeg_transform_t *t);
 
 #endif  // __FORMAT_JPEG__
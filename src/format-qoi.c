@@ -1,6 +1,9 @@
 
+#include <limits.h>
+
 #include "main.h"
 #include "format-qoi.h"
+#include "sink.h"
 
 #define QOI_IMPLEMENTATION
 #include "qoi.h"
@@ -28,15 +31,19 @@ OK
 */
 
 /**
- * @brief load from file system
+ * @brief decode a QOI from an input, the decoder needs the whole file in memory.
  *
- * @param filename the name of the file
+ * @param in the file
  * @param pal pallette (is ignored)
  * @return BITMAP* or NULL if loading fails
  */
-BITMAP *load_qoi(AL_CONST char *filename, RGB *pal) {
+BITMAP *load_qoi_in(input_t *in, RGB *pal) {
     qoi_desc desc;
-    uint8_t *rgba = qoi_read(filename, &desc, NUM_CHANNELS);
+    const uint8_t *data = in_contents(in);
+    if (!data || (in->size > INT_MAX)) {
+        return NULL;
+    }
+    uint8_t *rgba = qoi_decode(data, in->size, &desc, NUM_CHANNELS);
     if (rgba) {
         DEBUGF("QOI is %dx%d\n", desc.width, desc.height);
 
@@ -46,32 +53,39 @@ BITMAP *load_qoi(AL_CONST char *filename, RGB *pal) {
         DEBUGF("_rgb_a_shift_32 is %d\n", _rgb_a_shift_32);
 
         // create bitmap
-        BITMAP *bm = create_bitmap_ex(32, desc.width, desc.height);
-        if (!bm) {
+        sink_t sk;
+        if (!sk_begin(&sk, desc.width, desc.height, pal, SK_RGBA, load_shrink)) {
             QOI_FREE(rgba);
             return NULL;
         }
 
         // copy RGBA data in BITMAP
         for (int y = 0; y < desc.height; y++) {
-            unsigned int yIdx = y * NUM_CHANNELS * desc.width;
-            for (int x = 0; x < desc.width; x++) {
-                unsigned int xIdx = x * NUM_CHANNELS;
-                bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = rgba[0 + yIdx + xIdx];
-                bm->line[y][x * 4 + _rgb_g_shift_32 / 8] = rgba[1 + yIdx + xIdx];
-                bm->line[y][x * 4 + _rgb_b_shift_32 / 8] = rgba[2 + yIdx + xIdx];
-                bm->line[y][x * 4 + _rgb_a_shift_32 / 8] = rgba[3 + yIdx + xIdx];
+            if (!sk_progress(y, desc.height)) {
+                QOI_FREE(rgba);
+                sk_abort(&sk);
+                return NULL;
             }
+            sk_put_row(&sk, y, &rgba[y * NUM_CHANNELS * desc.width]);
         }
 
         QOI_FREE(rgba);
 
-        return bm;
+        return sk_finish(&sk);
     } else {
         return NULL;
     }
 }
 
+/**
+ * @brief load from file system
+ *
+ * @param filename the name of the file
+ * @param pal pallette (is ignored)
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_qoi(AL_CONST char *filename, RGB *pal) { return in_load(filename, pal, load_qoi_in); }
+
 /**
  * @brief convert BITMAP to rgba buffer and save as QOI
  *
@@ -91,20 +105,8 @@ int save_qoi(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal) {
 
     DEBUGF("RGBA OK\n");
 
-    uint8_t *ptr = rgba;
     for (int y = 0; y < bm->h; y++) {
-        for (int x = 0; x < bm->w; x++) {
-            uint32_t argb = getpixel(bm, x, y);
-            uint8_t a = 0xFF;
-            uint8_t r = (argb >> 16) & 0xFF;
-            uint8_t g = (argb >> 8) & 0xFF;
-            uint8_t b = argb & 0xFF;
-
-            *ptr++ = r;
-            *ptr++ = g;
-            *ptr++ = b;
-            *ptr++ = a;
-        }
+        sk_read_row(bm, y, &rgba[y * bm->w * NUM_CHANNELS], SK_RGBA, pal);
     }
 
     DEBUGF("RGBA converted\n");
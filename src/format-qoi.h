@@ -24,8 +24,10 @@ SOFTWARE.
 #define __FORMAT_QOI__
 
 #include "main.h"
+#include "input.h"
 
 extern BITMAP *load_qoi(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_qoi_in(input_t *in, RGB *pal);
 extern int save_qoi(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal);
 
 #endif  // __FORMAT_QOI__
@@ -21,6 +21,7 @@ SOFTWARE.
 */
 #include "main.h"
 #include "format-stb.h"
+#include "sink.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_SIMD
@@ -36,40 +37,99 @@ SOFTWARE.
 #define NUM_CHANNELS 4  //!< always use RGBA
 
 /**
- * @brief load from file system
+ * @brief stb_image read callback.
+ */
+static int stb_read(void *user, char *data, int size) { return in_read((input_t *)user, data, size); }
+
+/**
+ * @brief stb_image skip callback, negative values go back.
+ */
+static void stb_skip(void *user, int n) { in_skip((input_t *)user, n); }
+
+/**
+ * @brief stb_image end of file callback.
+ */
+static int stb_eof(void *user) {
+    input_t *in = (input_t *)user;
+    return in->pos >= in->size;
+}
+
+static const stbi_io_callbacks stb_callbacks = {stb_read, stb_skip, stb_eof};  //!< reads from an input_t
+
+/**
+ * @brief decode an image from an input.
  *
- * @param filename the name of the file
+ * @param in the file
  * @param pal pallette (is ignored)
  * @return BITMAP* or NULL if loading fails
  */
-BITMAP *load_stb(AL_CONST char *filename, RGB *pal) {
+BITMAP *load_stb_in(input_t *in, RGB *pal) {
     int width;
     int height;
     int channels_in_file;
-    uint8_t *rgba = stbi_load(filename, &width, &height, &channels_in_file, NUM_CHANNELS);
+    in_seek(in, 0);
+    uint8_t *rgba = stbi_load_from_callbacks(&stb_callbacks, in, &width, &height, &channels_in_file, NUM_CHANNELS);
+
+    if (!rgba) {
+        DEBUGF("stb failed: %s\n", stbi_failure_reason());
+        return NULL;
+    }
 
     DEBUGF("image is %dx%dx%d\n", width, height, channels_in_file);
 
     // create bitmap
-    BITMAP *bm = create_bitmap_ex(32, width, height);
-    if (!bm) {
+    sink_t sk;
+    if (!sk_begin(&sk, width, height, pal, SK_RGBA, load_shrink)) {
         stbi_image_free(rgba);
         return NULL;
     }
 
     // copy RGBA data in BITMAP
     for (int y = 0; y < height; y++) {
-        unsigned int yIdx = y * NUM_CHANNELS * width;
-        for (int x = 0; x < width; x++) {
-            unsigned int xIdx = x * NUM_CHANNELS;
-            bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = rgba[0 + yIdx + xIdx];
-            bm->line[y][x * 4 + _rgb_g_shift_32 / 8] = rgba[1 + yIdx + xIdx];
-            bm->line[y][x * 4 + _rgb_b_shift_32 / 8] = rgba[2 + yIdx + xIdx];
-            bm->line[y][x * 4 + _rgb_a_shift_32 / 8] = rgba[3 + yIdx + xIdx];
+        if (!sk_progress(y, height)) {
+            stbi_image_free(rgba);
+            sk_abort(&sk);
+            return NULL;
         }
+        sk_put_row(&sk, y, &rgba[y * NUM_CHANNELS * width]);
     }
 
     stbi_image_free(rgba);
 
-    return bm;
+    return sk_finish(&sk);
+}
+
+/**
+ * @brief load from file system
+ *
+ * @param filename the name of the file
+ * @param pal pallette (is ignored)
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_stb(AL_CONST char *filename, RGB *pal) { return in_load(filename, pal, load_stb_in); }
+
+/**
+ * @brief read size and layout of an image from its header.
+ *
+ * @param in the file
+ * @param p the probe to fill in
+ *
+ * @return true for success
+ */
+bool probe_stb(input_t *in, probe_t *p) {
+    int comp;
+    in_seek(in, 0);
+    if (!stbi_info_from_callbacks(&stb_callbacks, in, &p->width, &p->height, &comp)) {
+        return false;
+    }
+    p->components = comp;
+    in_seek(in, 0);
+    if (stbi_is_hdr_from_callbacks(&stb_callbacks, in)) {
+        p->bits = 32;
+    } else {
+        in_seek(in, 0);
+        p->bits = stbi_is_16_bit_from_callbacks(&stb_callbacks, in) ? 16 : 8;
+    }
+    p->frames = 1;
+    return true;
 }
@@ -24,8 +24,12 @@ SOFTWARE.
 #define __FORMAT_STB__
 
 #include "main.h"
+#include "probe.h"
+#include "input.h"
 
 extern BITMAP *load_stb(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_stb_in(input_t *in, RGB *pal);
+extern bool probe_stb(input_t *in, probe_t *p);
 extern int save_stb(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal);
 
 #endif  // __FORMAT_STB__
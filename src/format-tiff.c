@@ -20,78 +20,224 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <ctype.h>
+
 #include "main.h"
 #include "util.h"
 #include "format-tiff.h"
+#include "sink.h"
+#include "trace.h"
 
 #include "tiffio.h"
 
 #define NUM_CHANNELS 4  //!< always use RGBA
 
+#define TIFF_CHUNK_ROWS 64  //!< rows decoded per chunk when the file has no useful strip size
+
+/**
+ * @brief TIFFClientOpen() read procedure.
+ */
+static tmsize_t tiff_read(thandle_t h, void *buf, tmsize_t size) { return in_read((input_t *)h, buf, size); }
+
+/**
+ * @brief TIFFClientOpen() write procedure, inputs are read only.
+ */
+static tmsize_t tiff_write(thandle_t h, void *buf, tmsize_t size) { return -1; }
+
+/**
+ * @brief TIFFClientOpen() seek procedure.
+ */
+static toff_t tiff_seek(thandle_t h, toff_t off, int whence) {
+    input_t *in = (input_t *)h;
+
+    if (whence == SEEK_CUR) {
+        off += in->pos;
+    } else if (whence == SEEK_END) {
+        off += in->size;
+    }
+    in_seek(in, off);
+    return in->pos;
+}
+
+/**
+ * @brief TIFFClientOpen() close procedure, the input is closed by its owner.
+ */
+static int tiff_close(thandle_t h) { return 0; }
+
+/**
+ * @brief TIFFClientOpen() size procedure.
+ */
+static toff_t tiff_size(thandle_t h) { return ((input_t *)h)->size; }
+
 /**
- * @brief load from file system
+ * @brief TIFFClientOpen() map procedure, strips are read in place when the file is mapped.
+ */
+static int tiff_map(thandle_t h, void **base, toff_t *size) {
+    input_t *in = (input_t *)h;
+
+    if (!in->map) {
+        return 0;
+    }
+    *base = (void *)in->map;
+    *size = in->size;
+    return 1;
+}
+
+/**
+ * @brief TIFFClientOpen() unmap procedure, the mapping belongs to the input.
+ */
+static void tiff_unmap(thandle_t h, void *base, toff_t size) {}
+
+/**
+ * @brief open a TIFF on an input, replaces TIFFOpen().
  *
- * @param filename the name of the file
+ * @param in the input.
+ *
+ * @return the TIFF or NULL.
+ */
+static TIFF *tiff_open(input_t *in) {
+    in_seek(in, 0);
+    return TIFFClientOpen(in->filename, "r", (thandle_t)in, tiff_read, tiff_write, tiff_seek, tiff_close, tiff_size, tiff_map, tiff_unmap);
+}
+
+/**
+ * @brief decode a TIFF from an input.
+ * The image is decoded in horizontal chunks of one strip (or tile row) so only a slice of it has to be kept as RGBA.
+ *
+ * @param in the file
  * @param pal pallette (is ignored)
  *
  * @return BITMAP* or NULL if loading fails
  */
-BITMAP *load_tiff(AL_CONST char *filename, RGB *pal) {
-    TIFF *tif = TIFFOpen(filename, "r");
+BITMAP *load_tiff_in(input_t *in, RGB *pal) {
+    TIFF *tif = tiff_open(in);
     DEBUGF("TIFF = %p\n", tif);
-    if (tif) {
-        uint32_t w, h;
-        size_t npixels;
-        uint32_t *raster;
+    if (!tif) {
+        return NULL;
+    }
 
-        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
-        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+    char emsg[1024];
+    TIFFRGBAImage img;
+    if (!TIFFRGBAImageOK(tif, emsg) || !TIFFRGBAImageBegin(&img, tif, 0, emsg)) {
+        DEBUGF("TIFF error: %s\n", emsg);
+        TIFFClose(tif);
+        return NULL;
+    }
+    img.req_orientation = ORIENTATION_TOPLEFT;
 
-        DEBUGF("TIFF is %ldx%ld\n", w, h);
+    uint32_t w = img.width;
+    uint32_t h = img.height;
+    DEBUGF("TIFF is %ldx%ld\n", w, h);
 
-        // create bitmap
-        BITMAP *bm = create_bitmap_ex(32, w, h);
-        if (!bm) {
-            TIFFClose(tif);
-            return NULL;
+    // decode in chunks the size of a strip or a row of tiles
+    uint32_t chunk = 0;
+    if (TIFFIsTiled(tif)) {
+        TIFFGetField(tif, TIFFTAG_TILELENGTH, &chunk);
+    } else {
+        TIFFGetField(tif, TIFFTAG_ROWSPERSTRIP, &chunk);
+    }
+    if (chunk == 0 || chunk > h) {
+        chunk = MIN(h, TIFF_CHUNK_ROWS);
+    }
+    DEBUGF("TIFF chunk = %ld\n", chunk);
+
+    // create bitmap
+    sink_t sk;
+    uint32_t *raster = (uint32_t *)_TIFFmalloc((tmsize_t)w * chunk * sizeof(uint32_t));
+    DEBUGF("raster = %p\n", raster);
+    if (!raster || !sk_begin(&sk, w, h, pal, SK_RGBA, load_shrink)) {
+        if (raster) {
+            _TIFFfree(raster);
+        }
+        TIFFRGBAImageEnd(&img);
+        TIFFClose(tif);
+        return NULL;
+    }
+
+    // copy RGBA data in BITMAP
+    uint8_t *rgba = (uint8_t *)raster;
+    for (uint32_t y = 0; y < h; y += chunk) {
+        uint32_t rows = MIN(chunk, h - y);
+        img.row_offset = y;
+        img.col_offset = 0;
+        bool ok = sk_progress(y, h);
+        if (ok) {
+            TRACE_BEGIN_ARG("tiff strip", y);
+            ok = TIFFRGBAImageGet(&img, raster, w, rows);
+            TRACE_END("tiff strip");
         }
-        DEBUGF("bm = %p\n", bm);
-
-        npixels = w * h;
-        raster = (uint32_t *)_TIFFmalloc(npixels * sizeof(uint32_t));
-        DEBUGF("raster = %p\n", raster);
-        if (raster != NULL) {
-            if (TIFFReadRGBAImage(tif, w, h, raster, 0)) {
-                // copy RGBA data in BITMAP
-                uint8_t *rgba = (uint8_t *)raster;
-                for (int y = 0; y < h; y++) {
-                    unsigned int yIdx = (h - y) * NUM_CHANNELS * w;  // TIFF is loaded bottom up
-                    for (int x = 0; x < w; x++) {
-                        unsigned int xIdx = x * NUM_CHANNELS;
-                        bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = rgba[0 + yIdx + xIdx];
-                        bm->line[y][x * 4 + _rgb_g_shift_32 / 8] = rgba[1 + yIdx + xIdx];
-                        bm->line[y][x * 4 + _rgb_b_shift_32 / 8] = rgba[2 + yIdx + xIdx];
-                        bm->line[y][x * 4 + _rgb_a_shift_32 / 8] = rgba[3 + yIdx + xIdx];
-                    }
-                }
-            } else {
-                _TIFFfree(raster);
-                destroy_bitmap(bm);
-                TIFFClose(tif);
-                return NULL;
-            }
+        if (!ok) {
             _TIFFfree(raster);
-        } else {
-            destroy_bitmap(bm);
+            sk_abort(&sk);
+            TIFFRGBAImageEnd(&img);
             TIFFClose(tif);
             return NULL;
         }
-        TIFFClose(tif);
+        for (uint32_t r = 0; r < rows; r++) {
+            sk_put_row(&sk, y + r, &rgba[r * NUM_CHANNELS * w]);
+        }
+    }
+    _TIFFfree(raster);
+    TIFFRGBAImageEnd(&img);
+    TIFFClose(tif);
 
-        return bm;
+    return sk_finish(&sk);
+}
+
+/**
+ * @brief load from file system.
+ *
+ * @param filename the name of the file
+ * @param pal pallette (is ignored)
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_tiff(AL_CONST char *filename, RGB *pal) { return in_load(filename, pal, load_tiff_in); }
+
+/**
+ * @brief read size and layout of an image from its header.
+ *
+ * @param in the file
+ * @param p the probe to fill in
+ *
+ * @return true for success
+ */
+bool probe_tiff(input_t *in, probe_t *p) {
+    TIFF *tif = tiff_open(in);
+    if (!tif) {
+        return false;
+    }
+
+    uint32_t w = 0, h = 0;
+    uint16_t spp = 1, bps = 1, photometric = 0, compression = COMPRESSION_NONE;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &spp);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bps);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &compression);
+    TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric);
+
+    // only walks the chain of directory headers
+    p->frames = TIFFNumberOfDirectories(tif);
+    TIFFClose(tif);
+
+    p->width = w;
+    p->height = h;
+    p->components = spp;
+    p->bits = bps;
+    p->indexed = photometric == PHOTOMETRIC_PALETTE;
+
+    const TIFFCodec *codec = TIFFFindCODEC(compression);
+    if (compression == COMPRESSION_NONE) {
+        strcpy(p->compression, "none");
+    } else if (codec) {
+        for (int i = 0; codec->name[i] && i < (int)sizeof(p->compression) - 1; i++) {
+            p->compression[i] = tolower((unsigned char)codec->name[i]);
+        }
     } else {
-        return NULL;
+        snprintf(p->compression, sizeof(p->compression), "%u", compression);
     }
+    return true;
 }
 
 /**
@@ -133,21 +279,7 @@ int save_tiff(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal) {
 
     // Now writing image to the file one strip at a time
     for (uint32_t row = 0; row < bm->h; row++) {
-        uint8_t *ptr = buf;
-        // int y = (bm->h - row - 1);
-        int y = row;
-        for (int x = 0; x < bm->w; x++) {
-            uint32_t argb = getpixel(bm, x, y);
-            uint8_t a = 0xFF;
-            uint8_t r = (argb >> 16) & 0xFF;
-            uint8_t g = (argb >> 8) & 0xFF;
-            uint8_t b = argb & 0xFF;
-
-            *ptr++ = r;
-            *ptr++ = g;
-            *ptr++ = b;
-            *ptr++ = a;
-        }
+        sk_read_row(bm, row, buf, SK_RGBA, pal);
         if (TIFFWriteScanline(out, buf, row, 0) < 0) {
             ret = -1;
             break;
@@ -24,8 +24,12 @@ SOFTWARE.
 #define __FORMAT_TIFF__
 
 #include "main.h"
+#include "probe.h"
+#include "input.h"
 
 extern BITMAP *load_tiff(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_tiff_in(input_t *in, RGB *pal);
+extern bool probe_tiff(input_t *in, probe_t *p);
 extern int save_tiff(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal);
 
 #endif  // __FORMAT_TIFF__
@@ -23,6 +23,8 @@ SOFTWARE.
 #include "main.h"
 #include "util.h"
 #include "format-webp.h"
+#include "sink.h"
+#include "trace.h"
 
 #include "webp/decode.h"
 #include "webp/encode.h"
@@ -30,57 +32,144 @@ SOFTWARE.
 #define NUM_CHANNELS 4  //!< always use RGBA
 
 /**
- * @brief load from file system
+ * @brief decode a WEBP from an input.
+ * If 'load_shrink' is set libwebp scales while decoding, so the full size image is never in memory.
+ * The file is fed to the incremental decoder one read buffer at a time, a mapped file is decoded in place.
+ * The decoder's progress is reported after each buffer.
  *
- * @param filename the name of the file
+ * @param in the file
  * @param pal pallette (is ignored)
  *
  * @return BITMAP* or NULL if loading fails
  */
-BITMAP *load_webp(AL_CONST char *filename, RGB *pal) {
-    uint8_t *buffer;
-    size_t size;
+BITMAP *load_webp_in(input_t *in, RGB *pal) {
+    WebPDecoderConfig config;
+    const uint8_t *data;
+    size_t avail;
 
-    DEBUGF("trying %s\n", filename);
+    DEBUGF("trying %s\n", in->filename);
 
-    if (!ut_read_file(filename, (void **)&buffer, &size)) {
+    if (!WebPInitDecoderConfig(&config)) {
         return NULL;
     }
 
-    DEBUGF("loaded %p, size %ld\n", buffer, size);
-
-    int width, height;
-    uint8_t *rgba = WebPDecodeRGBA(buffer, size, &width, &height);
-    if (rgba) {
-        DEBUGF("WEBP is %dx%d\n", width, height);
-        // create bitmap
-        BITMAP *bm = create_bitmap_ex(32, width, height);
-        if (!bm) {
-            WebPFree(rgba);
-            free(buffer);
-            return NULL;
-        }
+    // the features are found in the first buffer of the file
+    in_seek(in, 0);
+    data = in_data(in, &avail);
+    if (!data || (WebPGetFeatures(data, avail, &config.input) != VP8_STATUS_OK)) {
+        return NULL;
+    }
 
-        // copy RGBA data in BITMAP
-        for (int y = 0; y < height; y++) {
-            unsigned int yIdx = y * NUM_CHANNELS * width;
-            for (int x = 0; x < width; x++) {
-                unsigned int xIdx = x * NUM_CHANNELS;
-                bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = rgba[0 + yIdx + xIdx];
-                bm->line[y][x * 4 + _rgb_g_shift_32 / 8] = rgba[1 + yIdx + xIdx];
-                bm->line[y][x * 4 + _rgb_b_shift_32 / 8] = rgba[2 + yIdx + xIdx];
-                bm->line[y][x * 4 + _rgb_a_shift_32 / 8] = rgba[3 + yIdx + xIdx];
-            }
-        }
+    // the tile store needs the full size rows, the sink reduces them then
+    int shrink = MAX(load_shrink, 1);
+    int width = config.input.width;
+    int height = config.input.height;
+    if (shrink > 1 && !load_tiles) {
+        width = (width + shrink - 1) / shrink;
+        height = (height + shrink - 1) / shrink;
+        config.options.use_scaling = 1;
+        config.options.scaled_width = width;
+        config.options.scaled_height = height;
+        shrink = 1;
+    }
+    config.output.colorspace = MODE_RGBA;
+    config.options.bypass_filtering = load_preview || (load_quality == LOAD_FAST);
+    config.options.no_fancy_upsampling = load_preview || (load_quality == LOAD_FAST);
 
-        WebPFree(rgba);
-        free(buffer);
+    WebPIDecoder *idec = WebPIDecode(NULL, 0, &config);
+    if (!idec) {
+        return NULL;
+    }
+    VP8StatusCode status = VP8_STATUS_NOT_ENOUGH_DATA;
+    bool aborted = false;
+    while ((data = in_data(in, &avail))) {
+        if (!sk_progress(in->pos, in->size)) {
+            aborted = true;
+            break;
+        }
+        // a mapped file grows one read buffer per update, so the progress moves
+        avail = MIN(avail, IN_BUFFER_SIZE);
+        TRACE_BEGIN_ARG("webp chunk", avail);
+        status = in->map ? WebPIUpdate(idec, in->map, in->pos + avail) : WebPIAppend(idec, data, avail);
+        TRACE_END("webp chunk");
+        in_skip(in, avail);
+        if (status != VP8_STATUS_SUSPENDED) {
+            break;
+        }
+    }
+    WebPIDelete(idec);
+    if (aborted || (status != VP8_STATUS_OK)) {
+        DEBUGF("WEBP decoding failed: %d\n", status);
+        WebPFreeDecBuffer(&config.output);
+        return NULL;
+    }
+    DEBUGF("WEBP is %dx%d, decoded to %dx%d\n", config.input.width, config.input.height, width, height);
 
-        return bm;
-    } else {
-        free(buffer);
+    // create bitmap
+    sink_t sk;
+    if (!sk_begin(&sk, width, height, pal, SK_RGBA, shrink)) {
+        WebPFreeDecBuffer(&config.output);
         return NULL;
     }
+
+    // copy RGBA data in BITMAP
+    for (int y = 0; y < height; y++) {
+        sk_put_row(&sk, y, &config.output.u.RGBA.rgba[y * config.output.u.RGBA.stride]);
+    }
+
+    WebPFreeDecBuffer(&config.output);
+
+    return sk_finish(&sk);
+}
+
+/**
+ * @brief load from file system.
+ *
+ * @param filename the name of the file
+ * @param pal pallette (is ignored)
+ *
+ * @return BITMAP* or NULL if loading fails
+ */
+BITMAP *load_webp(AL_CONST char *filename, RGB *pal) { return in_load(filename, pal, load_webp_in); }
+
+/**
+ * @brief read size and layout of a WEBP from its header.
+ *
+ * @param in the file
+ * @param p the probe to fill in
+ *
+ * @return true for success
+ */
+bool probe_webp(input_t *in, probe_t *p) {
+    WebPBitstreamFeatures features;
+    size_t avail;
+
+    in_seek(in, 0);
+    const uint8_t *header = in_data(in, &avail);
+    if (!header || (WebPGetFeatures(header, avail, &features) != VP8_STATUS_OK)) {
+        return false;
+    }
+    p->width = features.width;
+    p->height = features.height;
+    p->components = features.has_alpha ? 4 : 3;
+    p->bits = 8;
+    p->frames = 1;
+    strcpy(p->compression, (features.format == 1) ? "lossy" : ((features.format == 2) ? "lossless" : "mixed"));
+
+    // count the frames of an animation by walking the RIFF chunk headers
+    if (features.has_animation) {
+        uint8_t chunk[8];
+        uint64_t pos = 12;
+        p->frames = 0;
+        while (in_seek(in, pos) && (in_read(in, chunk, sizeof(chunk)) == sizeof(chunk))) {
+            uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+            if (!memcmp(chunk, "ANMF", 4)) {
+                p->frames++;
+            }
+            pos += sizeof(chunk) + size + (size & 1);
+        }
+    }
+    return true;
 }
 
 /**
@@ -99,20 +188,8 @@ int save_webp(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal) {
         return ret;
     }
 
-    uint8_t *ptr = rgba;
     for (int y = 0; y < bm->h; y++) {
-        for (int x = 0; x < bm->w; x++) {
-            uint32_t argb = getpixel(bm, x, y);
-            uint8_t a = 0xFF;
-            uint8_t r = (argb >> 16) & 0xFF;
-            uint8_t g = (argb >> 8) & 0xFF;
-            uint8_t b = argb & 0xFF;
-
-            *ptr++ = r;
-            *ptr++ = g;
-            *ptr++ = b;
-            *ptr++ = a;
-        }
+        sk_read_row(bm, y, &rgba[y * bm->w * NUM_CHANNELS], SK_RGBA, pal);
     }
 
     uint8_t *output;
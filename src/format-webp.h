@@ -24,8 +24,12 @@ SOFTWARE.
 #define __FORMAT_WEBP__
 
 #include "main.h"
+#include "probe.h"
+#include "input.h"
 
 extern BITMAP *load_webp(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_webp_in(input_t *in, RGB *pal);
+extern bool probe_webp(input_t *in, probe_t *p);
 extern int save_webp(AL_CONST char *fname, BITMAP *bm, AL_CONST RGB *pal);
 
 #endif  // __FORMAT_WEBP__
@@ -0,0 +1,259 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+
+#ifdef __DJGPP__
+#include <dpmi.h>
+#else
+#include <sys/sysinfo.h>
+#include <sys/resource.h>
+#endif
+
+#include "governor.h"
+
+/************
+** defines **
+************/
+#define GV_MAX_SHRINK 16     //!< largest size reduction the governor will pick
+#define GV_RESERVE_PERCENT 10  //!< part of the free memory kept for allocator overhead and fragmentation
+#define GV_TIFF_CHUNK 64     //!< rows per chunk assumed for TIFF files (see load_tiff())
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief check if the format is one of our own loaders which can reduce the size while decoding.
+ *
+ * @param p the probed image.
+ *
+ * @return true if load_shrink is honored for this format.
+ */
+static bool gv_can_shrink(const probe_t *p) {
+    static const char *formats[] = {"JPG", "WEB", "TIF", "QOI", "PSD", "HDR", "PIC", "JP2", "RAS", "PNM", "PBM", "PGM", "PPM", NULL};
+
+    for (int i = 0; formats[i]; i++) {
+        if (!strcmp(p->format, formats[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief check if the format can be loaded into a tile store.
+ * Only decoders that produce the image row by row without a full size buffer qualify.
+ *
+ * @param p the probed image.
+ *
+ * @return true if the full size image never has to be in memory.
+ */
+static bool gv_can_tile(const probe_t *p) { return (!strcmp(p->format, "JPG") && !p->progressive) || !strcmp(p->format, "TIF"); }
+
+/**
+ * @brief get the number of bytes per pixel for a color depth.
+ *
+ * @param depth color depth in bits.
+ *
+ * @return bytes per pixel.
+ */
+static int gv_bytes_per_pixel(int depth) { return (depth + 7) / 8; }
+
+/**
+ * @brief estimate the memory the decoder needs besides the final bitmap.
+ *
+ * @param p the probed image.
+ * @param shrink the size reduction.
+ *
+ * @return bytes.
+ */
+static uint64_t gv_decode_bytes(const probe_t *p, int shrink) {
+    uint64_t w = p->width;
+    uint64_t h = p->height;
+    uint64_t comp = p->components ? p->components : 3;
+
+    if (!strcmp(p->format, "JPG")) {
+        if (p->progressive) {
+            return w * h * comp * sizeof(int16_t);  // whole coefficient image, independent of the output scale
+        } else {
+            return w * comp * 16 * 2;  // a few MCU rows
+        }
+    } else if (!strcmp(p->format, "WEB")) {
+        return (w / shrink) * (h / shrink) * 4 + w * 4 * 2;  // scaled RGBA output and some rows of the decoder
+    } else if (!strcmp(p->format, "TIF")) {
+        return w * GV_TIFF_CHUNK * 4;
+    } else if (!strcmp(p->format, "HDR")) {
+        return w * h * 4 + w * h * 4 * sizeof(float);  // float image converted to 8 bit
+    } else if (!strcmp(p->format, "JP2") || !strcmp(p->format, "RAS") || !strcmp(p->format, "PNM") || !strcmp(p->format, "PBM") ||
+               !strcmp(p->format, "PGM") || !strcmp(p->format, "PPM")) {
+        return w * h * comp * sizeof(int32_t) * 2;  // jasper keeps two copies of all components
+    } else if (!strcmp(p->format, "GIF")) {
+        return w * h;  // raw frame
+    } else if (!strcmp(p->format, "BMP") || !strcmp(p->format, "PCX") || !strcmp(p->format, "TGA") || !strcmp(p->format, "LBM") ||
+               !strcmp(p->format, "PNG")) {
+        return w * h * (p->indexed ? 1 : 4);  // Allegro loads at file depth and converts afterwards
+    } else {
+        return w * h * 4;  // full RGBA buffer (QOI, PSD, PIC)
+    }
+}
+
+/**
+ * @brief estimate the peak memory use for loading (and showing) an image.
+ *
+ * @param p the probed image.
+ * @param shrink the size reduction.
+ * @param depth the color depth of the loaded bitmap.
+ * @param screen_depth the color depth of the screen.
+ * @param screen_w screen width or 0 if the image is not shown.
+ * @param screen_h screen height.
+ * @param cache_margin margin of the viewer cache.
+ *
+ * @return bytes.
+ */
+static uint64_t gv_estimate(const probe_t *p, int shrink, int depth, int screen_depth, int screen_w, int screen_h, int cache_margin) {
+    // palette and gray images are always loaded as 8bpp
+    int bpp = (p->indexed || p->components == 1) ? 1 : gv_bytes_per_pixel(depth);
+    uint64_t bitmap = (uint64_t)(p->width / shrink) * (p->height / shrink) * bpp;
+
+    uint64_t need = gv_decode_bytes(p, shrink) + bitmap;
+    if (screen_w) {
+        uint64_t screen_bpp = gv_bytes_per_pixel(screen_depth);
+        need += bitmap / 3;                                                                            // image pyramid
+        need += (uint64_t)screen_w * screen_h * screen_bpp;                                            // back buffer
+        need += (uint64_t)(screen_w + 2 * cache_margin) * (screen_h + 2 * cache_margin) * screen_bpp;  // panning cache
+    }
+    return need;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief get the amount of memory that can be allocated.
+ * On DOS this is the remaining physical memory of the DPMI host, on Linux the free RAM limited by RLIMIT_AS.
+ *
+ * @return number of bytes or 0 if unknown.
+ */
+uint64_t gv_available() {
+#ifdef __DJGPP__
+    return _go32_dpmi_remaining_physical_memory();
+#else
+    struct sysinfo si;
+    uint64_t avail = 0;
+    if (sysinfo(&si) == 0) {
+        avail = ((uint64_t)si.freeram + si.bufferram) * si.mem_unit;
+    }
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_AS, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+        if (!avail || rl.rlim_cur < avail) {
+            avail = rl.rlim_cur;
+        }
+    }
+    return avail;
+#endif
+}
+
+/**
+ * @brief choose how to load an image so that it fits into the memory budget.
+ * Full size is tried first. The viewer then tries 16bpp instead of the screen depth, then a tile store on disk with a reduced
+ * overview in memory (only for formats decoded row by row). After that the image is reduced in size by powers of two while
+ * decoding (only for formats whose loaders support it). Images that are saved are never reduced, a conversion must not lose resolution.
+ *
+ * @param p the probed image, width/height 0 if the header could not be read.
+ * @param budget memory that may be used in bytes, 0 for no limit.
+ * @param depth color depth the image would be loaded with.
+ * @param screen_w screen width or 0 if the image is saved instead of shown.
+ * @param screen_h screen height.
+ * @param cache_margin margin of the viewer cache.
+ * @param plan the result, the most reduced plan if nothing fits.
+ *
+ * @return true if the plan fits into the budget.
+ */
+bool gv_plan(const probe_t *p, uint64_t budget, int depth, int screen_w, int screen_h, int cache_margin, gv_plan_t *plan) {
+    plan->shrink = 1;
+    plan->depth = depth;
+    plan->tiled = false;
+    plan->cache = 0;
+    plan->budget = budget * (100 - GV_RESERVE_PERCENT) / 100;
+
+    if (!p->width || !p->height) {
+        // nothing known about the image, load it as is
+        plan->need = 0;
+        return true;
+    }
+
+    plan->need = gv_estimate(p, 1, depth, depth, screen_w, screen_h, cache_margin);
+    if (!budget) {
+        return true;
+    }
+
+    // full color depth, then 16bpp when showing the image
+    int depths[] = {depth, (screen_w && depth > 16) ? 16 : depth};
+    for (int i = 0; i < 2; i++) {
+        plan->depth = depths[i];
+        plan->need = gv_estimate(p, 1, depths[i], depth, screen_w, screen_h, cache_margin);
+        if (plan->need <= plan->budget) {
+            return true;
+        }
+    }
+
+    // the viewer can keep the full size image on disk, use the largest overview that leaves room for a row of tiles
+    if (screen_w && gv_can_tile(p)) {
+        for (int i = 0; i < 2; i++) {
+            for (int shrink = 2; shrink <= GV_MAX_SHRINK; shrink *= 2) {
+                uint64_t need = gv_estimate(p, shrink, depths[i], depth, screen_w, screen_h, cache_margin);
+                need += (uint64_t)screen_w * screen_h * 4 * gv_bytes_per_pixel(depths[i]);  // tiles copied for the resampler
+                // tiles are not oriented, their rows have the stored width
+                uint64_t min_cache = ts_min_cache(p->turned ? p->height : p->width, (p->components == 1) ? 8 : depths[i]);
+                DEBUGF("plan tiled 1/%d @ %dbpp needs %lu + %lu of %lu bytes\n", shrink, depths[i], (unsigned long)need, (unsigned long)min_cache,
+                       (unsigned long)plan->budget);
+                if (need + min_cache <= plan->budget) {
+                    plan->tiled = true;
+                    plan->shrink = shrink;
+                    plan->depth = depths[i];
+                    plan->cache = plan->budget - need;
+                    plan->need = plan->budget;
+                    return true;
+                }
+            }
+        }
+    }
+
+    int max_shrink = (screen_w && gv_can_shrink(p)) ? GV_MAX_SHRINK : 1;
+    for (int shrink = 2; shrink <= max_shrink; shrink *= 2) {
+        if (shrink > p->width || shrink > p->height) {
+            break;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            plan->shrink = shrink;
+            plan->depth = depths[i];
+            plan->need = gv_estimate(p, shrink, depths[i], depth, screen_w, screen_h, cache_margin);
+            DEBUGF("plan 1/%d @ %dbpp needs %lu of %lu bytes\n", shrink, depths[i], (unsigned long)plan->need, (unsigned long)plan->budget);
+            if (plan->need <= plan->budget) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
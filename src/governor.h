@@ -0,0 +1,49 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __GOVERNOR_H__
+#define __GOVERNOR_H__
+
+#include "main.h"
+#include "probe.h"
+#include "tilestore.h"
+
+/************
+** structs **
+************/
+//! how an image is going to be loaded
+typedef struct __gv_plan {
+    int shrink;       //!< the loaders reduce the image size by this factor
+    int depth;        //!< color depth the loaders decode to
+    bool tiled;       //!< the full size image goes into a tile store, the loaded bitmap is a 1/shrink overview
+    uint64_t cache;   //!< memory for the tile store cache in bytes
+    uint64_t need;    //!< estimated peak memory use in bytes
+    uint64_t budget;  //!< memory that may be used in bytes
+} gv_plan_t;
+
+/***********************
+** exported functions **
+***********************/
+extern uint64_t gv_available(void);
+extern bool gv_plan(const probe_t *p, uint64_t budget, int depth, int screen_w, int screen_h, int cache_margin, gv_plan_t *plan);
+
+#endif  // __GOVERNOR_H__
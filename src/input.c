@@ -0,0 +1,378 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifndef __DJGPP__
+#include <sys/mman.h>
+#endif
+
+#include "input.h"
+
+/************
+** defines **
+************/
+#ifndef O_BINARY
+#define O_BINARY 0  //!< only DOS distinguishes text and binary files
+#endif
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief fill the read buffer with the aligned block containing the current position.
+ *
+ * @param in the input.
+ *
+ * @return true if the current position is in the buffer now.
+ */
+static bool in_fill(input_t *in) {
+    uint64_t start = in->pos & ~(uint64_t)(IN_BUFFER_SIZE - 1);
+
+    in->buf_len = 0;
+    if (lseek(in->fd, start, SEEK_SET) != (off_t)start) {
+        return false;
+    }
+    ssize_t len = read(in->fd, in->buf, IN_BUFFER_SIZE);
+    in->reads++;
+    if (len <= 0) {
+        return false;
+    }
+    in->buf_start = start;
+    in->buf_len = len;
+    in->bytes += len;
+    return in->pos < in->buf_start + in->buf_len;
+}
+
+/**
+ * @brief PACKFILE vtable: closing the packfile leaves the input open.
+ */
+static int in_pf_fclose(void *userdata) { return 0; }
+
+/**
+ * @brief PACKFILE vtable: read one byte.
+ */
+static int in_pf_getc(void *userdata) { return in_getc((input_t *)userdata); }
+
+/**
+ * @brief PACKFILE vtable: push back the byte that was read last.
+ */
+static int in_pf_ungetc(int c, void *userdata) {
+    input_t *in = (input_t *)userdata;
+    return in_skip(in, -1) ? c : EOF;
+}
+
+/**
+ * @brief PACKFILE vtable: read a block.
+ */
+static long in_pf_fread(void *p, long n, void *userdata) { return in_read((input_t *)userdata, p, n); }
+
+/**
+ * @brief PACKFILE vtable: inputs are read only.
+ */
+static int in_pf_putc(int c, void *userdata) { return EOF; }
+
+/**
+ * @brief PACKFILE vtable: inputs are read only.
+ */
+static long in_pf_fwrite(AL_CONST void *p, long n, void *userdata) { return 0; }
+
+/**
+ * @brief PACKFILE vtable: skip forward.
+ */
+static int in_pf_fseek(void *userdata, int offset) { return in_skip((input_t *)userdata, offset) ? 0 : -1; }
+
+/**
+ * @brief PACKFILE vtable: end of file reached.
+ */
+static int in_pf_feof(void *userdata) {
+    input_t *in = (input_t *)userdata;
+    return in->pos >= in->size;
+}
+
+/**
+ * @brief PACKFILE vtable: errors show up as short reads.
+ */
+static int in_pf_ferror(void *userdata) { return 0; }
+
+/************
+** globals **
+************/
+static const PACKFILE_VTABLE in_vtable = {
+    in_pf_fclose, in_pf_getc, in_pf_ungetc, in_pf_fread, in_pf_putc, in_pf_fwrite, in_pf_fseek, in_pf_feof, in_pf_ferror,
+};
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief open a file for reading. The host build maps the file into memory, DOS reads it in aligned blocks of
+ * IN_BUFFER_SIZE bytes instead of going through the small stdio buffer.
+ *
+ * @param in the input to initialize.
+ * @param filename the file, must stay valid until in_close().
+ *
+ * @return true for success, the input must be closed with in_close() then.
+ */
+bool in_open(input_t *in, const char *filename) {
+    struct stat st;
+
+    memset(in, 0, sizeof(input_t));
+    in->filename = filename;
+    in->fd = open(filename, O_RDONLY | O_BINARY);
+    if (in->fd < 0) {
+        DEBUGF("Can't open %s\n", filename);
+        return false;
+    }
+    if ((fstat(in->fd, &st) != 0) || !S_ISREG(st.st_mode)) {
+        DEBUGF("Not a file: %s\n", filename);
+        close(in->fd);
+        return false;
+    }
+    in->size = st.st_size;
+
+#ifndef __DJGPP__
+    // the codecs read the page cache directly, the file is not needed after mapping it
+    if (in->size > 0) {
+        void *map = mmap(NULL, in->size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, in->size, MADV_SEQUENTIAL);
+            in->map = map;
+            close(in->fd);
+            in->fd = -1;
+            return true;
+        }
+    }
+#endif
+
+    in->buf_alloc = malloc(IN_BUFFER_SIZE + IN_ALIGN);
+    if (!in->buf_alloc) {
+        close(in->fd);
+        return false;
+    }
+    in->buf = (uint8_t *)(((uintptr_t)in->buf_alloc + IN_ALIGN - 1) & ~(uintptr_t)(IN_ALIGN - 1));
+    return true;
+}
+
+/**
+ * @brief close an input and free its buffers.
+ *
+ * @param in the input.
+ */
+void in_close(input_t *in) {
+    DEBUGF("input %s: %lu bytes, %lu bytes in %lu reads%s\n", in->filename, (unsigned long)in->size, (unsigned long)in->bytes,
+           (unsigned long)in->reads, in->map ? " (mapped)" : "");
+#ifndef __DJGPP__
+    if (in->map) {
+        munmap((void *)in->map, in->size);
+        in->map = NULL;
+    }
+#endif
+    if (in->fd >= 0) {
+        close(in->fd);
+        in->fd = -1;
+    }
+    free(in->buf_alloc);
+    in->buf_alloc = in->buf = NULL;
+    free(in->contents);
+    in->contents = NULL;
+}
+
+/**
+ * @brief get the bytes at the current position without copying them, the position is not changed.
+ * The pointer is valid until the next call of an input function.
+ *
+ * @param in the input.
+ * @param avail returns the number of bytes available at the pointer, 0 at the end of the file.
+ *
+ * @return the data or NULL at the end of the file.
+ */
+const uint8_t *in_data(input_t *in, size_t *avail) {
+    *avail = 0;
+    if (in->pos >= in->size) {
+        return NULL;
+    }
+    if (in->map) {
+        *avail = in->size - in->pos;
+        return &in->map[in->pos];
+    }
+    if ((in->pos < in->buf_start) || (in->pos >= in->buf_start + in->buf_len)) {
+        if (!in_fill(in)) {
+            return NULL;
+        }
+    }
+    size_t offset = in->pos - in->buf_start;
+    *avail = in->buf_len - offset;
+    return &in->buf[offset];
+}
+
+/**
+ * @brief read from the current position. Large blocks are read directly into the destination.
+ *
+ * @param in the input.
+ * @param dst destination.
+ * @param n number of bytes to read.
+ *
+ * @return number of bytes read, less than n at the end of the file.
+ */
+size_t in_read(input_t *in, void *dst, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    size_t done = 0;
+
+    while ((done < n) && (in->pos < in->size)) {
+        size_t avail;
+        bool buffered = (in->pos >= in->buf_start) && (in->pos < in->buf_start + in->buf_len);
+        if (!in->map && !buffered && (n - done >= IN_BUFFER_SIZE)) {
+            size_t len = MIN(n - done, in->size - in->pos);
+            if (lseek(in->fd, in->pos, SEEK_SET) != (off_t)in->pos) {
+                break;
+            }
+            ssize_t got = read(in->fd, &d[done], len);
+            in->reads++;
+            if (got <= 0) {
+                break;
+            }
+            in->bytes += got;
+            in->pos += got;
+            done += got;
+        } else {
+            const uint8_t *data = in_data(in, &avail);
+            if (!data) {
+                break;
+            }
+            size_t len = MIN(n - done, avail);
+            memcpy(&d[done], data, len);
+            in->pos += len;
+            done += len;
+        }
+    }
+    return done;
+}
+
+/**
+ * @brief read one byte.
+ *
+ * @param in the input.
+ *
+ * @return the byte or EOF.
+ */
+int in_getc(input_t *in) {
+    size_t avail;
+    const uint8_t *data = in_data(in, &avail);
+    if (!data) {
+        return EOF;
+    }
+    in->pos++;
+    return *data;
+}
+
+/**
+ * @brief set the read position, positions beyond the end are allowed but nothing can be read there.
+ *
+ * @param in the input.
+ * @param pos the new position.
+ *
+ * @return true if the position is inside the file (or at its end).
+ */
+bool in_seek(input_t *in, uint64_t pos) {
+    in->pos = pos;
+    return pos <= in->size;
+}
+
+/**
+ * @brief move the read position.
+ *
+ * @param in the input.
+ * @param n number of bytes to skip, negative values go back.
+ *
+ * @return true if the position is inside the file (or at its end).
+ */
+bool in_skip(input_t *in, int64_t n) {
+    if ((n < 0) && ((uint64_t)-n > in->pos)) {
+        return false;
+    }
+    return in_seek(in, in->pos + n);
+}
+
+/**
+ * @brief get the whole file in memory for codecs that only decode from memory.
+ * A mapped file is returned directly, else the file is read once and kept until in_close().
+ *
+ * @param in the input.
+ *
+ * @return in->size bytes or NULL if the file can't be read.
+ */
+const uint8_t *in_contents(input_t *in) {
+    if (in->map) {
+        return in->map;
+    }
+    if (!in->contents) {
+        uint64_t pos = in->pos;
+        uint8_t *contents = malloc(in->size ? in->size : 1);
+        if (!contents) {
+            DEBUGF("Can't allocate %lu bytes for %s\n", (unsigned long)in->size, in->filename);
+            return NULL;
+        }
+        in->pos = 0;
+        if (in_read(in, contents, in->size) != in->size) {
+            DEBUGF("Can't read %s\n", in->filename);
+            free(contents);
+            in->pos = pos;
+            return NULL;
+        }
+        in->pos = pos;
+        in->contents = contents;
+    }
+    return in->contents;
+}
+
+/**
+ * @brief wrap an input into a PACKFILE for Allegro's loaders. Closing the PACKFILE leaves the input open.
+ *
+ * @param in the input.
+ *
+ * @return the PACKFILE or NULL.
+ */
+PACKFILE *in_packfile(input_t *in) { return pack_fopen_vtable(&in_vtable, in); }
+
+/**
+ * @brief open a file and load it with a loader that reads from an input.
+ *
+ * @param filename the image file.
+ * @param pal returns the palette of 8bpp images.
+ * @param load the loader.
+ *
+ * @return the image or NULL.
+ */
+BITMAP *in_load(const char *filename, RGB *pal, in_loader_t load) {
+    input_t in;
+
+    if (!in_open(&in, filename)) {
+        return NULL;
+    }
+    BITMAP *bm = load(&in, pal);
+    in_close(&in);
+    return bm;
+}
@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#define IN_BUFFER_SIZE (64 * 1024)  //!< size of the read buffer, reads are aligned to this size
+#define IN_ALIGN 32                 //!< alignment of the read buffer in memory
+
+/************
+** structs **
+************/
+//! an image file opened for reading, either memory mapped or read through one large buffer
+typedef struct __input {
+    const char *filename;  //!< name of the file (not copied)
+    int fd;                //!< file descriptor if the file is not mapped, -1 else
+    const uint8_t *map;    //!< the mapped file or NULL
+    uint8_t *buf;          //!< the read buffer (aligned)
+    void *buf_alloc;       //!< allocation of the read buffer
+    size_t buf_len;        //!< number of valid bytes in buf
+    uint64_t buf_start;    //!< file offset of the first byte in buf
+    uint8_t *contents;     //!< the whole file if in_contents() had to read it
+    uint64_t pos;          //!< current read position
+    uint64_t size;         //!< size of the file in bytes
+    uint32_t reads;        //!< number of reads from the file
+    uint64_t bytes;        //!< number of bytes read from the file
+} input_t;
+
+//! an image loader reading from an input
+typedef BITMAP *(*in_loader_t)(input_t *in, RGB *pal);
+
+/***********************
+** exported functions **
+***********************/
+extern bool in_open(input_t *in, const char *filename);
+extern void in_close(input_t *in);
+extern const uint8_t *in_data(input_t *in, size_t *avail);
+extern size_t in_read(input_t *in, void *dst, size_t n);
+extern int in_getc(input_t *in);
+extern bool in_seek(input_t *in, uint64_t pos);
+extern bool in_skip(input_t *in, int64_t n);
+extern const uint8_t *in_contents(input_t *in);
+extern PACKFILE *in_packfile(input_t *in);
+extern BITMAP *in_load(const char *filename, RGB *pal, in_loader_t load);
+
+#endif  // __INPUT_H__
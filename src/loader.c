@@ -0,0 +1,227 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "loader.h"
+#include "diskcache.h"
+#include "probe.h"
+#include "sniff.h"
+#include "util.h"
+#include "stats.h"
+
+/************
+** defines **
+************/
+#define LD_CACHE_MIN_DECODE 250000  //!< images decoded faster than this [us] are not put into the disk cache
+
+/************
+** globals **
+************/
+static const char *ld_quality_names[] = {"fast", "normal", "best"};  //!< indexed by LOAD_FAST..LOAD_BEST
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief choose size and color depth for a probed image.
+ *
+ * @param opt load options.
+ * @param filename the image file.
+ * @param budget memory budget in bytes.
+ * @param probe the header of the image.
+ * @param plan the result.
+ *
+ * @return true if the plan fits into the budget.
+ */
+static bool ld_fit(const ld_options_t *opt, const char *filename, uint64_t budget, const probe_t *probe, gv_plan_t *plan) {
+    bool fits = gv_plan(probe, budget, opt->depth, opt->screen_width, opt->screen_height, opt->cache_margin, plan);
+    DEBUGF("plan for %s: 1/%d @ %dbpp%s, %lu of %lu bytes%s\n", filename, plan->shrink, plan->depth, plan->tiled ? " tiled" : "", (unsigned long)plan->need,
+           (unsigned long)plan->budget, fits ? "" : " (does not fit)");
+    return fits;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief find a load_quality by name.
+ *
+ * @param name the name (fast, normal or best).
+ *
+ * @return LOAD_FAST..LOAD_BEST or -1 if the name is unknown.
+ */
+int ld_quality_from_name(const char *name) {
+    for (int i = LOAD_FAST; i <= LOAD_BEST; i++) {
+        if (strcasecmp(name, ld_quality_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief get the name of a load_quality.
+ *
+ * @param quality LOAD_FAST..LOAD_BEST.
+ *
+ * @return the name.
+ */
+const char *ld_quality_name(int quality) { return ld_quality_names[quality]; }
+
+/**
+ * @brief pick the load_quality for this CPU (Allegro's check_cpu() must have run).
+ * 386 and 486 multiply slowly (13-42 cycles), the inexact IDCT needs far fewer multiplications and the plain chroma
+ * upsampling saves the smoothing filter. From the Pentium on (10 cycles) the accurate integer IDCT costs little,
+ * see dvbench -j for the numbers of a machine.
+ *
+ * @return LOAD_FAST or LOAD_NORMAL.
+ */
+int ld_default_quality(void) { return (cpu_family < 5) ? LOAD_FAST : LOAD_NORMAL; }
+
+/**
+ * @brief get the memory budget for loading images.
+ *
+ * @param opt load options.
+ *
+ * @return bytes, 0 if unknown.
+ */
+uint64_t ld_budget(const ld_options_t *opt) { return opt->mem_limit ? (uint64_t)opt->mem_limit << 20 : gv_available(); }
+
+/**
+ * @brief choose size and color depth for an image so it fits into memory.
+ *
+ * @param opt load options.
+ * @param filename the image file.
+ * @param budget memory budget in bytes (see ld_budget()).
+ * @param probe returns the header of the image.
+ * @param plan the result.
+ *
+ * @return true if the plan fits into the budget.
+ */
+bool ld_plan(const ld_options_t *opt, const char *filename, uint64_t budget, probe_t *probe, gv_plan_t *plan) {
+    pr_probe(filename, probe);
+    return ld_fit(opt, filename, budget, probe, plan);
+}
+
+/**
+ * @brief load an image as planned by ld_plan(), from the disk cache if possible.
+ * The file is opened once, the decoder reuses what was read for the plan.
+ * Images that are shown are converted to the planned color depth (8bpp images are kept).
+ *
+ * @param opt load options.
+ * @param filename the image file.
+ * @param img the result, must be freed with ld_free() even if loading fails.
+ *
+ * @return true for success, false if loading failed or a saved image does not fit into memory at full size (see img->fits).
+ */
+bool ld_load(const ld_options_t *opt, const char *filename, ld_image_t *img) {
+    input_t in;
+
+    memset(img, 0, sizeof(ld_image_t));
+    st_reset();
+    st_push(ST_PROBE);
+    if (!in_open(&in, filename)) {
+        st_pop();
+        return false;
+    }
+    pr_probe_in(&in, &img->probe);
+    img->fits = ld_fit(opt, filename, ld_budget(opt), &img->probe, &img->plan);
+    st_pop();
+    if (!img->fits && !opt->screen_width) {
+        // a conversion needs the full image, the caller reports how much memory is missing
+        in_close(&in);
+        return false;
+    }
+    load_shrink = img->plan.shrink;
+    load_depth = img->plan.depth;
+
+    // an image too large for memory is kept in a swap file, the loaded bitmap is only an overview then
+    ts_init(&img->tiles, img->plan.cache);
+    if (img->plan.tiled) {
+        load_tiles = &img->tiles;
+        // the tile store keeps the image as stored, the probe describes what is loaded
+        if (img->probe.turned) {
+            int w = img->probe.width;
+            img->probe.width = img->probe.height;
+            img->probe.height = w;
+            img->probe.turned = false;
+        }
+    }
+
+    // images in the disk cache don't need to be decoded again, tiled images are not cached
+    bool use_cache = opt->cache_dir && !img->plan.tiled;
+    if (use_cache) {
+        st_push(ST_CACHE);
+        img->bm = dc_load(opt->cache_dir, filename, load_depth, load_shrink, img->pal);
+        st_pop();
+    }
+    if (!img->bm) {
+        uint64_t start = ut_time_us();
+        // the loader is chosen by the format found in the header, a misnamed file is not decoded with the wrong codec
+        sn_loader_t load = sn_loader(img->probe.format);
+        st_push(ST_DECODE);
+        img->bm = load ? load(&in, img->pal) : load_bitmap(filename, img->pal);
+        st_pop();
+        if (img->bm && use_cache && (ut_time_us() - start > LD_CACHE_MIN_DECODE)) {
+            st_push(ST_CACHE);
+            dc_store(opt->cache_dir, filename, load_depth, load_shrink, img->bm, img->pal);
+            dc_trim(opt->cache_dir, (uint64_t)opt->cache_size << 20);
+            st_pop();
+        }
+    }
+    in_close(&in);
+    load_tiles = NULL;
+    if (!img->bm) {
+        return false;
+    }
+    DEBUGF("image size = %dx%d @ %dbpp\n", img->bm->w, img->bm->h, bitmap_color_depth(img->bm));
+
+    // convert image to the planned color depth, only needed if the loader could not decode to it directly
+    if (opt->screen_width && (bitmap_color_depth(img->bm) != load_depth) && (bitmap_color_depth(img->bm) != 8)) {
+        DEBUGF("converting %dbpp image to %dbpp\n", bitmap_color_depth(img->bm), load_depth);
+        st_push(ST_CONVERT);
+        BITMAP *tmp = create_bitmap_ex(load_depth, img->bm->w, img->bm->h);
+        if (tmp) {
+            blit(img->bm, tmp, 0, 0, 0, 0, img->bm->w, img->bm->h);
+        }
+        st_pop();
+        if (!tmp) {
+            return false;
+        }
+        destroy_bitmap(img->bm);
+        img->bm = tmp;
+    }
+    st_get(&img->stats);
+    return true;
+}
+
+/**
+ * @brief free a loaded image.
+ *
+ * @param img the image.
+ */
+void ld_free(ld_image_t *img) {
+    if (img->bm) {
+        destroy_bitmap(img->bm);
+        img->bm = NULL;
+    }
+    ts_exit(&img->tiles);
+}
@@ -0,0 +1,67 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __LOADER_H__
+#define __LOADER_H__
+
+#include "main.h"
+#include "governor.h"
+#include "tilestore.h"
+#include "stats.h"
+
+/************
+** structs **
+************/
+//! how images are loaded
+typedef struct __ld_options {
+    int depth;              //!< color depth of the screen, 32 when the image is saved
+    int screen_width;       //!< width of the screen, 0 when the image is saved instead of shown
+    int screen_height;      //!< height of the screen
+    int cache_margin;       //!< margin of the viewer cache
+    int mem_limit;          //!< memory budget in MiB, 0 to use the available memory
+    const char *cache_dir;  //!< directory of the disk cache or NULL
+    int cache_size;         //!< size limit of the disk cache in MiB
+} ld_options_t;
+
+//! a loaded image
+typedef struct __ld_image {
+    BITMAP *bm;          //!< the image (screen depth or 8bpp when it is shown), only an overview if the tile store is used
+    PALETTE pal;         //!< palette of 8bpp images
+    tile_store_t tiles;  //!< the full size image if it did not fit into memory
+    probe_t probe;       //!< header of the image
+    gv_plan_t plan;      //!< how the image was loaded
+    bool fits;           //!< the plan fitted into the memory budget
+    st_report_t stats;   //!< time and heap use of the stages while loading
+} ld_image_t;
+
+/***********************
+** exported functions **
+***********************/
+extern int ld_quality_from_name(const char *name);
+extern const char *ld_quality_name(int quality);
+extern int ld_default_quality(void);
+extern uint64_t ld_budget(const ld_options_t *opt);
+extern bool ld_plan(const ld_options_t *opt, const char *filename, uint64_t budget, probe_t *probe, gv_plan_t *plan);
+extern bool ld_load(const ld_options_t *opt, const char *filename, ld_image_t *img);
+extern void ld_free(ld_image_t *img);
+
+#endif  // __LOADER_H__
@@ -1,5 +1,8 @@
 #include <conio.h>
+#include <ctype.h>
 #include <stdarg.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "main.h"
 
@@ -11,18 +14,50 @@
 #include "format-tiff.h"
 #include "format-jasper.h"
 #include "format-stb.h"
+#include "format-gif.h"
+#include "display.h"
+#include "viewer.h"
+#include "resample.h"
+#include "sink.h"
+#include "probe.h"
+#include "sniff.h"
+#include "diskcache.h"
+#include "loader.h"
+#include "prefetch.h"
+#include "sheet.h"
+#include "util.h"
+#include "stats.h"
+#include "trace.h"
 
 #define EXIT_SUCCESS 0
 #define EXIT_FAILURE 1
 
 #define DEFAULT_MODE 1
 
-#define MIN_ZOOM 100
+#define DEFAULT_CACHE_MARGIN 128  //!< default number of pixels pre-scaled around the visible area
+
+#define DEFAULT_FILTER RS_BILINEAR  //!< default resampling filter
+
+#define PROGRESS_SHOW_US 100000   //!< the viewer's progress bar is redrawn at most this often [us]
+#define PROGRESS_PRINT_US 500000  //!< batch mode prints its progress line at most this often [us]
+
+#ifdef TRACE_ENABLED
+#define TRACE_OPT "T:"  //!< -T <file> is only there when tracing is compiled in
+#else
+#define TRACE_OPT ""
+#endif
 
 #define FORMATS_READ "BMP, PCX, TGA, QOI, JPG, PNG, WEB, TIF, JP2, GIF\n                 PNM, PBM, PGM, PPM, LBM, PSD, HDR, PIC"
 #define FORMATS_WRITE "BMP, PCX, TGA, QOI, JPG, PNG, WEB, TIF, JP2, GIF\n                 PNM, PBM, PGM, PPM"
 
 int output_quality = 95;
+int load_depth = 32;  //!< color depth the format loaders decode to
+int load_shrink = 1;  //!< the format loaders reduce the image size by this factor
+tile_store_t *load_tiles = NULL;  //!< the format loaders also store the full size image here (if set)
+bool load_preview = false;        //!< the format loaders may trade quality for speed (thumbnails)
+int load_quality = -1;            //!< speed/quality trade-off of the format loaders (LOAD_FAST..LOAD_BEST), -1 picks one by CPU
+bool (*load_scan)(BITMAP *bm, RGB *pal, bool temporary) = NULL;  //!< loaders pass what they decoded so far (temporary: freed afterwards), false aborts loading (if set)
+bool (*load_progress)(uint32_t done, uint32_t total) = NULL;  //!< the format loaders report how far they are, false aborts loading (if set)
 
 typedef struct __gfx_mode gfx_mode_t;
 
@@ -33,7 +68,34 @@ struct __gfx_mode {
     int bpp;
 };
 
+//! an image shown while it is loaded, progressive images scan by scan, see show_scan() and show_progress()
+typedef struct __scan_view {
+    view_t view;              //!< the view, initialized by the first scan
+    view_input_t input;       //!< keys pressed while loading that were not applied yet
+    uint64_t drawn;           //!< time the progress bar was drawn last
+    bool shown;               //!< a scan was shown
+    bool left;                //!< the user did not wait for the image
+    int step;                 //!< what the user chose instead of waiting for the image (see vw_show())
+    const ld_options_t *opt;  //!< load options
+    const char *filename;     //!< the image file
+    int index;                //!< number of the image in the list
+    int num_files;            //!< number of images in the list
+    int filter;               //!< resampling filter
+    bool linear;              //!< scale in linear light
+} scan_view_t;
+
+//! throughput and time left of the image loaded with -s, see print_progress()
+typedef struct __batch_progress {
+    const char *filename;  //!< the image file
+    uint64_t size;         //!< size of the file in bytes
+    uint64_t start;        //!< time loading started
+    uint64_t printed;      //!< time the progress line was printed last, 0 if it was never printed
+    bool aborted;          //!< the user pressed ESC
+} batch_progress_t;
+
 static char *lastError;
+static scan_view_t scan_view;            //!< the image currently loaded by show_images()
+static batch_progress_t batch_progress;  //!< the image currently loaded with -s
 
 /**
  * @brief print our banner.
@@ -53,14 +115,36 @@ static void banner(FILE *out) {
 static void usage() {
     banner(stderr);
     fputs("Usage:\n", stderr);
-    fputs("  DOSVIEW.EXE [-hkl] [-q <quality>] [-r <num>] [-s <outfile>] <infile>\n", stderr);
+    fputs("  DOSVIEW.EXE [-hklgBtiIvV] [-q <quality>] [-r <num>] [-c <pixels>] [-x <filter>] [-m <MiB>] [-C <dir>] [-z <MiB>] [-s <outfile>]\n", stderr);
+    fputs("              [-D <quality>] [-R <degrees>] [-F <h|v>] [-X <WxH+X+Y>] <infile>...\n", stderr);
+    fputs("  <infile>...  : one or more images or a directory, SPACE/BACKSPACE show the next/previous one.\n", stderr);
     fputs("  -h           : show this screen.\n", stderr);
     fputs("  -k           : keys help.\n", stderr);
     fputs("  -l           : list know screen modes.\n", stderr);
     fputs("  -r <num>     : screen mode to use (use -l for a list).\n", stderr);
     fputs("  -s <outfile> : do not show the image, save it to outfile instead.\n", stderr);
     fputs("  -f <factor>  : scale saved image, <1 reduce, >1 enlarge (float).\n", stderr);
+    fputs("  -R <degrees> : with -s: rotate a JPEG clockwise by 0, 90, 180 or 270 degrees without recompressing it,\n", stderr);
+    fputs("                 the EXIF orientation is applied first (-R 0 only does that).\n", stderr);
+    fputs("  -F <h|v>     : with -s: mirror a JPEG horizontally or vertically (before -R) without recompressing it.\n", stderr);
+    fputs("  -X <WxH+X+Y> : with -s: crop a JPEG (after -R/-F) without recompressing it, offsets are rounded down to 8/16 pixels.\n", stderr);
     fputs("  -q <quality> : Quality for writing JPG/WEP/JP2 image (1..100). Default: 95\n", stderr);
+    fputs("  -c <pixels>  : size of the pre-scaled margin around the screen for fast panning (0 to disable). Default: 128\n", stderr);
+    fputs("  -x <filter>  : scaling filter: nearest, box, bilinear, bicubic or lanczos3. Default: bilinear\n", stderr);
+    fputs("  -g           : scale in linear light (gamma corrected).\n", stderr);
+    fputs("  -D <quality> : decoding: fast, normal or best (float IDCT, optimized palette for 8bpp). Default: fast on 386/486, else normal\n", stderr);
+    fputs("  -m <MiB>     : memory budget for loading the image. Default: free memory\n", stderr);
+    fputs("  -C <dir>     : keep decoded images in this directory, reopening them is much faster.\n", stderr);
+    fputs("  -z <MiB>     : size limit of the -C directory. Default: 64\n", stderr);
+    fputs("  -t           : show a contact sheet of the images, ENTER opens the selected one, ESC in the viewer returns to it.\n", stderr);
+    fputs("  -i           : print width, height, depth, compression etc. of the images as JSON lines, only the headers are read.\n", stderr);
+    fputs("  -I           : like -i, but as CSV.\n", stderr);
+    fputs("  -v           : with -s: print time and peak memory of each stage (probe, decode, convert, scale, encode...).\n", stderr);
+    fputs("  -V           : like -v, but as JSON.\n", stderr);
+#ifdef TRACE_ENABLED
+    fputs("  -T <file>    : write a Chrome trace (chrome://tracing, Perfetto) of decoding and drawing to file.\n", stderr);
+#endif
+    fputs("  -B           : benchmark the scaling filters with <infile> and exit.\n", stderr);
     fputs("\n", stderr);
     fputs("Input formats  : " FORMATS_READ " \n", stderr);
     fputs("Output formats : " FORMATS_WRITE " \n", stderr);
@@ -78,6 +162,11 @@ static void keys() {
     fputs("  - `F`             : show actual size\n", stderr);
     fputs("  - `Z`             : fit to screen\n", stderr);
     fputs("  - `I`             : toggle image info\n", stderr);
+    fputs("  - `SPACE`         : next image\n", stderr);
+    fputs("  - `BACKSPACE`     : previous image\n", stderr);
+    fputs("  - `ENTER`         : open image (contact sheet)\n", stderr);
+    fputs("  - `HOME`/`7`      : first image (contact sheet)\n", stderr);
+    fputs("  - `END`/`1`       : last image (contact sheet)\n", stderr);
     fputs("  - `PAGE UP`/`9`   : increase zoom\n", stderr);
     fputs("  - `PAGE DOWN`/`3` : decrease zoom\n", stderr);
     fputs("  - `UP`/`8`        : move image up\n", stderr);
@@ -241,6 +330,7 @@ static void list_modes(gfx_mode_t *modes) {
 static void register_formats() {
     alpng_init();
     algif_init();
+    register_bitmap_file_type("gif", load_gif8, save_gif, NULL);
     register_bitmap_file_type("qoi", load_qoi, save_qoi, NULL);
     register_bitmap_file_type("web", load_webp, save_webp, NULL);
     register_bitmap_file_type("jpg", load_jpeg, save_jpeg, NULL);
@@ -275,6 +365,331 @@ static void clean_exit(int code) {
     exit(code);
 }
 
+/**
+ * @brief compare two strings for qsort().
+ */
+static int compare_names(const void *a, const void *b) { return strcmp(*(char *const *)a, *(char *const *)b); }
+
+/**
+ * @brief get the image files of a directory, sorted by name.
+ *
+ * @param dir the directory.
+ * @param num returns the number of files.
+ *
+ * @return array of malloc()ed file names.
+ */
+static char **scan_dir(const char *dir, int *num) {
+    char **files = NULL;
+
+    *num = 0;
+    DIR *d = opendir(dir);
+    if (!d) {
+        return NULL;
+    }
+
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        char **f = realloc(files, (*num + 1) * sizeof(char *));
+        char *name = malloc(strlen(dir) + strlen(de->d_name) + 2);
+        if (!f || !name) {
+            fputs("OUT OF MEMORY\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        files = f;
+        sprintf(name, "%s/%s", dir, de->d_name);
+
+        // images are recognized by their header, whatever their extension is
+        sniff_t s;
+        if (!sn_sniff(name, &s) || !sn_loader(s.format)) {
+            free(name);
+            continue;
+        }
+        files[(*num)++] = name;
+    }
+    closedir(d);
+
+    qsort(files, *num, sizeof(char *), compare_names);
+    return files;
+}
+
+/**
+ * @brief get the list of images from the command line, a single directory is replaced by the images in it.
+ *
+ * @param args the file arguments.
+ * @param num_args number of file arguments.
+ * @param num returns the number of files.
+ *
+ * @return array of file names.
+ */
+static char **get_files(char **args, int num_args, int *num) {
+    struct stat st;
+
+    if ((num_args == 1) && (stat(args[0], &st) == 0) && S_ISDIR(st.st_mode)) {
+        return scan_dir(args[0], num);
+    }
+    *num = num_args;
+    return args;
+}
+
+/**
+ * @brief run the resampling benchmark and exit.
+ * No graphics mode is needed for this, the image is loaded as 32bpp.
+ *
+ * @param infile the image to use.
+ * @param linear true to scale in linear light.
+ */
+static void benchmark(const char *infile, bool linear) {
+    PALETTE pal;
+
+    set_color_depth(32);
+    BITMAP *bm = sn_load(infile, pal);
+    if (!bm) {
+        set_last_error("Can't load image %s", infile);
+        clean_exit(EXIT_SUCCESS);
+    }
+
+    banner(stdout);
+    fprintf(stdout, "Loaded %s (%dx%d)\n", infile, bm->w, bm->h);
+    rs_benchmark(bm, linear, stdout);
+    destroy_bitmap(bm);
+    clean_exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief rotate, flip and/or crop a JPEG losslessly and exit, the image is not decoded.
+ *
+ * @param infile the JPEG.
+ * @param outfile the file to write.
+ * @param t the transformation.
+ * @param verbose 'v' or 'V' to print the time of the stages.
+ */
+static void transform(const char *infile, const char *outfile, const jpeg_transform_t *t, int verbose) {
+    st_reset();
+    if (!transform_jpeg(infile, outfile, t)) {
+        set_last_error("Can't transform %s, only JPEG files can be rotated, flipped and cropped losslessly", infile);
+        clean_exit(EXIT_SUCCESS);
+    }
+
+    banner(stdout);
+    fprintf(stdout, "Wrote %s\n", outfile);
+    if (verbose) {
+        st_report_t report;
+        st_get(&report);
+        st_print(stdout, infile, &report, verbose == 'V');
+    }
+    clean_exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief print the header information of images to stdout, the images are not decoded.
+ *
+ * @param files the images.
+ * @param num_files number of images.
+ * @param csv true for CSV, else one JSON object per line.
+ */
+static void print_info(char **files, int num_files, bool csv) {
+    probe_t probe;
+
+    pr_print_header(stdout, csv);
+    for (int i = 0; i < num_files; i++) {
+        bool ok = pr_probe(files[i], &probe);
+        pr_print(stdout, files[i], &probe, ok, csv);
+    }
+    clean_exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief load_scan() hook of show_images(): show a progressive image while it is decoded.
+ * The view is set up with the first scan, the user can zoom and pan or leave before the image is complete.
+ *
+ * @param bm the image decoded so far.
+ * @param pal its palette.
+ * @param temporary bm is destroyed after the call.
+ *
+ * @return false if the user wants to quit or see another image.
+ */
+static bool show_scan(BITMAP *bm, RGB *pal, bool temporary) {
+    scan_view_t *sv = &scan_view;
+
+    if (!sv->shown) {
+        if ((bitmap_color_depth(bm) == 8) || (get_color_depth() == 8)) {
+            sk_set_palette(pal);
+        }
+        vw_init(&sv->view, bm, NULL, sv->filename, sv->opt->screen_width, sv->opt->screen_height, 0, sv->filter, sv->linear);
+        sv->view.image_index = sv->index;
+        sv->view.num_images = sv->num_files;
+        sv->shown = true;
+    }
+    sv->left = !vw_refresh(&sv->view, &sv->input, &sv->step);
+
+    // e.g. the EXIF thumbnail, the scans of the image itself get a new view
+    if (temporary) {
+        vw_exit(&sv->view);
+        sv->shown = false;
+    }
+    return !sv->left;
+}
+
+/**
+ * @brief load_progress() hook of show_images(): draw a progress bar over the screen and collect the keys pressed while loading.
+ * ESC/Q and SPACE/BACKSPACE abort loading, everything else is applied when the image (or the next scan) is shown.
+ *
+ * @param done work done.
+ * @param total total work.
+ *
+ * @return false if the user wants to quit or see another image.
+ */
+static bool show_progress(uint32_t done, uint32_t total) {
+    scan_view_t *sv = &scan_view;
+
+    vw_read_keys(&sv->input);
+    if (sv->input.quit || (sv->input.step && (sv->num_files > 1))) {
+        sv->step = sv->input.quit ? 0 : sv->input.step;
+        sv->left = true;
+        return false;
+    }
+
+    // short loads stay invisible
+    uint64_t now = ut_time_us();
+    if (!sv->drawn) {
+        sv->drawn = now;
+    } else if (now - sv->drawn >= PROGRESS_SHOW_US) {
+        vw_draw_progress(dp_get_buffer(), sv->filename, done, total);
+        dp_present();
+        sv->drawn = now;
+    }
+    return true;
+}
+
+/**
+ * @brief load_progress() hook for -s: print throughput and the estimated time left to stderr, ESC aborts loading.
+ *
+ * @param done work done.
+ * @param total total work.
+ *
+ * @return false if the user pressed ESC.
+ */
+static bool print_progress(uint32_t done, uint32_t total) {
+    batch_progress_t *bp = &batch_progress;
+
+    if (keyboard_needs_poll()) {
+        poll_keyboard();
+    }
+    while (keypressed()) {
+        if ((readkey() >> 8) == KEY_ESC) {
+            bp->aborted = true;
+            return false;
+        }
+    }
+
+    uint64_t now = ut_time_us();
+    uint64_t elapsed = now - bp->start;
+    if ((elapsed < PROGRESS_PRINT_US) || (bp->printed && (now - bp->printed < PROGRESS_PRINT_US))) {
+        return true;
+    }
+
+    // the loaders count rows, strips or bytes, the file is assumed to be read at the same pace
+    double fraction = (double)MAX(done, 1) / total;
+    double seconds = elapsed / 1000000.0;
+    fprintf(stderr, "\rLoading %s: %3d%%, %lu KiB/s, %lus left  ", bp->filename, (int)(fraction * 100), (unsigned long)(fraction * bp->size / 1024 / seconds),
+            (unsigned long)(seconds * (1.0 - fraction) / fraction + 0.5));
+    bp->printed = now;
+    return true;
+}
+
+/**
+ * @brief show images in the viewer until the user quits, SPACE/BACKSPACE step through the list.
+ * The neighbours of the image shown are loaded while the user looks at it.
+ *
+ * @param opt load options.
+ * @param files the images.
+ * @param num_files number of images.
+ * @param index index of the first image to show.
+ * @param filter resampling filter.
+ * @param linear true to scale in linear light.
+ *
+ * @return index of the image shown last.
+ */
+static int show_images(const ld_options_t *opt, char **files, int num_files, int index, int filter, bool linear) {
+    prefetch_t pf;
+    pf_init(&pf, opt, files, num_files);
+    pf.scan = show_scan;
+    pf.progress = show_progress;
+    int step = 1;
+    int failed = 0;
+    while (true) {
+        // progressive images are shown while they are decoded, the others get a progress bar if they take long
+        scan_view_t *sv = &scan_view;
+        *sv = (scan_view_t){.opt = opt, .filename = files[index], .index = index, .num_files = num_files, .filter = filter, .linear = linear};
+        vw_clear_input(&sv->input);
+        pf_slot_t *s = pf_get(&pf, index);
+        if (sv->left) {
+            // the user did not wait for the image, this is not an error
+            if (sv->shown) {
+                vw_exit(&sv->view);
+            }
+            pf_drop(&pf, index);
+            if (!sv->step) {
+                break;
+            }
+            step = sv->step;
+            index = ((index + step) % num_files + num_files) % num_files;
+            continue;
+        }
+        if (!s->ok) {
+            if (sv->shown) {
+                vw_exit(&sv->view);
+            }
+            if (s->img.fits) {
+                set_last_error("Can't load image %s", files[index]);
+            } else {
+                set_last_error("Can't load image %s, not enough memory (%lu KiB needed)", files[index], (unsigned long)(s->img.plan.need >> 10));
+            }
+
+            // skip broken files in the direction the user is going
+            if (++failed >= num_files) {
+                break;
+            }
+            index = (index + step + num_files) % num_files;
+            continue;
+        }
+        failed = 0;
+        clear_last_error();
+
+        if ((bitmap_color_depth(s->img.bm) == 8) || (get_color_depth() == 8)) {
+            sk_set_palette(s->img.pal);
+        }
+
+        view_t view;
+        vw_init(&view, s->img.bm, s->img.tiles.num_levels ? &s->img.tiles : NULL, files[index], opt->screen_width, opt->screen_height, opt->cache_margin,
+                filter, linear);
+        view.image_index = index;
+        view.num_images = num_files;
+        view.stats = &s->img.stats;
+        if (sv->shown) {
+            // keep what the user did while the image was loaded
+            vw_take_position(&view, &sv->view);
+            vw_exit(&sv->view);
+        }
+        view.idle = pf_idle;
+        view.idle_ctx = &pf;
+        if (vw_apply_input(&view, &sv->input)) {
+            step = vw_show(&view);
+        } else {
+            // quit or step key pressed after the last progress report
+            step = sv->input.quit ? 0 : sv->input.step;
+        }
+        vw_exit(&view);
+
+        if (!step) {
+            break;
+        }
+        index = ((index + step) % num_files + num_files) % num_files;
+    }
+    pf_exit(&pf);
+    return index;
+}
+
 /**
  * @brief main entry point
  *
@@ -291,15 +706,24 @@ int main(int argc, char *argv[]) {
     int screen_bpp = 0;
     int screen_width = 0;
     int screen_height = 0;
-    int x_start = 0;
-    int y_start = 0;
     int scaled_height;
     int scaled_width;
-    float factor = 1.0f;  // 1.0 is 'fit on screen'
-    bool image_info = false;
     float scale = 1.0f;
-
-    while ((opt = getopt(argc, argv, "klhr:s:q:f:")) != -1) {
+    int cache_margin = DEFAULT_CACHE_MARGIN;
+    int filter = DEFAULT_FILTER;
+    bool linear = false;
+    bool bench = false;
+    bool contact = false;
+    int info = 0;
+    int verbose = 0;
+    int mem_limit = 0;
+    int num_files = 0;
+    char *cache_dir = NULL;
+    int cache_size = DC_DEFAULT_SIZE;
+    jpeg_transform_t xform = {0};
+    bool transforming = false;
+
+    while ((opt = getopt(argc, argv, "klhgBtiIvVr:s:q:f:c:x:D:m:C:z:R:F:X:" TRACE_OPT)) != -1) {
         switch (opt) {
             case 'r':
                 user_mode = atoi(optarg);
@@ -310,9 +734,83 @@ int main(int argc, char *argv[]) {
             case 'f':
                 scale = atof(optarg);
                 break;
+            case 'c':
+                cache_margin = atoi(optarg);
+                break;
+            case 'x':
+                filter = rs_filter_from_name(optarg);
+                if (filter < 0) {
+                    usage();
+                }
+                break;
+            case 'D':
+                load_quality = ld_quality_from_name(optarg);
+                if (load_quality < 0) {
+                    usage();
+                }
+                break;
+            case 'm':
+                mem_limit = atoi(optarg);
+                if (mem_limit <= 0) {
+                    usage();
+                }
+                break;
+            case 'C':
+                cache_dir = optarg;
+                break;
+            case 'z':
+                cache_size = atoi(optarg);
+                if (cache_size <= 0) {
+                    usage();
+                }
+                break;
+            case 'g':
+                linear = true;
+                break;
+            case 'B':
+                bench = true;
+                break;
+            case 't':
+                contact = true;
+                break;
+            case 'i':
+            case 'I':
+                info = opt;
+                break;
+            case 'v':
+            case 'V':
+                verbose = opt;
+                break;
             case 's':
                 outfile = optarg;
                 break;
+            case 'R':
+                xform.rotate = atoi(optarg);
+                transforming = true;
+                if ((xform.rotate != 0) && (xform.rotate != 90) && (xform.rotate != 180) && (xform.rotate != 270)) {
+                    usage();
+                }
+                break;
+            case 'F':
+                xform.flip = tolower(optarg[0]);
+                transforming = true;
+                if (((xform.flip != 'h') && (xform.flip != 'v')) || optarg[1]) {
+                    usage();
+                }
+                break;
+            case 'X':
+                xform.crop = optarg;
+                transforming = true;
+                break;
+#ifdef TRACE_ENABLED
+            case 'T':
+                if (!tr_open(optarg)) {
+                    fprintf(stderr, "Could not create trace file %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                alpng_trace = tr_event;
+                break;
+#endif
             case 'l':
                 list_modes(NULL);
                 break;
@@ -326,21 +824,49 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (optind < argc) {
-        infile = argv[optind];
-    } else {
+    if (optind >= argc) {
+        usage();
+    }
+    char **files = get_files(&argv[optind], argc - optind, &num_files);
+    if (!num_files || (outfile && (num_files > 1 || contact || info))) {
         usage();
     }
+    infile = files[0];
 
     if (output_quality < 1 || output_quality > 100) {
         usage();
     }
 
+    if (cache_margin < 0) {
+        usage();
+    }
+
+    // lossless transforms write a JPEG and can't scale
+    if (transforming && (!outfile || (scale != 1.0f))) {
+        usage();
+    }
+
     init_last_error();
     allegro_init();
     register_formats();
+    if (load_quality < 0) {
+        load_quality = ld_default_quality();
+    }
+    DEBUGF("CPU family %d, decoding quality %s\n", cpu_family, ld_quality_name(load_quality));
     install_keyboard();
-    set_color_conversion(COLORCONV_TOTAL);
+    set_color_conversion(COLORCONV_TOTAL & ~COLORCONV_EXPAND_256);  // paletted images stay 8bpp
+
+    if (bench) {
+        benchmark(infile, linear);
+    }
+
+    if (transforming) {
+        transform(infile, outfile, &xform, verbose);
+    }
+
+    if (info) {
+        print_info(files, num_files, info == 'I');
+    }
 
     gfx_mode_t *modes = get_supported_modes();
     gfx_mode_t *selected = NULL;
@@ -383,232 +909,113 @@ int main(int argc, char *argv[]) {
     }
     DEBUGF("%dx%d at %dbpp\n", screen_width, screen_height, get_color_depth());
 
-    PALETTE pal;
-    BITMAP *bm = load_bitmap(infile, pal);
-    if (!bm) {
-        set_last_error("Can't load image %s", infile);
-        clean_exit(EXIT_SUCCESS);
-    }
-
-    DEBUGF("image size = %dx%d @ %dbpp\n", bm->w, bm->h, bitmap_color_depth(bm));
+    // the viewer wants the image in display color depth, 8bpp images are kept as they are
+    ld_options_t ld_opt = {
+        .depth = outfile ? 32 : get_color_depth(),
+        .screen_width = outfile ? 0 : screen_width,
+        .screen_height = screen_height,
+        .cache_margin = cache_margin,
+        .mem_limit = mem_limit,
+        .cache_dir = cache_dir,
+        .cache_size = cache_size,
+    };
 
     if (!outfile) {
-        if (get_color_depth() == 8) {
-            set_palette(pal);
+        if (!dp_init(screen_width, screen_height, get_color_depth())) {
+            set_last_error("Can't create back buffer for %dx%d", screen_width, screen_height);
+            clean_exit(EXIT_SUCCESS);
         }
 
-        // convert image to display color depth
-        BITMAP *tmp = create_bitmap_ex(get_color_depth(), bm->w, bm->h);
-        blit(bm, tmp, 0, 0, 0, 0, bm->w, bm->h);
-        destroy_bitmap(bm);
-
-        // scale to "fit screen" factor
-        if (tmp->w > tmp->h) {
-            factor = (float)screen_width / (float)tmp->w;
+        if (contact) {
+            // the viewer returns to the contact sheet when it is closed
+            sheet_t sheet;
+            if (!sh_init(&sheet, files, num_files, screen_width, screen_height)) {
+                sh_exit(&sheet);
+                set_last_error("Can't create contact sheet for %d images", num_files);
+                clean_exit(EXIT_SUCCESS);
+            }
+            int index = 0;
+            while ((index = sh_show(&sheet, index)) >= 0) {
+                index = show_images(&ld_opt, files, num_files, index, filter, linear);
+            }
+            sh_exit(&sheet);
         } else {
-            factor = (float)screen_height / (float)tmp->h;
+            show_images(&ld_opt, files, num_files, 0, filter, linear);
         }
 
-        // calculate the scaled size of the image
-        scaled_width = tmp->w * factor;
-        scaled_height = tmp->h * factor;
-
-        while (true) {
-            //////
-            /// draw image
-            clear_to_color(screen, 0);
-
-            DEBUGF("start = %dx%d, factor=%f, scaled=%dx%d\n", x_start, y_start, factor, scaled_width, scaled_height);
-            int src_x, src_y, src_w, src_h, dest_x, dest_y, dest_w, dest_h;
-
-            if (scaled_width <= screen_width) {
-                DEBUG("W1\n");
-                src_x = 0;
-                src_w = tmp->w;
-                dest_x = (screen_width / 2 - scaled_width / 2);
-                dest_w = scaled_width;
-            } else {
-                DEBUG("W2\n");
-                src_x = x_start;
-                src_w = (tmp->w * screen_width) / scaled_width;
-                dest_x = 0;
-                dest_w = screen_width;
-            }
-
-            if (scaled_height <= screen_height) {
-                DEBUG("H1\n");
-                src_y = 0;
-                src_h = tmp->h;
-                dest_y = (screen_height / 2 - scaled_height / 2);
-                dest_h = scaled_height;
+        dp_exit();
+    } else {
+        ld_image_t img;
+        batch_progress = (batch_progress_t){.filename = infile, .size = file_size_ex(infile), .start = ut_time_us()};
+        load_progress = print_progress;
+        bool loaded = ld_load(&ld_opt, infile, &img);
+        load_progress = NULL;
+        if (batch_progress.printed) {
+            fputc('\n', stderr);
+        }
+        if (!loaded) {
+            if (batch_progress.aborted) {
+                set_last_error("Loading of %s aborted", infile);
+            } else if (img.fits) {
+                set_last_error("Can't load image %s", infile);
             } else {
-                DEBUG("H2\n");
-                src_y = y_start;
-                src_h = (tmp->h * screen_height) / scaled_height;
-                dest_y = 0;
-                dest_h = screen_height;
-            }
-
-            DEBUGF("stretch_blit(%d, %d, %d, %d ==> %d, %d, %d, %d)\n", src_x, src_y, src_w, src_h, dest_x, dest_y, dest_w, dest_h);
-            stretch_blit(tmp, screen, src_x, src_y, src_w, src_h, dest_x, dest_y, dest_w, dest_h);
-
-            //////
-            /// draw image
-            if (image_info) {
-                int ySpacing = font->height + 1;
-                int xPos = 20;
-                int yPos = 10;
-                int width = 25 * 8;
-                int height = ySpacing * 9;
-                if (strlen(infile) > 9) {
-                    width += (strlen(infile) - 9) * 8;
-                }
-
-                rectfill(screen, xPos, yPos, xPos + width, yPos + height, makecol(32, 32, 32));
-                rect(screen, xPos, yPos, xPos + width, yPos + height, makecol(227, 198, 34));
-
-                xPos += 8;
-                yPos += 8;
-                int txt_col = makecol(161, 21, 158);
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Filename    : %s", infile);
-                yPos += ySpacing;
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Image size  : %04dx%04d", tmp->w, tmp->h);
-                yPos += ySpacing;
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Screen size : %04dx%04d", screen_width, screen_height);
-                yPos += ySpacing;
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Screen bpp  : %dbpp", get_color_depth());
-                yPos += ySpacing;
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Scaled size : %04dx%04d", scaled_width, scaled_height);
-                yPos += ySpacing;
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Image pos   : %04dx%04d", x_start, y_start);
-                yPos += ySpacing;
-                textprintf_ex(screen, font, xPos, yPos, txt_col, -1, "Factor      : %.5f", factor);
-                yPos += ySpacing;
-            }
-
-            //////
-            /// handle input
-            if (keyboard_needs_poll()) {
-                poll_keyboard();
-            }
-            int key = readkey();
-            int key_upper = (key >> 8);
-            char key_lower = (char)(key & 0xFF);
-
-            DEBUGF("key=%04X\n", key);
-
-            // modifiers
-            int stepsize = 2;
-            float scale_step = 1.1f;
-            if (key_shifts & KB_SHIFT_FLAG) {
-                stepsize *= 2;
-                scale_step *= 2;
-            }
-            if (key_shifts & KB_CTRL_FLAG) {
-                stepsize *= 4;
-                scale_step *= 4;
-            }
-            if (key_shifts & KB_ALT_FLAG) {
-                stepsize *= 8;
-                scale_step *= 8;
-            }
-
-            // keys
-            if ((key_upper == KEY_ESC) || (key_lower == 'Q') || (key_lower == 'q')) {
-                break;  // exit
-            } else if ((key_upper == KEY_LEFT) || (key_lower == '4')) {
-                if (x_start > 0) {
-                    x_start -= stepsize;
-                }
-            } else if ((key_upper == KEY_RIGHT) || (key_lower == '6')) {
-                if ((scaled_width > screen_width) && (x_start + src_w < tmp->w)) {
-                    x_start += stepsize;
-                }
-            } else if ((key_upper == KEY_UP) || (key_lower == '8')) {
-                if (y_start > 0) {
-                    y_start -= stepsize;
-                }
-            } else if ((key_upper == KEY_DOWN) || (key_lower == '2')) {
-                if ((scaled_height > screen_height) && (y_start + screen_height < tmp->h)) {
-                    y_start += stepsize;
-                }
-            } else if ((key_upper == KEY_PGDN) || (key_lower == '3')) {
-                DEBUGF("factor = %f, scale_step = %f, new_factor = %f\n", factor, scale_step, factor / scale_step);
-                if ((scaled_width >= screen_width / MIN_ZOOM) && (scaled_height >= screen_height / MIN_ZOOM)) {
-                    factor /= scale_step;
-                }
-            } else if ((key_upper == KEY_PGUP) || (key_lower == '9')) {
-                DEBUGF("factor = %f, scale_step = %f, new_factor = %f\n", factor, scale_step, factor * scale_step);
-                factor *= scale_step;
-            } else if ((key_lower == 'F') || (key_lower == 'f')) {
-                // fit on screen
-                if (tmp->w > tmp->h) {
-                    factor = (float)screen_width / (float)tmp->w;
-                } else {
-                    factor = (float)screen_height / (float)tmp->h;
-                }
-            } else if ((key_lower == 'Z') || (key_lower == 'z')) {
-                factor = 1.0f;  // full zoom
-            } else if ((key_lower == 'i') || (key_lower == 'i')) {
-                image_info = !image_info;
-            }
-
-            //////
-            // sanitychecks
-            scaled_width = tmp->w * factor;
-            scaled_height = tmp->h * factor;
-
-            if (scaled_width > screen_width) {
-                src_w = (tmp->w * screen_width) / scaled_width;
-                if (x_start + src_w >= tmp->w) {
-                    x_start = tmp->w - src_w - 1;
-                }
-            }
-
-            if (scaled_height > screen_height) {
-                src_h = (tmp->h * screen_height) / scaled_height;
-                if (y_start + src_h >= tmp->h) {
-                    y_start = tmp->h - src_h - 1;
-                }
+                set_last_error("Can't load image %s, not enough memory (%lu KiB needed)", infile, (unsigned long)(img.plan.need >> 10));
             }
+            ld_free(&img);
+            clean_exit(EXIT_FAILURE);
+        }
+        BITMAP *bm = img.bm;
+        img.bm = NULL;
+        ld_free(&img);
+        RGB *pal = img.pal;
 
-            if (x_start < 0) {
-                x_start = 0;
-            }
-            if (y_start < 0) {
-                y_start = 0;
-            }
+        if ((bitmap_color_depth(bm) == 8) || (get_color_depth() == 8)) {
+            sk_set_palette(pal);
         }
-        destroy_bitmap(tmp);
-    } else {
+
         banner(stdout);
         fprintf(stdout, "Loaded %s\n", infile);
         fprintf(stdout, "Image is  %4dx%4d\n", bm->w, bm->h);
         if (scale == 1.0f) {
-            if (save_bitmap(outfile, bm, NULL)) {
+            // the palette is only valid for 8bpp images, encoders use the current palette otherwise
+            st_push(ST_ENCODE);
+            int err = save_bitmap(outfile, bm, (bitmap_color_depth(bm) == 8) ? pal : NULL);
+            st_pop();
+            if (err) {
                 destroy_bitmap(bm);
                 set_last_error("Can't save image %s", outfile);
                 clean_exit(EXIT_SUCCESS);
             }
             destroy_bitmap(bm);
         } else {
-            scaled_width = screen_width * scale;
-            scaled_height = screen_height * scale;
+            scaled_width = bm->w * scale;
+            scaled_height = bm->h * scale;
 
             if (!scaled_height || !scaled_width) {
                 fprintf(stdout, "Refusing to scale down to 0 pixel.");
                 clean_exit(EXIT_FAILURE);
             }
 
-            fprintf(stdout, "Scaling to %4dx%4d\n", scaled_width, scaled_height);
-            BITMAP *scaled = create_bitmap_ex(32, scaled_width, scaled_height);
+            fprintf(stdout, "Scaling to %4dx%4d (%s)\n", scaled_width, scaled_height, rs_filter_name(filter));
+            // gray images stay gray, everything else is scaled to 32bpp
+            bool gray = (bitmap_color_depth(bm) == 8) && sk_is_gray(pal);
+            BITMAP *scaled = create_bitmap_ex(gray ? 8 : 32, scaled_width, scaled_height);
             if (!scaled) {
                 fprintf(stdout, "Out of memory, image to large.");
                 clean_exit(EXIT_FAILURE);
             }
-            stretch_blit(bm, scaled, 0, 0, bm->w, bm->h, 0, 0, scaled_width, scaled_height);
+            st_push(ST_SCALE);
+            bool ok = rs_stretch(bm, scaled, 0, 0, bm->w, bm->h, 0, 0, scaled_width, scaled_height, filter, linear);
+            st_pop();
+            if (!ok) {
+                fprintf(stdout, "Out of memory, image to large.");
+                clean_exit(EXIT_FAILURE);
+            }
             destroy_bitmap(bm);
-            if (save_bitmap(outfile, scaled, NULL)) {
+            st_push(ST_ENCODE);
+            int err = save_bitmap(outfile, scaled, gray ? pal : NULL);
+            st_pop();
+            if (err) {
                 destroy_bitmap(scaled);
                 set_last_error("Can't save image %s", outfile);
                 clean_exit(EXIT_SUCCESS);
@@ -616,6 +1023,13 @@ int main(int argc, char *argv[]) {
             destroy_bitmap(scaled);
         }
         fprintf(stdout, "Wrote %s\n", outfile);
+
+        if (verbose) {
+            // the numbers were started by ld_load()
+            st_report_t report;
+            st_get(&report);
+            st_print(stdout, infile, &report, verbose == 'V');
+        }
     }
 
     clean_exit(EXIT_SUCCESS);
@@ -32,6 +32,10 @@ SOFTWARE.
 
 #define LOGSTREAM stdout  //!< output stream for logging on DOS
 
+#define LOAD_FAST 0    //!< load_quality: fastest decoding, e.g. the inexact IDCT and no chroma smoothing
+#define LOAD_NORMAL 1  //!< load_quality: the codec defaults
+#define LOAD_BEST 2    //!< load_quality: best quality the codec has, e.g. float IDCT and an optimized palette for 8bpp
+
 #ifdef DEBUG_ENABLED
 //! printf-style debug message to logfile/console
 #define DEBUGF(str, ...)                               \
@@ -53,5 +57,12 @@ SOFTWARE.
     fflush(stdout);
 
 extern int output_quality;
+extern int load_depth;
+extern int load_shrink;
+extern bool load_preview;
+extern int load_quality;
+extern struct __tile_store *load_tiles;
+extern bool (*load_scan)(BITMAP *bm, RGB *pal, bool temporary);
+extern bool (*load_progress)(uint32_t done, uint32_t total);
 
 #endif  // __MAIN_H__
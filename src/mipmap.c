@@ -0,0 +1,237 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "mipmap.h"
+#include "sink.h"
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief average four 8bpp palette pixels using the current palette.
+ */
+static inline int mm_avg8(int a, int b, int c, int d) {
+    int r = (getr8(a) + getr8(b) + getr8(c) + getr8(d) + 2) >> 2;
+    int g = (getg8(a) + getg8(b) + getg8(c) + getg8(d) + 2) >> 2;
+    int bl = (getb8(a) + getb8(b) + getb8(c) + getb8(d) + 2) >> 2;
+    return makecol8(r, g, bl);
+}
+
+/**
+ * @brief average four 15/16bpp pixels.
+ * The pixels are spread out to 32bit so that the three fields have room for the carry, this works for any 5-5-5 or 5-6-5 layout.
+ *
+ * @param mask bits of the fields in the spread out pixel.
+ */
+static inline uint16_t mm_avg16(uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t mask) {
+    uint32_t sum = ((a | (a << 16)) & mask) + ((b | (b << 16)) & mask) + ((c | (c << 16)) & mask) + ((d | (d << 16)) & mask);
+    sum = (sum >> 2) & mask;
+    return (uint16_t)(sum | (sum >> 16));
+}
+
+/**
+ * @brief average four 32bpp pixels, all four bytes are averaged separately.
+ */
+static inline uint32_t mm_avg32(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    uint32_t rb = (a & 0x00FF00FF) + (b & 0x00FF00FF) + (c & 0x00FF00FF) + (d & 0x00FF00FF) + 0x00020002;
+    uint32_t ag = ((a >> 8) & 0x00FF00FF) + ((b >> 8) & 0x00FF00FF) + ((c >> 8) & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF) + 0x00020002;
+    return ((rb >> 2) & 0x00FF00FF) | (((ag >> 2) & 0x00FF00FF) << 8);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief create a half size copy of a bitmap using a 2x2 box filter.
+ * If the width/height is odd the last column/row is used twice.
+ *
+ * @param src the bitmap to reduce (memory bitmap, 8, 15, 16, 24 or 32bpp). 8bpp bitmaps are averaged using the current palette.
+ * @param gray the 8bpp pixels are gray values (see sk_gray_palette()) and can be averaged directly.
+ *
+ * @return the new bitmap or NULL if out of memory.
+ */
+BITMAP *mm_reduce(BITMAP *src, bool gray) {
+    int depth = bitmap_color_depth(src);
+    int w = (src->w + 1) / 2;
+    int h = (src->h + 1) / 2;
+
+    BITMAP *dst = create_bitmap_ex(depth, w, h);
+    if (!dst) {
+        DEBUGF("Can't create %dx%d level: %s\n", w, h, allegro_error);
+        return NULL;
+    }
+
+    for (int y = 0; y < h; y++) {
+        int y0 = y * 2;
+        int y1 = MIN(y0 + 1, src->h - 1);
+
+        switch (depth) {
+            case 8: {
+                uint8_t *s0 = src->line[y0];
+                uint8_t *s1 = src->line[y1];
+                uint8_t *d = dst->line[y];
+                for (int x = 0; x < w; x++) {
+                    int x0 = x * 2;
+                    int x1 = MIN(x0 + 1, src->w - 1);
+                    if (gray) {
+                        d[x] = (s0[x0] + s0[x1] + s1[x0] + s1[x1] + 2) >> 2;
+                    } else {
+                        d[x] = mm_avg8(s0[x0], s0[x1], s1[x0], s1[x1]);
+                    }
+                }
+            } break;
+            case 15:
+            case 16: {
+                uint32_t mask = (depth == 15) ? 0x03E07C1F : 0x07E0F81F;
+                uint16_t *s0 = (uint16_t *)src->line[y0];
+                uint16_t *s1 = (uint16_t *)src->line[y1];
+                uint16_t *d = (uint16_t *)dst->line[y];
+                for (int x = 0; x < w; x++) {
+                    int x0 = x * 2;
+                    int x1 = MIN(x0 + 1, src->w - 1);
+                    d[x] = mm_avg16(s0[x0], s0[x1], s1[x0], s1[x1], mask);
+                }
+            } break;
+            case 24: {
+                uint8_t *s0 = src->line[y0];
+                uint8_t *s1 = src->line[y1];
+                uint8_t *d = dst->line[y];
+                for (int x = 0; x < w; x++) {
+                    int x0 = x * 2 * 3;
+                    int x1 = MIN(x * 2 + 1, src->w - 1) * 3;
+                    for (int c = 0; c < 3; c++) {
+                        *d++ = (s0[x0 + c] + s0[x1 + c] + s1[x0 + c] + s1[x1 + c] + 2) >> 2;
+                    }
+                }
+            } break;
+            case 32: {
+                uint32_t *s0 = (uint32_t *)src->line[y0];
+                uint32_t *s1 = (uint32_t *)src->line[y1];
+                uint32_t *d = (uint32_t *)dst->line[y];
+                for (int x = 0; x < w; x++) {
+                    int x0 = x * 2;
+                    int x1 = MIN(x0 + 1, src->w - 1);
+                    d[x] = mm_avg32(s0[x0], s0[x1], s1[x0], s1[x1]);
+                }
+            } break;
+            default:
+                destroy_bitmap(dst);
+                return NULL;
+        }
+    }
+
+    return dst;
+}
+
+/**
+ * @brief initialize an image pyramid. No memory is allocated until a level is needed.
+ *
+ * @param mm the pyramid.
+ * @param img the full size image (level 0), it is not copied and not freed by mm_exit().
+ *            For 8bpp images the current palette is used to average pixels.
+ */
+void mm_init(mipmap_t *mm, BITMAP *img) {
+    static RGB_MAP rgb_table;
+    static PALETTE rgb_pal;
+
+    memset(mm, 0, sizeof(mipmap_t));
+    mm->level[0] = img;
+
+    // averaging 8bpp pixels needs makecol8(), which is unusably slow without a RGB map. Gray pixels are averaged directly.
+    if (bitmap_color_depth(img) == 8) {
+        PALETTE pal;
+        get_palette(pal);
+        mm->gray = sk_is_gray(pal);
+        if (!mm->gray && ((rgb_map != &rgb_table) || memcmp(pal, rgb_pal, sizeof(PALETTE)))) {
+            create_rgb_table(&rgb_table, pal, NULL);
+            memcpy(rgb_pal, pal, sizeof(PALETTE));
+            rgb_map = &rgb_table;
+        }
+    }
+
+    // stop when the level would be smaller than one pixel
+    int w = img->w;
+    int h = img->h;
+    mm->num_levels = 1;
+    while ((mm->num_levels < MM_MAX_LEVELS) && (w > 1 || h > 1)) {
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+        mm->num_levels++;
+    }
+}
+
+/**
+ * @brief find the smallest level that still has at least the resolution needed for a zoom factor.
+ *
+ * @param mm the pyramid.
+ * @param factor the zoom factor relative to the full size image.
+ *
+ * @return the level index.
+ */
+int mm_select_level(mipmap_t *mm, float factor) {
+    int level = 0;
+    while ((level + 1 < mm->num_levels) && (factor * (1 << (level + 1)) <= 1.0f)) {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief get a level of the pyramid, it is created (with all missing levels before it) on first use.
+ *
+ * @param mm the pyramid.
+ * @param level the requested level index. If there is not enough memory for it the closest existing level with more resolution is used and its index returned here.
+ *
+ * @return the bitmap of the level.
+ */
+BITMAP *mm_get_level(mipmap_t *mm, int *level) {
+    if (*level >= mm->num_levels) {
+        *level = mm->num_levels - 1;
+    }
+
+    for (int l = 1; l <= *level; l++) {
+        if (!mm->level[l]) {
+            mm->level[l] = mm_reduce(mm->level[l - 1], mm->gray);
+            if (!mm->level[l]) {
+                *level = l - 1;
+                break;
+            }
+            DEBUGF("created mipmap level %d with %dx%d\n", l, mm->level[l]->w, mm->level[l]->h);
+        }
+    }
+
+    return mm->level[*level];
+}
+
+/**
+ * @brief free all levels created by the pyramid.
+ *
+ * @param mm the pyramid.
+ */
+void mm_exit(mipmap_t *mm) {
+    for (int l = 1; l < MM_MAX_LEVELS; l++) {
+        if (mm->level[l]) {
+            destroy_bitmap(mm->level[l]);
+            mm->level[l] = NULL;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __MIPMAP_H__
+#define __MIPMAP_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#define MM_MAX_LEVELS 16  //!< max number of levels in the pyramid
+
+/************
+** structs **
+************/
+//! image pyramid, every level is half the size of the previous one
+typedef struct __mipmap {
+    BITMAP *level[MM_MAX_LEVELS];  //!< level 0 is the image itself, the others are created on first use
+    int num_levels;                //!< number of possible levels
+    bool gray;                     //!< 8bpp pixels are gray values, not palette indices
+} mipmap_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void mm_init(mipmap_t *mm, BITMAP *img);
+extern int mm_select_level(mipmap_t *mm, float factor);
+extern BITMAP *mm_get_level(mipmap_t *mm, int *level);
+extern BITMAP *mm_reduce(BITMAP *src, bool gray);
+extern void mm_exit(mipmap_t *mm);
+
+#endif  // __MIPMAP_H__
@@ -0,0 +1,301 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "prefetch.h"
+
+/************
+** globals **
+************/
+static bool pf_interrupted = false;  //!< a key was pressed while an image was prefetched
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief find the slot holding an image.
+ *
+ * @param pf the prefetcher.
+ * @param index index of the image.
+ *
+ * @return the slot or NULL.
+ */
+static pf_slot_t *pf_find(prefetch_t *pf, int index) {
+    for (int i = 0; i < PF_SLOTS; i++) {
+        if (pf->slot[i].index == index) {
+            return &pf->slot[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief find a free slot.
+ *
+ * @param pf the prefetcher.
+ *
+ * @return the slot or NULL.
+ */
+static pf_slot_t *pf_free_slot(prefetch_t *pf) { return pf_find(pf, -1); }
+
+/**
+ * @brief load the image of a slot.
+ *
+ * @param pf the prefetcher.
+ * @param s the slot.
+ */
+static void pf_load(prefetch_t *pf, pf_slot_t *s) {
+    DEBUGF("loading #%d %s\n", s->index, pf->files[s->index]);
+    s->ok = ld_load(pf->opt, pf->files[s->index], &s->img);
+    s->done = true;
+}
+
+/**
+ * @brief free the image of a slot.
+ *
+ * @param s the slot.
+ */
+static void pf_release(pf_slot_t *s) {
+    if (s->index >= 0) {
+        ld_free(&s->img);
+        s->index = -1;
+        s->done = false;
+        s->ok = false;
+    }
+}
+
+/**
+ * @brief get the index of a neighbour of the current image.
+ *
+ * @param pf the prefetcher.
+ * @param step +1 for the next, -1 for the previous image.
+ *
+ * @return the index, the list wraps around.
+ */
+static int pf_neighbour(prefetch_t *pf, int step) { return (pf->current + step + pf->num_files) % pf->num_files; }
+
+/**
+ * @brief check if an image can be loaded at full size and color depth.
+ *
+ * @param pf the prefetcher.
+ * @param index index of the image.
+ * @param budget memory that may be used.
+ * @param plan returns the plan for the image.
+ *
+ * @return true if the image fits into the budget without being reduced.
+ */
+static bool pf_fits(prefetch_t *pf, int index, uint64_t budget, gv_plan_t *plan) {
+    probe_t probe;
+
+    return ld_plan(pf->opt, pf->files[index], budget, &probe, plan) && !plan->tiled && (plan->shrink == 1) && (plan->depth == pf->opt->depth);
+}
+
+/**
+ * @brief reserve a slot for the next neighbour that is not loaded yet, if it fits into memory without being reduced.
+ * Images that have to be reduced or tiled are loaded when they are shown, when all other images are freed.
+ *
+ * @param pf the prefetcher.
+ * @param budget memory that may still be used, decreased by the estimate of the reserved image.
+ *
+ * @return the slot or NULL if there is nothing (more) to prefetch.
+ */
+static pf_slot_t *pf_reserve(prefetch_t *pf, uint64_t *budget) {
+    static const int steps[] = {1, -1};
+
+    for (int i = 0; i < 2; i++) {
+        int index = pf_neighbour(pf, steps[i]);
+        if ((index == pf->current) || pf_find(pf, index)) {
+            continue;
+        }
+
+        pf_slot_t *s = pf_free_slot(pf);
+        if (!s) {
+            return NULL;
+        }
+
+        gv_plan_t plan;
+        if (!pf_fits(pf, index, *budget, &plan)) {
+            DEBUGF("not prefetching #%d, it does not fit\n", index);
+            continue;
+        }
+        *budget = (*budget > plan.need) ? *budget - plan.need : 0;
+
+        s->index = index;
+        s->done = false;
+        s->ok = false;
+        return s;
+    }
+    return NULL;
+}
+
+/**
+ * @brief load_progress() hook for prefetched images: the user comes first, a key press aborts loading.
+ * The key is left in the buffer for the viewer.
+ *
+ * @param done work done.
+ * @param total total work.
+ *
+ * @return false if a key was pressed.
+ */
+static bool pf_progress(uint32_t done, uint32_t total) {
+    if (keyboard_needs_poll()) {
+        poll_keyboard();
+    }
+    if (keypressed()) {
+        pf_interrupted = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief get the memory that may be used for prefetching.
+ *
+ * @param pf the prefetcher.
+ *
+ * @return bytes.
+ */
+static uint64_t pf_budget(prefetch_t *pf) {
+    uint64_t budget = ld_budget(pf->opt);
+
+    // the available memory already excludes the loaded images, a fixed budget does not
+    if (pf->opt->mem_limit) {
+        for (int i = 0; i < PF_SLOTS; i++) {
+            if (pf->slot[i].index >= 0) {
+                budget = (budget > pf->slot[i].img.plan.need) ? budget - pf->slot[i].img.plan.need : 0;
+            }
+        }
+    }
+    return budget;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize the prefetcher for a list of images.
+ *
+ * @param pf the prefetcher.
+ * @param opt load options, must stay valid until pf_exit().
+ * @param files the image files, must stay valid until pf_exit().
+ * @param num_files number of files.
+ */
+void pf_init(prefetch_t *pf, const ld_options_t *opt, char **files, int num_files) {
+    memset(pf, 0, sizeof(prefetch_t));
+    pf->opt = opt;
+    pf->files = files;
+    pf->num_files = num_files;
+    for (int i = 0; i < PF_SLOTS; i++) {
+        pf->slot[i].index = -1;
+    }
+}
+
+/**
+ * @brief make an image the current one and get it, it is loaded now if it was not prefetched.
+ * Images that are no neighbours of the new current image are freed first.
+ *
+ * @param pf the prefetcher.
+ * @param index index of the image.
+ *
+ * @return the slot with the image, check 'ok' for errors.
+ */
+pf_slot_t *pf_get(prefetch_t *pf, int index) {
+    pf->current = index;
+    for (int i = 0; i < PF_SLOTS; i++) {
+        int idx = pf->slot[i].index;
+        if ((idx != index) && (idx != pf_neighbour(pf, 1)) && (idx != pf_neighbour(pf, -1))) {
+            pf_release(&pf->slot[i]);
+        }
+    }
+
+    pf_slot_t *s = pf_find(pf, index);
+    if (!s) {
+        // a large image gets all the memory, the neighbours are prefetched again later
+        gv_plan_t plan;
+        s = pf_free_slot(pf);
+        if (!s || !pf_fits(pf, index, pf_budget(pf), &plan)) {
+            for (int i = 0; i < PF_SLOTS; i++) {
+                pf_release(&pf->slot[i]);
+            }
+            s = &pf->slot[0];
+        }
+        s->index = index;
+    }
+    if (!s->done) {
+        // only the image shown sees the hooks
+        load_scan = pf->scan;
+        load_progress = pf->progress;
+        pf_load(pf, s);
+        load_scan = NULL;
+        load_progress = NULL;
+    }
+    return s;
+}
+
+/**
+ * @brief forget an image, e.g. because the user aborted loading it. It is loaded again when it is needed.
+ *
+ * @param pf the prefetcher.
+ * @param index index of the image.
+ */
+void pf_drop(prefetch_t *pf, int index) {
+    pf_slot_t *s = pf_find(pf, index);
+    if (s) {
+        pf_release(s);
+    }
+}
+
+/**
+ * @brief prefetch the neighbours of the current image, to be called while the user is idle. One image is loaded per call.
+ * A key press aborts it, the image is loaded again at the next idle call (or when it is shown).
+ *
+ * @param ctx the prefetcher.
+ *
+ * @return true if there is more to do.
+ */
+bool pf_idle(void *ctx) {
+    prefetch_t *pf = ctx;
+    uint64_t budget = pf_budget(pf);
+    pf_slot_t *s = pf_reserve(pf, &budget);
+    if (!s) {
+        return false;
+    }
+    pf_interrupted = false;
+    load_progress = pf_progress;
+    pf_load(pf, s);
+    load_progress = NULL;
+    if (pf_interrupted) {
+        DEBUGF("prefetching #%d interrupted\n", s->index);
+        pf_drop(pf, s->index);
+    }
+    return true;
+}
+
+/**
+ * @brief free all images.
+ *
+ * @param pf the prefetcher.
+ */
+void pf_exit(prefetch_t *pf) {
+    for (int i = 0; i < PF_SLOTS; i++) {
+        pf_release(&pf->slot[i]);
+    }
+}
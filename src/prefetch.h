@@ -0,0 +1,65 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PREFETCH_H__
+#define __PREFETCH_H__
+
+#include "main.h"
+#include "loader.h"
+
+/************
+** defines **
+************/
+#define PF_SLOTS 3  //!< the image shown and its two neighbours
+
+/************
+** structs **
+************/
+//! an image of the list that is loaded or being loaded
+typedef struct __pf_slot {
+    int index;       //!< index of the file in the list, -1 if the slot is free
+    bool done;       //!< loading has finished (successful or not)
+    bool ok;         //!< the image was loaded successfully
+    ld_image_t img;  //!< the image
+} pf_slot_t;
+
+//! a list of images where the neighbours of the current one are loaded ahead of time
+typedef struct __prefetch {
+    const ld_options_t *opt;               //!< load options
+    char **files;                          //!< the image files
+    int num_files;                         //!< number of files
+    int current;                           //!< index of the image shown
+    pf_slot_t slot[PF_SLOTS];              //!< loaded images
+    bool (*scan)(BITMAP *, RGB *, bool);   //!< load_scan hook for the image loaded by pf_get(), prefetched images don't use it (or NULL)
+    bool (*progress)(uint32_t, uint32_t);  //!< load_progress hook for the image loaded by pf_get(), prefetched images don't use it (or NULL)
+} prefetch_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void pf_init(prefetch_t *pf, const ld_options_t *opt, char **files, int num_files);
+extern pf_slot_t *pf_get(prefetch_t *pf, int index);
+extern void pf_drop(prefetch_t *pf, int index);
+extern bool pf_idle(void *ctx);
+extern void pf_exit(prefetch_t *pf);
+
+#endif  // __PREFETCH_H__
@@ -0,0 +1,431 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <ctype.h>
+
+#include "probe.h"
+#include "sniff.h"
+#include "format-jpeg.h"
+#include "format-webp.h"
+#include "format-tiff.h"
+#include "format-stb.h"
+#include "format-jasper.h"
+
+/*********************
+** static functions **
+*********************/
+static inline uint32_t pr_be16(const uint8_t *b) { return (b[0] << 8) | b[1]; }
+static inline uint32_t pr_le16(const uint8_t *b) { return b[0] | (b[1] << 8); }
+static inline uint32_t pr_be32(const uint8_t *b) { return ((uint32_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3]; }
+static inline uint32_t pr_le32(const uint8_t *b) { return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24); }
+
+/**
+ * @brief read an ASCII number from a netpbm header, skipping whitespace and comments.
+ *
+ * @param pos current position in the header, updated.
+ * @param end end of the header.
+ *
+ * @return the number or -1 if there was none.
+ */
+static int pr_pnm_number(const uint8_t **pos, const uint8_t *end) {
+    const uint8_t *p = *pos;
+
+    while (p < end) {
+        if (*p == '#') {
+            while (p < end && *p != '\n') {
+                p++;
+            }
+        } else if (isspace(*p)) {
+            p++;
+        } else {
+            break;
+        }
+    }
+    if (p >= end || !isdigit(*p)) {
+        return -1;
+    }
+
+    int n = 0;
+    while (p < end && isdigit(*p)) {
+        n = n * 10 + (*p - '0');
+        p++;
+    }
+    *pos = p;
+    return n;
+}
+
+/**
+ * @brief decode the header of the formats that have their size at a fixed position.
+ *
+ * @param p the probe, 'format' must be set.
+ * @param b the first bytes of the file.
+ * @param n number of bytes in b.
+ *
+ * @return true if the header was valid.
+ */
+static bool pr_simple(probe_t *p, const uint8_t *b, size_t n) {
+    if (!strcmp(p->format, "PNG")) {
+        if (n < 26 || memcmp(b, "\x89PNG", 4)) {
+            return false;
+        }
+        p->width = pr_be32(&b[16]);
+        p->height = pr_be32(&b[20]);
+        p->bits = b[24];
+        strcpy(p->compression, "deflate");
+        switch (b[25]) {
+            case 0:
+                p->components = 1;
+                break;
+            case 3:
+                p->components = 1;
+                p->indexed = true;
+                break;
+            case 2:
+                p->components = 3;
+                break;
+            default:
+                p->components = 4;
+                break;
+        }
+    } else if (!strcmp(p->format, "GIF")) {
+        if (n < 10 || memcmp(b, "GIF8", 4)) {
+            return false;
+        }
+        p->width = pr_le16(&b[6]);
+        p->height = pr_le16(&b[8]);
+        p->components = 1;
+        p->indexed = true;
+        p->bits = (b[10] & 0x80) ? (b[10] & 0x07) + 1 : ((b[10] >> 4) & 0x07) + 1;  // global color table or color resolution
+        strcpy(p->compression, "lzw");
+    } else if (!strcmp(p->format, "BMP")) {
+        static const char *methods[] = {"none", "rle8", "rle4", "bitfields"};
+        if (n < 34 || memcmp(b, "BM", 2)) {
+            return false;
+        }
+        int bpp = pr_le16(&b[28]);
+        uint32_t method = pr_le32(&b[30]);
+        p->width = pr_le32(&b[18]);
+        p->height = abs((int32_t)pr_le32(&b[22]));
+        p->indexed = bpp <= 8;
+        p->components = p->indexed ? 1 : ((bpp == 32) ? 4 : 3);
+        p->bits = p->indexed ? bpp : ((bpp == 16) ? 5 : 8);
+        if (method < sizeof(methods) / sizeof(methods[0])) {
+            strcpy(p->compression, methods[method]);
+        }
+    } else if (!strcmp(p->format, "QOI")) {
+        if (n < 14 || memcmp(b, "qoif", 4)) {
+            return false;
+        }
+        p->width = pr_be32(&b[4]);
+        p->height = pr_be32(&b[8]);
+        p->components = b[12];
+        p->bits = 8;
+        strcpy(p->compression, "qoi");
+    } else if (!strcmp(p->format, "PCX")) {
+        if (n < 66 || b[0] != 0x0A) {
+            return false;
+        }
+        p->width = pr_le16(&b[8]) - pr_le16(&b[4]) + 1;
+        p->height = pr_le16(&b[10]) - pr_le16(&b[6]) + 1;
+        p->indexed = b[65] == 1;
+        p->components = p->indexed ? 1 : 3;
+        p->bits = b[3] * (p->indexed ? b[65] : 1);
+        strcpy(p->compression, (b[2] == 1) ? "rle" : "none");
+    } else if (!strcmp(p->format, "TGA")) {
+        if (n < 18) {
+            return false;
+        }
+        p->width = pr_le16(&b[12]);
+        p->height = pr_le16(&b[14]);
+        p->indexed = (b[2] & 0x07) == 1;
+        p->components = ((b[2] & 0x07) == 2) ? ((b[16] == 32) ? 4 : 3) : 1;
+        p->bits = (p->components > 1) ? ((b[16] == 16) ? 5 : 8) : b[16];
+        strcpy(p->compression, (b[2] & 0x08) ? "rle" : "none");
+    } else if (!strcmp(p->format, "PNM") || !strcmp(p->format, "PBM") || !strcmp(p->format, "PGM") || !strcmp(p->format, "PPM")) {
+        if (n < 3 || b[0] != 'P' || b[1] < '1' || b[1] > '6') {
+            return false;
+        }
+        const uint8_t *pos = &b[2];
+        p->width = pr_pnm_number(&pos, b + n);
+        p->height = pr_pnm_number(&pos, b + n);
+        p->components = (b[1] == '3' || b[1] == '6') ? 3 : 1;
+        p->bits = 1;
+        if (b[1] != '1' && b[1] != '4') {
+            int maxval = pr_pnm_number(&pos, b + n);
+            for (p->bits = 1; (1 << p->bits) <= maxval; p->bits++) {
+            }
+        }
+        strcpy(p->compression, (b[1] <= '3') ? "ascii" : "none");
+    } else if (!strcmp(p->format, "RAS")) {
+        if (n < 32 || pr_be32(b) != 0x59A66A95) {
+            return false;
+        }
+        p->width = pr_be32(&b[4]);
+        p->height = pr_be32(&b[8]);
+        int depth = pr_be32(&b[12]);
+        p->indexed = (depth <= 8) && pr_be32(&b[24]);
+        p->components = (depth <= 8) ? 1 : 3;
+        p->bits = (depth <= 8) ? depth : 8;
+        strcpy(p->compression, (pr_be32(&b[20]) == 2) ? "rle" : "none");
+    } else {
+        // no cheap way to get the size, the image is loaded without planning (if it is an image at all)
+        return sn_loader(p->format) != NULL;
+    }
+
+    return (p->width > 0) && (p->height > 0);
+}
+
+/**
+ * @brief count the frames of an animated PNG, the chunk headers before the image data are walked.
+ *
+ * @param in the file.
+ *
+ * @return number of frames.
+ */
+static int pr_png_frames(input_t *in) {
+    uint8_t chunk[12];
+
+    uint64_t pos = 8;
+    while (in_seek(in, pos) && (in_read(in, chunk, sizeof(chunk)) == sizeof(chunk))) {
+        if (!memcmp(&chunk[4], "acTL", 4)) {
+            return pr_be32(&chunk[8]);
+        } else if (!memcmp(&chunk[4], "IDAT", 4)) {
+            break;
+        }
+        pos += 12 + pr_be32(chunk);
+    }
+    return 1;
+}
+
+/**
+ * @brief count the images of a GIF, the data sub-blocks are skipped without decoding them.
+ *
+ * @param in the file.
+ * @param b the first bytes of the file.
+ *
+ * @return number of frames.
+ */
+static int pr_gif_frames(input_t *in, const uint8_t *b) {
+    int frames = 0;
+
+    uint64_t pos = 13 + ((b[10] & 0x80) ? 3 << ((b[10] & 0x07) + 1) : 0);
+    if (!in_seek(in, pos)) {
+        return 0;
+    }
+    while (true) {
+        int c = in_getc(in);
+        if (c == 0x2C) {
+            // image descriptor, local color table and LZW code size
+            uint8_t desc[9];
+            if (in_read(in, desc, sizeof(desc)) != sizeof(desc)) {
+                break;
+            }
+            int skip = ((desc[8] & 0x80) ? 3 << ((desc[8] & 0x07) + 1) : 0) + 1;
+            if (!in_skip(in, skip)) {
+                break;
+            }
+            frames++;
+        } else if (c == 0x21) {
+            // extension label
+            if (in_getc(in) == EOF) {
+                break;
+            }
+        } else {
+            break;  // trailer or garbage
+        }
+
+        // data sub-blocks
+        int len;
+        while ((len = in_getc(in)) > 0) {
+            if (!in_skip(in, len)) {
+                return frames;
+            }
+        }
+        if (len == EOF) {
+            break;
+        }
+    }
+    return frames;
+}
+
+/**
+ * @brief write a named number, unknown values (0) are null in JSON and empty in CSV.
+ *
+ * @param out the stream.
+ * @param name name of the JSON member.
+ * @param value the number.
+ * @param csv true for CSV, else JSON.
+ */
+static void pr_print_number(FILE *out, const char *name, uint64_t value, bool csv) {
+    if (csv) {
+        fputc(',', out);
+        if (value) {
+            fprintf(out, "%llu", (unsigned long long)value);
+        }
+    } else if (value) {
+        fprintf(out, ",\"%s\":%llu", name, (unsigned long long)value);
+    } else {
+        fprintf(out, ",\"%s\":null", name);
+    }
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief read the image size and layout from the header of an open file without decoding the image.
+ * The format is detected from the signature at the start of the file (see sn_sniff_in()), only formats without a
+ * signature are taken from the file extension.
+ *
+ * @param in the image file, the decoder can read it again afterwards.
+ * @param p the result. For formats where the header can't be read cheaply width/height are 0.
+ *
+ * @return true if the file could be read and the header looked valid.
+ */
+bool pr_probe_in(input_t *in, probe_t *p) {
+    sniff_t s;
+
+    memset(p, 0, sizeof(probe_t));
+    if (!sn_sniff_in(in, &s)) {
+        return false;
+    }
+    strcpy(p->format, s.format);
+    p->file_size = s.file_size;
+
+    bool ret;
+    if (!strcmp(p->format, "JPG")) {
+        ret = probe_jpeg(in, p);
+    } else if (!strcmp(p->format, "WEB")) {
+        ret = probe_webp(in, p);
+    } else if (!strcmp(p->format, "TIF")) {
+        ret = probe_tiff(in, p);
+    } else if (!strcmp(p->format, "PSD") || !strcmp(p->format, "HDR") || !strcmp(p->format, "PIC")) {
+        ret = probe_stb(in, p);
+    } else if (!strcmp(p->format, "JP2")) {
+        ret = probe_jasper(in, p);
+    } else {
+        // the header was already read by sn_sniff_in(), only the frame count needs more of the file
+        ret = pr_simple(p, s.header, s.size);
+        if (ret && (!strcmp(p->format, "PNG") || !strcmp(p->format, "GIF"))) {
+            p->frames = !strcmp(p->format, "PNG") ? pr_png_frames(in) : pr_gif_frames(in, s.header);
+        } else if (ret && p->width) {
+            p->frames = 1;
+        }
+    }
+
+    DEBUGF("probe %s: %s %dx%dx%d%s%s, %lu bytes\n", in->filename, p->format, p->width, p->height, p->components, p->indexed ? " indexed" : "",
+           p->progressive ? " progressive" : "", (unsigned long)p->file_size);
+    return ret;
+}
+
+/**
+ * @brief read the image size and layout from the file header without decoding the image (see pr_probe_in()).
+ *
+ * @param filename the image file.
+ * @param p the result. For formats where the header can't be read cheaply width/height are 0.
+ *
+ * @return true if the file could be read and the header looked valid.
+ */
+bool pr_probe(const char *filename, probe_t *p) {
+    input_t in;
+
+    if (!in_open(&in, filename)) {
+        memset(p, 0, sizeof(probe_t));
+        return false;
+    }
+    bool ret = pr_probe_in(&in, p);
+    in_close(&in);
+    return ret;
+}
+
+/**
+ * @brief write a string as JSON or CSV value.
+ *
+ * @param out the stream.
+ * @param str the string.
+ * @param csv true for CSV quoting, else JSON.
+ */
+void pr_print_string(FILE *out, const char *str, bool csv) {
+    fputc('"', out);
+    for (const char *s = str; *s; s++) {
+        if (*s == '"') {
+            fputs(csv ? "\"\"" : "\\\"", out);
+        } else if (!csv && (*s == '\\')) {
+            fputs("\\\\", out);
+        } else if (!csv && ((unsigned char)*s < 0x20)) {
+            fprintf(out, "\\u%04x", *s);
+        } else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/**
+ * @brief write the CSV column names, JSON-lines output has no header.
+ *
+ * @param out the stream.
+ * @param csv true for CSV.
+ */
+void pr_print_header(FILE *out, bool csv) {
+    if (csv) {
+        fputs("file,format,width,height,bits,channels,indexed,compression,frames,size,ok\n", out);
+    }
+}
+
+/**
+ * @brief write the result of pr_probe() as a JSON object on one line or as CSV row.
+ *
+ * @param out the stream.
+ * @param filename the image file.
+ * @param p the probe.
+ * @param ok the return value of pr_probe().
+ * @param csv true for CSV, else JSON.
+ */
+void pr_print(FILE *out, const char *filename, const probe_t *p, bool ok, bool csv) {
+    if (!csv) {
+        fputs("{\"file\":", out);
+    }
+    pr_print_string(out, filename, csv);
+    fputs(csv ? "," : ",\"format\":", out);
+    pr_print_string(out, p->format, csv);
+    pr_print_number(out, "width", p->width, csv);
+    pr_print_number(out, "height", p->height, csv);
+    pr_print_number(out, "bits", p->bits, csv);
+    pr_print_number(out, "channels", p->components, csv);
+    if (csv) {
+        fprintf(out, ",%d,", p->indexed);
+    } else {
+        fprintf(out, ",\"indexed\":%s,\"compression\":", p->indexed ? "true" : "false");
+    }
+    if (p->compression[0] || !csv) {
+        pr_print_string(out, p->compression, csv);
+    }
+    pr_print_number(out, "frames", p->frames, csv);
+    pr_print_number(out, "size", p->file_size, csv);
+    if (csv) {
+        fprintf(out, ",%d", ok);
+    } else {
+        fprintf(out, ",\"ok\":%s}", ok ? "true" : "false");
+    }
+    fputc('\n', out);
+}
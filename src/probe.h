@@ -0,0 +1,56 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+#include "main.h"
+#include "input.h"
+
+/************
+** structs **
+************/
+//! image information read from the file header, without decoding the image
+typedef struct __probe {
+    char format[8];      //!< file format (upper case extension, e.g. "JPG")
+    int width;           //!< width in pixels, 0 if unknown
+    int height;          //!< height in pixels, 0 if unknown
+    int components;      //!< 1 (gray or indexed), 3 (RGB) or 4 (RGBA), 0 if unknown
+    bool indexed;        //!< pixels are palette indices
+    bool progressive;    //!< the decoder has to keep the whole image in an intermediate form (progressive JPEG)
+    int bits;            //!< bits per sample (per pixel for indexed images), 0 if unknown
+    int frames;          //!< number of frames or pages, 0 if unknown
+    char compression[16];  //!< compression method (e.g. "baseline", "lzw"), empty if unknown
+    uint64_t file_size;  //!< size of the file in bytes
+    bool turned;         //!< width and height are as shown, the image is stored with them swapped (EXIF orientation)
+} probe_t;
+
+/***********************
+** exported functions **
+***********************/
+extern bool pr_probe(const char *filename, probe_t *p);
+extern bool pr_probe_in(input_t *in, probe_t *p);
+extern void pr_print_string(FILE *out, const char *str, bool csv);
+extern void pr_print_header(FILE *out, bool csv);
+extern void pr_print(FILE *out, const char *filename, const probe_t *p, bool ok, bool csv);
+
+#endif  // __PROBE_H__
@@ -0,0 +1,648 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+
+#include "resample.h"
+#include "sink.h"
+#include "util.h"
+
+/************
+** defines **
+************/
+#define RS_SHIFT 12               //!< fixed point precision of the filter weights
+#define RS_ONE (1 << RS_SHIFT)    //!< 1.0 in filter weight fixed point
+#define RS_MID_SHIFT 4            //!< extra fraction bits kept between the two passes
+#define RS_MAX_VALUE 4095         //!< channel values are processed with 12 bits
+#define RS_LUT_SIZE (RS_MAX_VALUE + 1)
+
+#define RS_BENCH_SIZE 512         //!< max size of the area used for the benchmark
+#define RS_BENCH_TIME 500000      //!< minimum time (in us) each benchmark is run
+
+/************
+** structs **
+************/
+//! source span for one destination column/row
+typedef struct __rs_contrib {
+    int start;   //!< first source pixel
+    int count;   //!< number of source pixels
+    int offset;  //!< index of the first weight in the weights array
+} rs_contrib_t;
+
+//! precomputed weights for one direction
+typedef struct __rs_table {
+    rs_contrib_t *contrib;  //!< one entry per destination pixel
+    int16_t *weights;       //!< weights in RS_SHIFT fixed point, they add up to RS_ONE for every destination pixel
+    int max_count;          //!< largest number of source pixels for a single destination pixel
+} rs_table_t;
+
+//! filter kernel function
+typedef double (*rs_kernel_t)(double x);
+
+//! filter definition
+typedef struct __rs_filter_def {
+    const char *name;    //!< name used on the command line
+    rs_kernel_t kernel;  //!< kernel function
+    double support;      //!< radius of the kernel at scale 1.0
+} rs_filter_def_t;
+
+/*********************
+** static functions **
+*********************/
+static double rs_box(double x) { return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0; }
+
+static double rs_triangle(double x) {
+    x = fabs(x);
+    return (x < 1.0) ? 1.0 - x : 0.0;
+}
+
+/**
+ * @brief Catmull-Rom cubic (a = -0.5).
+ */
+static double rs_cubic(double x) {
+    x = fabs(x);
+    if (x < 1.0) {
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    } else if (x < 2.0) {
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    } else {
+        return 0.0;
+    }
+}
+
+static double rs_sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double rs_lanczos3(double x) { return (fabs(x) < 3.0) ? rs_sinc(x) * rs_sinc(x / 3.0) : 0.0; }
+
+//! filter table, indexed by rs_filter_t
+static const rs_filter_def_t rs_filters[RS_NUM_FILTERS] = {
+    {"nearest", rs_box, 0.5},       //
+    {"box", rs_box, 0.5},           //
+    {"bilinear", rs_triangle, 1.0}, //
+    {"bicubic", rs_cubic, 2.0},     //
+    {"lanczos3", rs_lanczos3, 3.0}  //
+};
+
+static uint16_t rs_to_linear[256];              //!< sRGB -> 12bit linear light
+static uint8_t rs_from_linear[RS_LUT_SIZE];     //!< 12bit linear light -> sRGB
+static uint16_t rs_to_wide[256];                //!< 8bit -> 12bit without gamma
+static uint8_t rs_from_wide[RS_LUT_SIZE];       //!< 12bit -> 8bit without gamma
+static bool rs_lut_done = false;
+
+/**
+ * @brief fill the conversion tables on first use.
+ */
+static void rs_init_luts(void) {
+    if (rs_lut_done) {
+        return;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        double c = i / 255.0;
+        c = (c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+        rs_to_linear[i] = (uint16_t)(c * RS_MAX_VALUE + 0.5);
+        rs_to_wide[i] = (uint16_t)((i * RS_MAX_VALUE + 127) / 255);
+    }
+    for (int i = 0; i < RS_LUT_SIZE; i++) {
+        double c = (double)i / RS_MAX_VALUE;
+        c = (c <= 0.0031308) ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+        rs_from_linear[i] = (uint8_t)(c * 255.0 + 0.5);
+        rs_from_wide[i] = (uint8_t)((i * 255 + RS_MAX_VALUE / 2) / RS_MAX_VALUE);
+    }
+    rs_lut_done = true;
+}
+
+/**
+ * @brief free a weight table.
+ */
+static void rs_free_table(rs_table_t *t) {
+    free(t->contrib);
+    free(t->weights);
+    t->contrib = NULL;
+    t->weights = NULL;
+}
+
+/**
+ * @brief compute the weights for one direction.
+ * Destination pixel i has its center at src_pos + (i + 0.5) * src_len / dst_len in the source. When reducing the kernel is widened
+ * so that it covers all source pixels (area filter). Source pixels outside the bitmap are not used and the weights renormalized,
+ * pixels outside the source area but inside the bitmap are used so that separately scaled areas fit together without seams.
+ *
+ * @param t the table to fill.
+ * @param filter the filter to use.
+ * @param src_pos first pixel of the source area.
+ * @param src_len length of the source area.
+ * @param src_limit size of the source bitmap in that direction.
+ * @param dst_len length of the destination area.
+ *
+ * @return true for success, false if out of memory.
+ */
+static bool rs_make_table(rs_table_t *t, int filter, int src_pos, int src_len, int src_limit, int dst_len) {
+    const rs_filter_def_t *def = &rs_filters[filter];
+    double step = (double)src_len / dst_len;
+    double scale = (filter != RS_NEAREST && step > 1.0) ? step : 1.0;
+    double support = def->support * scale;
+    int max_taps = (int)ceil(support * 2) + 1;
+
+    t->max_count = 0;
+    t->contrib = malloc(sizeof(rs_contrib_t) * dst_len);
+    t->weights = malloc(sizeof(int16_t) * dst_len * max_taps);
+    double *w = malloc(sizeof(double) * max_taps);
+    if (!t->contrib || !t->weights || !w) {
+        free(w);
+        rs_free_table(t);
+        return false;
+    }
+
+    int offset = 0;
+    for (int i = 0; i < dst_len; i++) {
+        double center = src_pos + (i + 0.5) * step;
+        int left = (int)floor(center - support);
+        int right = (int)ceil(center + support);
+        left = MAX(left, 0);
+        right = MIN(right, src_limit - 1);
+        if (right - left + 1 > max_taps) {
+            right = left + max_taps - 1;
+        }
+
+        // evaluate kernel at the pixel centers
+        double sum = 0;
+        int count = 0;
+        for (int j = left; j <= right; j++) {
+            w[count] = def->kernel((j + 0.5 - center) / scale);
+            sum += w[count];
+            count++;
+        }
+        if (sum == 0.0) {
+            // can only happen at the edges: use the closest pixel
+            left = MIN(MAX((int)center, 0), src_limit - 1);
+            count = 1;
+            w[0] = sum = 1.0;
+        }
+
+        // strip zero weights at both ends
+        int first = 0;
+        while (first < count - 1 && w[first] == 0.0) {
+            first++;
+        }
+        while (count > first + 1 && w[count - 1] == 0.0) {
+            count--;
+        }
+
+        // convert to fixed point, the rounding error is put on the largest weight
+        int16_t *tw = &t->weights[offset];
+        int total = 0;
+        int largest = 0;
+        for (int j = first; j < count; j++) {
+            tw[j - first] = (int16_t)lround(w[j] / sum * RS_ONE);
+            total += tw[j - first];
+            if (abs(tw[j - first]) > abs(tw[largest])) {
+                largest = j - first;
+            }
+        }
+        tw[largest] += RS_ONE - total;
+
+        t->contrib[i].start = left + first;
+        t->contrib[i].count = count - first;
+        t->contrib[i].offset = offset;
+        t->max_count = MAX(t->max_count, count - first);
+        offset += count - first;
+    }
+    free(w);
+
+    return true;
+}
+
+/**
+ * @brief read a part of a source row as 12bit R, G, B triplets.
+ *
+ * @param src source bitmap.
+ * @param y the row.
+ * @param x0 first column.
+ * @param x1 last column + 1.
+ * @param lut 8bit -> 12bit table.
+ * @param gray 8bpp pixels are gray values instead of palette indices.
+ * @param out output buffer, 3 values per pixel.
+ */
+static void rs_read_row(BITMAP *src, int y, int x0, int x1, const uint16_t *lut, bool gray, uint16_t *out) {
+    int depth = bitmap_color_depth(src);
+
+    if (!is_memory_bitmap(src)) {
+        for (int x = x0; x < x1; x++) {
+            int c = getpixel(src, x, y);
+            *out++ = lut[getr_depth(depth, c)];
+            *out++ = lut[getg_depth(depth, c)];
+            *out++ = lut[getb_depth(depth, c)];
+        }
+        return;
+    }
+
+    switch (depth) {
+        case 8: {
+            uint8_t *s = src->line[y];
+            if (gray) {
+                for (int x = x0; x < x1; x++) {
+                    uint16_t v = lut[s[x]];
+                    *out++ = v;
+                    *out++ = v;
+                    *out++ = v;
+                }
+                break;
+            }
+            for (int x = x0; x < x1; x++) {
+                *out++ = lut[getr8(s[x])];
+                *out++ = lut[getg8(s[x])];
+                *out++ = lut[getb8(s[x])];
+            }
+        } break;
+        case 15: {
+            uint16_t *s = (uint16_t *)src->line[y];
+            for (int x = x0; x < x1; x++) {
+                *out++ = lut[getr15(s[x])];
+                *out++ = lut[getg15(s[x])];
+                *out++ = lut[getb15(s[x])];
+            }
+        } break;
+        case 16: {
+            uint16_t *s = (uint16_t *)src->line[y];
+            for (int x = x0; x < x1; x++) {
+                *out++ = lut[getr16(s[x])];
+                *out++ = lut[getg16(s[x])];
+                *out++ = lut[getb16(s[x])];
+            }
+        } break;
+        case 24: {
+            uint8_t *s = src->line[y];
+            for (int x = x0; x < x1; x++) {
+                int c = READ3BYTES(s + x * 3);
+                *out++ = lut[getr24(c)];
+                *out++ = lut[getg24(c)];
+                *out++ = lut[getb24(c)];
+            }
+        } break;
+        case 32: {
+            uint32_t *s = (uint32_t *)src->line[y];
+            for (int x = x0; x < x1; x++) {
+                *out++ = lut[(s[x] >> _rgb_r_shift_32) & 0xFF];
+                *out++ = lut[(s[x] >> _rgb_g_shift_32) & 0xFF];
+                *out++ = lut[(s[x] >> _rgb_b_shift_32) & 0xFF];
+            }
+        } break;
+    }
+}
+
+/**
+ * @brief clamp a value from the vertical pass and convert it to 8bit.
+ */
+static inline int rs_out(int32_t acc, const uint8_t *lut) {
+    int v = (acc + (1 << (RS_SHIFT + RS_MID_SHIFT - 1))) >> (RS_SHIFT + RS_MID_SHIFT);
+    if (v < 0) {
+        v = 0;
+    } else if (v > RS_MAX_VALUE) {
+        v = RS_MAX_VALUE;
+    }
+    return lut[v];
+}
+
+/**
+ * @brief write 8bit R, G, B triplets into a destination row.
+ *
+ * @param dst destination bitmap.
+ * @param y the row.
+ * @param x0 first column.
+ * @param w number of pixels.
+ * @param rgb 3 values per pixel.
+ * @param gray 8bpp pixels are gray values instead of palette indices.
+ */
+static void rs_write_row(BITMAP *dst, int y, int x0, int w, const uint8_t *rgb, bool gray) {
+    int depth = bitmap_color_depth(dst);
+
+    if (!is_memory_bitmap(dst)) {
+        for (int x = x0; x < x0 + w; x++, rgb += 3) {
+            putpixel(dst, x, y, makecol_depth(depth, rgb[0], rgb[1], rgb[2]));
+        }
+        return;
+    }
+
+    switch (depth) {
+        case 8: {
+            uint8_t *d = (uint8_t *)dst->line[y] + x0;
+            for (int x = 0; x < w; x++, rgb += 3) {
+                *d++ = gray ? rgb[1] : makecol8(rgb[0], rgb[1], rgb[2]);
+            }
+        } break;
+        case 15: {
+            uint16_t *d = (uint16_t *)dst->line[y] + x0;
+            for (int x = 0; x < w; x++, rgb += 3) {
+                *d++ = makecol15(rgb[0], rgb[1], rgb[2]);
+            }
+        } break;
+        case 16: {
+            uint16_t *d = (uint16_t *)dst->line[y] + x0;
+            for (int x = 0; x < w; x++, rgb += 3) {
+                *d++ = makecol16(rgb[0], rgb[1], rgb[2]);
+            }
+        } break;
+        case 24: {
+            uint8_t *d = (uint8_t *)dst->line[y] + x0 * 3;
+            for (int x = 0; x < w; x++, rgb += 3, d += 3) {
+                int c = makecol24(rgb[0], rgb[1], rgb[2]);
+                WRITE3BYTES(d, c);
+            }
+        } break;
+        case 32: {
+            uint32_t *d = (uint32_t *)dst->line[y] + x0;
+            for (int x = 0; x < w; x++, rgb += 3) {
+                *d++ = ((uint32_t)rgb[0] << _rgb_r_shift_32) | ((uint32_t)rgb[1] << _rgb_g_shift_32) | ((uint32_t)rgb[2] << _rgb_b_shift_32);
+            }
+        } break;
+    }
+}
+
+/**
+ * @brief compute PSNR of two bitmaps of the same size (all channels).
+ */
+static double rs_psnr(BITMAP *a, BITMAP *b) {
+    int da = bitmap_color_depth(a);
+    int db = bitmap_color_depth(b);
+    double sum = 0;
+
+    for (int y = 0; y < a->h; y++) {
+        for (int x = 0; x < a->w; x++) {
+            int ca = getpixel(a, x, y);
+            int cb = getpixel(b, x, y);
+            int dr = getr_depth(da, ca) - getr_depth(db, cb);
+            int dg = getg_depth(da, ca) - getg_depth(db, cb);
+            int dbl = getb_depth(da, ca) - getb_depth(db, cb);
+            sum += dr * dr + dg * dg + dbl * dbl;
+        }
+    }
+
+    double mse = sum / (a->w * a->h * 3.0);
+    if (mse == 0.0) {
+        return 99.0;
+    }
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief find a filter by name.
+ *
+ * @param name the name (nearest, box, bilinear, bicubic or lanczos3).
+ *
+ * @return the filter or -1 if the name is unknown.
+ */
+int rs_filter_from_name(const char *name) {
+    for (int i = 0; i < RS_NUM_FILTERS; i++) {
+        if (strcasecmp(name, rs_filters[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief get the name of a filter.
+ *
+ * @param filter the filter.
+ *
+ * @return the name.
+ */
+const char *rs_filter_name(int filter) {
+    if (filter < 0 || filter >= RS_NUM_FILTERS) {
+        return "unknown";
+    }
+    return rs_filters[filter].name;
+}
+
+/**
+ * @brief scale an area of a bitmap into an area of another bitmap, like stretch_blit(), but with a selectable filter.
+ * The filter is applied separately in both directions with precomputed fixed point weights. The horizontally filtered source
+ * rows are kept in a ring buffer so every source row is only filtered once. The destination area is clipped against the
+ * destination clipping rectangle, only visible pixels are computed.
+ * Source and destination can have any color depth, 8bpp bitmaps use the current palette (and rgb_map if set). If the current
+ * palette is the gray palette 8bpp pixels are used as gray values.
+ *
+ * @param src source bitmap.
+ * @param dst destination bitmap.
+ * @param sx source area x.
+ * @param sy source area y.
+ * @param sw source area width.
+ * @param sh source area height.
+ * @param dx destination area x.
+ * @param dy destination area y.
+ * @param dw destination area width.
+ * @param dh destination area height.
+ * @param filter the filter to use. RS_NEAREST uses stretch_blit() if the color depths match.
+ * @param linear true to filter in linear light instead of sRGB values.
+ *
+ * @return true for success, false if out of memory.
+ */
+bool rs_stretch(BITMAP *src, BITMAP *dst, int sx, int sy, int sw, int sh, int dx, int dy, int dw, int dh, int filter, bool linear) {
+    if (sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0) {
+        return true;
+    }
+    if (filter < 0 || filter >= RS_NUM_FILTERS) {
+        filter = RS_NEAREST;
+    }
+    if (filter == RS_NEAREST && bitmap_color_depth(src) == bitmap_color_depth(dst)) {
+        stretch_blit(src, dst, sx, sy, sw, sh, dx, dy, dw, dh);
+        return true;
+    }
+    rs_init_luts();
+
+    // visible destination area
+    int cx0 = MAX(dx, dst->cl);
+    int cy0 = MAX(dy, dst->ct);
+    int cx1 = MIN(dx + dw, dst->cr);
+    int cy1 = MIN(dy + dh, dst->cb);
+    if (cx0 >= cx1 || cy0 >= cy1) {
+        return true;
+    }
+    int vis_w = cx1 - cx0;
+
+    bool ret = false;
+    rs_table_t htab = {0};
+    rs_table_t vtab = {0};
+    uint16_t *in = NULL;
+    int32_t *ring = NULL;
+    int *ring_row = NULL;
+    int32_t **rows = NULL;
+    uint8_t *out = NULL;
+
+    if (!rs_make_table(&htab, filter, sx, sw, src->w, dw) || !rs_make_table(&vtab, filter, sy, sh, src->h, dh)) {
+        goto out;
+    }
+
+    // source columns needed for the visible destination columns
+    rs_contrib_t *hc = &htab.contrib[cx0 - dx];
+    int src_x0 = hc[0].start;
+    int src_x1 = hc[vis_w - 1].start + hc[vis_w - 1].count;
+    for (int i = 0; i < vis_w; i++) {
+        src_x0 = MIN(src_x0, hc[i].start);
+        src_x1 = MAX(src_x1, hc[i].start + hc[i].count);
+    }
+
+    int ring_size = vtab.max_count;
+    in = malloc(sizeof(uint16_t) * 3 * (src_x1 - src_x0));
+    ring = malloc(sizeof(int32_t) * 3 * vis_w * ring_size);
+    ring_row = malloc(sizeof(int) * ring_size);
+    rows = malloc(sizeof(int32_t *) * ring_size);
+    out = malloc(3 * vis_w);
+    if (!in || !ring || !ring_row || !rows || !out) {
+        goto out;
+    }
+    for (int i = 0; i < ring_size; i++) {
+        ring_row[i] = -1;
+    }
+
+    bool gray = sk_is_gray(_current_palette);
+    const uint16_t *to_lut = linear ? rs_to_linear : rs_to_wide;
+    const uint8_t *from_lut = linear ? rs_from_linear : rs_from_wide;
+
+    for (int y = cy0; y < cy1; y++) {
+        rs_contrib_t *vc = &vtab.contrib[y - dy];
+
+        // make sure all needed source rows are filtered horizontally
+        for (int r = vc->start; r < vc->start + vc->count; r++) {
+            int slot = r % ring_size;
+            if (ring_row[slot] == r) {
+                continue;
+            }
+            rs_read_row(src, r, src_x0, src_x1, to_lut, gray, in);
+
+            int32_t *h = &ring[slot * 3 * vis_w];
+            for (int x = 0; x < vis_w; x++) {
+                const int16_t *w = &htab.weights[hc[x].offset];
+                const uint16_t *p = &in[(hc[x].start - src_x0) * 3];
+                int32_t r_acc = 0, g_acc = 0, b_acc = 0;
+                for (int i = 0; i < hc[x].count; i++, p += 3) {
+                    r_acc += w[i] * p[0];
+                    g_acc += w[i] * p[1];
+                    b_acc += w[i] * p[2];
+                }
+                *h++ = r_acc >> (RS_SHIFT - RS_MID_SHIFT);
+                *h++ = g_acc >> (RS_SHIFT - RS_MID_SHIFT);
+                *h++ = b_acc >> (RS_SHIFT - RS_MID_SHIFT);
+            }
+            ring_row[slot] = r;
+        }
+
+        // filter vertically
+        for (int i = 0; i < vc->count; i++) {
+            rows[i] = &ring[((vc->start + i) % ring_size) * 3 * vis_w];
+        }
+        const int16_t *w = &vtab.weights[vc->offset];
+        uint8_t *o = out;
+        for (int x = 0; x < vis_w * 3; x++) {
+            int32_t acc = 0;
+            for (int i = 0; i < vc->count; i++) {
+                acc += w[i] * rows[i][x];
+            }
+            *o++ = rs_out(acc, from_lut);
+        }
+        rs_write_row(dst, y, cx0, vis_w, out, gray);
+    }
+    ret = true;
+
+out:
+    if (!ret) {
+        DEBUGF("Out of memory scaling %dx%d to %dx%d\n", sw, sh, dw, dh);
+    }
+    free(out);
+    free(rows);
+    free(ring_row);
+    free(ring);
+    free(in);
+    rs_free_table(&vtab);
+    rs_free_table(&htab);
+    return ret;
+}
+
+/**
+ * @brief compare speed and quality of all filters with stretch_blit().
+ * An area of the image (max. 512x512) is scaled with several factors. Speed is reported in destination megapixel per second,
+ * quality as PSNR of scaling the area and then scaling the result back to the original size with the same filter.
+ *
+ * @param img the image.
+ * @param linear true to filter in linear light.
+ * @param out stream for the results.
+ */
+void rs_benchmark(BITMAP *img, bool linear, FILE *out) {
+    static const float factors[] = {0.25f, 0.5f, 0.9f, 2.0f};
+    int w = MIN(img->w, RS_BENCH_SIZE);
+    int h = MIN(img->h, RS_BENCH_SIZE);
+    int depth = bitmap_color_depth(img);
+
+    BITMAP *area = create_bitmap_ex(depth, w, h);
+    BITMAP *back = create_bitmap_ex(depth, w, h);
+    if (!area || !back) {
+        fputs("Out of memory.\n", out);
+        goto out;
+    }
+    blit(img, area, (img->w - w) / 2, (img->h - h) / 2, 0, 0, w, h);
+
+    fprintf(out, "Benchmark area %dx%d @ %dbpp, %s light\n", w, h, depth, linear ? "linear" : "sRGB");
+    fprintf(out, "%-10s %6s %10s %10s\n", "filter", "factor", "Mpixel/s", "PSNR dB");
+    for (int f = 0; f < RS_NUM_FILTERS; f++) {
+        for (int i = 0; i < (int)(sizeof(factors) / sizeof(factors[0])); i++) {
+            int sw = MAX((int)(w * factors[i]), 1);
+            int sh = MAX((int)(h * factors[i]), 1);
+            BITMAP *scaled = create_bitmap_ex(depth, sw, sh);
+            if (!scaled) {
+                fprintf(out, "%-10s %6.2f  out of memory\n", rs_filter_name(f), factors[i]);
+                continue;
+            }
+
+            int runs = 0;
+            uint64_t start = ut_time_us();
+            uint64_t elapsed;
+            do {
+                rs_stretch(area, scaled, 0, 0, w, h, 0, 0, sw, sh, f, linear);
+                runs++;
+                elapsed = ut_time_us() - start;
+            } while (elapsed < RS_BENCH_TIME);
+
+            rs_stretch(scaled, back, 0, 0, sw, sh, 0, 0, w, h, f, linear);
+            double mpix = (double)sw * sh * runs / (elapsed ? elapsed : 1);
+            fprintf(out, "%-10s %6.2f %10.2f %10.2f\n", rs_filter_name(f), factors[i], mpix, rs_psnr(area, back));
+            destroy_bitmap(scaled);
+        }
+    }
+
+out:
+    if (back) {
+        destroy_bitmap(back);
+    }
+    if (area) {
+        destroy_bitmap(area);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __RESAMPLE_H__
+#define __RESAMPLE_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+//! available resampling filters
+typedef enum {
+    RS_NEAREST = 0,  //!< nearest neighbour (Allegro stretch_blit())
+    RS_BOX,          //!< box filter, area average when reducing
+    RS_BILINEAR,     //!< triangle filter
+    RS_BICUBIC,      //!< Catmull-Rom cubic
+    RS_LANCZOS3,     //!< windowed sinc with 3 lobes
+    RS_NUM_FILTERS   //!< number of filters
+} rs_filter_t;
+
+/***********************
+** exported functions **
+***********************/
+extern int rs_filter_from_name(const char *name);
+extern const char *rs_filter_name(int filter);
+extern bool rs_stretch(BITMAP *src, BITMAP *dst, int sx, int sy, int sw, int sh, int dx, int dy, int dw, int dh, int filter, bool linear);
+extern void rs_benchmark(BITMAP *img, bool linear, FILE *out);
+
+#endif  // __RESAMPLE_H__
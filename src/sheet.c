@@ -0,0 +1,331 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "sheet.h"
+#include "display.h"
+#include "sink.h"
+
+/************
+** defines **
+************/
+#define SH_CELL_W (TH_SIZE + 10)      //!< width of a cell (thumbnail and border)
+#define SH_CELL_H (TH_SIZE + 10 + 10) //!< height of a cell (thumbnail, border and name)
+#define SH_TOP 12                     //!< height of the title line
+
+#define SH_NONE 0    //!< thumbnail not looked up yet
+#define SH_MISSING 1 //!< thumbnail not in the index, must be decoded
+#define SH_DONE 2    //!< thumbnail loaded (or the image can't be decoded)
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief number of images on a page.
+ *
+ * @param sh the contact sheet.
+ */
+static inline int sh_page(sheet_t *sh) { return sh->cols * sh->rows; }
+
+/**
+ * @brief store the thumbnail of an image in screen depth.
+ *
+ * @param sh the contact sheet.
+ * @param i index of the image.
+ * @param thumb the 24bpp thumbnail or NULL, is freed.
+ */
+static void sh_set_thumb(sheet_t *sh, int i, BITMAP *thumb) {
+    if (thumb) {
+        sh->thumbs[i] = create_bitmap(thumb->w, thumb->h);
+        if (sh->thumbs[i]) {
+            blit(thumb, sh->thumbs[i], 0, 0, 0, 0, thumb->w, thumb->h);
+        }
+        destroy_bitmap(thumb);
+    }
+}
+
+/**
+ * @brief get the thumbnails of the page that are in the index, this does not decode any image.
+ *
+ * @param sh the contact sheet.
+ */
+static void sh_load_page(sheet_t *sh) {
+    int last = MIN(sh->first + sh_page(sh), sh->num_files);
+    for (int i = sh->first; i < last; i++) {
+        if (sh->state[i] == SH_NONE) {
+            BITMAP *thumb = th_get(&sh->index, sh->files[i], false);
+            sh->state[i] = thumb ? SH_DONE : SH_MISSING;
+            sh_set_thumb(sh, i, thumb);
+        }
+    }
+}
+
+/**
+ * @brief decode the next missing thumbnail of the page.
+ *
+ * @param sh the contact sheet.
+ *
+ * @return false if all thumbnails of the page are done.
+ */
+static bool sh_make_next(sheet_t *sh) {
+    int last = MIN(sh->first + sh_page(sh), sh->num_files);
+    for (int i = sh->first; i < last; i++) {
+        if (sh->state[i] != SH_DONE) {
+            sh->state[i] = SH_DONE;
+            sh_set_thumb(sh, i, th_get(&sh->index, sh->files[i], true));
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief add the next image that is not on the page to the thumbnail index, so the next visit does not need to decode it.
+ *
+ * @param sh the contact sheet.
+ *
+ * @return false if all images were added.
+ */
+static bool sh_index_next(sheet_t *sh) {
+    while (sh->next_index < sh->num_files) {
+        int i = sh->next_index++;
+        if (sh->state[i] == SH_NONE) {
+            BITMAP *thumb = th_get(&sh->index, sh->files[i], true);
+            if (thumb) {
+                destroy_bitmap(thumb);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief make the selected image visible and free thumbnails far away from the page.
+ *
+ * @param sh the contact sheet.
+ */
+static void sh_scroll(sheet_t *sh) {
+    int page = sh_page(sh);
+    sh->selected = MAX(0, MIN(sh->selected, sh->num_files - 1));
+    if (sh->selected < sh->first) {
+        sh->first = sh->selected - sh->selected % sh->cols;
+    } else if (sh->selected >= sh->first + page) {
+        sh->first = sh->selected - sh->selected % sh->cols - (sh->rows - 1) * sh->cols;
+    }
+
+    // keep the neighbouring pages for paging back and forth
+    for (int i = 0; i < sh->num_files; i++) {
+        if (sh->thumbs[i] && ((i < sh->first - page) || (i >= sh->first + 2 * page))) {
+            destroy_bitmap(sh->thumbs[i]);
+            sh->thumbs[i] = NULL;
+            sh->state[i] = SH_NONE;
+        }
+    }
+}
+
+/**
+ * @brief compose the page.
+ *
+ * @param sh the contact sheet.
+ * @param target the bitmap to draw to, must have the size of the screen.
+ */
+static void sh_render(sheet_t *sh, BITMAP *target) {
+    int depth = bitmap_color_depth(target);
+    int txt_col = makecol_depth(depth, 161, 21, 158);
+    int sel_col = makecol_depth(depth, 227, 198, 34);
+    int box_col = makecol_depth(depth, 32, 32, 32);
+    int x_off = (sh->screen_width - sh->cols * SH_CELL_W) / 2;
+    int max_chars = (SH_CELL_W - 2) / 8;
+
+    clear_to_color(target, 0);
+    textprintf_ex(target, font, x_off, 2, txt_col, -1, "%s (%d/%d)", sh->files[sh->selected], sh->selected + 1, sh->num_files);
+
+    int last = MIN(sh->first + sh_page(sh), sh->num_files);
+    for (int i = sh->first; i < last; i++) {
+        int x = x_off + ((i - sh->first) % sh->cols) * SH_CELL_W;
+        int y = SH_TOP + ((i - sh->first) / sh->cols) * SH_CELL_H;
+
+        BITMAP *thumb = sh->thumbs[i];
+        if (thumb) {
+            blit(thumb, target, 0, 0, x + 5 + (TH_SIZE - thumb->w) / 2, y + 5 + (TH_SIZE - thumb->h) / 2, thumb->w, thumb->h);
+        } else {
+            rectfill(target, x + 5, y + 5, x + 4 + TH_SIZE, y + 4 + TH_SIZE, box_col);
+            if (sh->state[i] == SH_DONE) {
+                textout_centre_ex(target, font, "?", x + 5 + TH_SIZE / 2, y + 1 + TH_SIZE / 2, txt_col, -1);
+            }
+        }
+        if (i == sh->selected) {
+            rect(target, x + 1, y + 1, x + SH_CELL_W - 2, y + SH_CELL_H - 2, sel_col);
+        }
+
+        char name[SH_CELL_W / 8 + 1];
+        snprintf(name, sizeof(name), "%.*s", max_chars, get_filename(sh->files[i]));
+        textout_centre_ex(target, font, name, x + SH_CELL_W / 2, y + TH_SIZE + 8, txt_col, -1);
+    }
+}
+
+/**
+ * @brief apply a key press.
+ *
+ * @param sh the contact sheet.
+ * @param key the key as returned by readkey().
+ *
+ * @return 1 to open the selected image, -1 to quit, else 0.
+ */
+static int sh_handle_key(sheet_t *sh, int key) {
+    int key_upper = (key >> 8);
+    char key_lower = (char)(key & 0xFF);
+
+    DEBUGF("key=%04X\n", key);
+
+    if ((key_upper == KEY_ESC) || (key_lower == 'Q') || (key_lower == 'q')) {
+        return -1;
+    } else if ((key_upper == KEY_ENTER) || (key_upper == KEY_ENTER_PAD)) {
+        return 1;
+    } else if ((key_upper == KEY_LEFT) || (key_lower == '4')) {
+        sh->selected--;
+    } else if ((key_upper == KEY_RIGHT) || (key_lower == '6')) {
+        sh->selected++;
+    } else if ((key_upper == KEY_UP) || (key_lower == '8')) {
+        if (sh->selected >= sh->cols) {
+            sh->selected -= sh->cols;
+        }
+    } else if ((key_upper == KEY_DOWN) || (key_lower == '2')) {
+        if (sh->selected + sh->cols < sh->num_files) {
+            sh->selected += sh->cols;
+        }
+    } else if ((key_upper == KEY_PGUP) || (key_lower == '9')) {
+        sh->selected -= sh_page(sh);
+    } else if ((key_upper == KEY_PGDN) || (key_lower == '3')) {
+        sh->selected += sh_page(sh);
+    } else if ((key_upper == KEY_HOME) || (key_lower == '7')) {
+        sh->selected = 0;
+    } else if ((key_upper == KEY_END) || (key_lower == '1')) {
+        sh->selected = sh->num_files - 1;
+    }
+    return 0;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize the contact sheet.
+ *
+ * @param sh the contact sheet.
+ * @param files the images.
+ * @param num_files number of images.
+ * @param screen_width width of the output.
+ * @param screen_height height of the output.
+ *
+ * @return false if there is not enough memory.
+ */
+bool sh_init(sheet_t *sh, char **files, int num_files, int screen_width, int screen_height) {
+    memset(sh, 0, sizeof(sheet_t));
+    sh->files = files;
+    sh->num_files = num_files;
+    sh->screen_width = screen_width;
+    sh->screen_height = screen_height;
+    sh->cols = MAX(1, screen_width / SH_CELL_W);
+    sh->rows = MAX(1, (screen_height - SH_TOP) / SH_CELL_H);
+    sh->thumbs = calloc(num_files, sizeof(BITMAP *));
+    sh->state = calloc(num_files, sizeof(uint8_t));
+    th_init(&sh->index);
+
+    // thumbnails are converted to the 3-3-2 palette on 8bpp screens
+    if (get_color_depth() == 8) {
+        generate_332_palette(sh->pal);
+        create_rgb_table(&sh->rgb_table, sh->pal, NULL);
+    }
+    return sh->thumbs && sh->state;
+}
+
+/**
+ * @brief show the contact sheet until the user opens an image or quits.
+ * Thumbnails that are in the index are shown at once, the missing ones of the page are decoded one by one while the user
+ * is idle. After that the rest of the images is added to the index for the next visit.
+ *
+ * @param sh the contact sheet.
+ * @param selected index of the image to select.
+ *
+ * @return index of the image to open or -1 if the user wants to quit.
+ */
+int sh_show(sheet_t *sh, int selected) {
+    if (get_color_depth() == 8) {
+        sk_set_palette(sh->pal);
+        rgb_map = &sh->rgb_table;
+    }
+    sh->selected = selected;
+
+    while (true) {
+        sh_scroll(sh);
+        sh_load_page(sh);
+        sh_render(sh, dp_get_buffer());
+        dp_present();
+
+        if (keyboard_needs_poll()) {
+            poll_keyboard();
+        }
+        while (!keypressed() && sh_make_next(sh)) {
+            sh_render(sh, dp_get_buffer());
+            dp_present();
+            if (keyboard_needs_poll()) {
+                poll_keyboard();
+            }
+        }
+        while (!keypressed() && sh_index_next(sh)) {
+            if (keyboard_needs_poll()) {
+                poll_keyboard();
+            }
+        }
+
+        // block until there is input, then apply everything that queued up
+        int action = sh_handle_key(sh, readkey());
+        while (!action && keypressed()) {
+            action = sh_handle_key(sh, readkey());
+        }
+        if (action) {
+            return (action > 0) ? MAX(0, MIN(sh->selected, sh->num_files - 1)) : -1;
+        }
+    }
+}
+
+/**
+ * @brief free all resources of the contact sheet (but not the file list).
+ *
+ * @param sh the contact sheet.
+ */
+void sh_exit(sheet_t *sh) {
+    for (int i = 0; sh->thumbs && (i < sh->num_files); i++) {
+        if (sh->thumbs[i]) {
+            destroy_bitmap(sh->thumbs[i]);
+        }
+    }
+    free(sh->thumbs);
+    free(sh->state);
+    th_exit(&sh->index);
+    if (rgb_map == &sh->rgb_table) {
+        rgb_map = NULL;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __SHEET_H__
+#define __SHEET_H__
+
+#include "main.h"
+#include "thumbs.h"
+
+/************
+** structs **
+************/
+//! state of the contact sheet
+typedef struct __sheet {
+    char **files;       //!< the images
+    int num_files;      //!< number of images
+    int screen_width;   //!< width of the output
+    int screen_height;  //!< height of the output
+    int cols;           //!< thumbnails per row
+    int rows;           //!< rows per page
+    int selected;       //!< index of the selected image
+    int first;          //!< index of the first image on the page
+    BITMAP **thumbs;    //!< thumbnails in screen depth, NULL if not loaded
+    uint8_t *state;     //!< SH_* state of each thumbnail
+    int next_index;     //!< next image to add to the thumbnail index while the user is idle
+    th_index_t index;   //!< thumbnail index of the current directory
+    PALETTE pal;        //!< palette for 8bpp screens
+    RGB_MAP rgb_table;  //!< color lookup for 8bpp screens
+} sheet_t;
+
+/***********************
+** exported functions **
+***********************/
+extern bool sh_init(sheet_t *sh, char **files, int num_files, int screen_width, int screen_height);
+extern int sh_show(sheet_t *sh, int selected);
+extern void sh_exit(sheet_t *sh);
+
+#endif  // __SHEET_H__
@@ -0,0 +1,607 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "sink.h"
+#include "stats.h"
+
+/************
+** defines **
+************/
+#define SK_DITHER_SIZE 16  //!< number of thresholds in the dither matrix
+#define SK_PROGRESS_STEPS 256  //!< load_progress() is called when the progress changes by 1/SK_PROGRESS_STEPS
+#define SK_ORIENT_BLOCK 32     //!< edge of the blocks sk_orient() transposes at once, their source and destination lines stay in the cache
+
+/*********************
+** static functions **
+*********************/
+//! 4x4 Bayer matrix
+static const uint8_t sk_bayer[4][4] = {
+    {0, 8, 2, 10},   //
+    {12, 4, 14, 6},  //
+    {3, 11, 1, 9},   //
+    {15, 7, 13, 5}   //
+};
+
+static uint8_t sk_dither2[SK_DITHER_SIZE][256];  //!< 8bit -> 2bit for every threshold
+static uint8_t sk_dither3[SK_DITHER_SIZE][256];  //!< 8bit -> 3bit for every threshold
+static uint8_t sk_dither5[SK_DITHER_SIZE][256];  //!< 8bit -> 5bit for every threshold
+static uint8_t sk_dither6[SK_DITHER_SIZE][256];  //!< 8bit -> 6bit for every threshold
+static bool sk_dither_done = false;
+static uint32_t sk_progress_step = UINT32_MAX;  //!< step last passed to load_progress()
+
+/**
+ * @brief fill one quantization table with ordered dither thresholds.
+ *
+ * @param table the table.
+ * @param bits number of bits of the output.
+ */
+static void sk_fill_dither(uint8_t table[SK_DITHER_SIZE][256], int bits) {
+    int max = (1 << bits) - 1;
+
+    for (int t = 0; t < SK_DITHER_SIZE; t++) {
+        for (int v = 0; v < 256; v++) {
+            // floor(v * max / 255 + (t + 0.5) / 16)
+            int q = (v * max * 32 + (2 * t + 1) * 255) / (255 * 32);
+            table[t][v] = MIN(q, max);
+        }
+    }
+}
+
+/**
+ * @brief create the dither tables on first use.
+ */
+static void sk_init_dither(void) {
+    if (sk_dither_done) {
+        return;
+    }
+    sk_fill_dither(sk_dither2, 2);
+    sk_fill_dither(sk_dither3, 3);
+    sk_fill_dither(sk_dither5, 5);
+    sk_fill_dither(sk_dither6, 6);
+    sk_dither_done = true;
+}
+
+/**
+ * @brief luminance of a RGB triplet.
+ */
+static inline uint8_t sk_luma(int r, int g, int b) { return (r * 77 + g * 150 + b * 29) >> 8; }
+
+/**
+ * @brief sum up a decoded row into the output blocks, a complete row of blocks is averaged and stored in the bitmap.
+ *
+ * @param sk the sink.
+ * @param y number of the row in the decoded image.
+ * @param row the pixels.
+ */
+static void sk_shrink_row(sink_t *sk, int y, const uint8_t *row) {
+    int ch = sk->format;
+    for (int x = 0; x < sk->width; x++) {
+        uint32_t *a = &sk->acc[(x / sk->shrink) * ch];
+        for (int c = 0; c < ch; c++) {
+            a[c] += *row++;
+        }
+    }
+    sk->rows++;
+
+    // a row of blocks is complete
+    if ((sk->rows == sk->shrink) || (y == sk->height - 1)) {
+        for (int bx = 0; bx < sk->bm->w; bx++) {
+            int cols = MIN(sk->shrink, sk->width - bx * sk->shrink);
+            uint32_t n = cols * sk->rows;
+            for (int c = 0; c < ch; c++) {
+                sk->avg[bx * ch + c] = (sk->acc[bx * ch + c] + n / 2) / n;
+            }
+        }
+        sk_write_row(sk->bm, y / sk->shrink, sk->avg, sk->format);
+        memset(sk->acc, 0, sk->bm->w * ch * sizeof(uint32_t));
+        sk->rows = 0;
+    }
+}
+
+/**
+ * @brief expand a row of a bitmap into bytes, see sk_read_row().
+ *
+ * @param bm the bitmap (memory bitmap).
+ * @param y the row.
+ * @param row output buffer, bm->w pixels in 'format'.
+ * @param format SK_GRAY, SK_RGB or SK_RGBA.
+ * @param pal palette for 8bpp bitmaps or NULL to use the current palette.
+ */
+static void sk_read_pixels(BITMAP *bm, int y, uint8_t *row, int format, AL_CONST RGB *pal) {
+    int depth = bitmap_color_depth(bm);
+
+    if (!pal) {
+        pal = _current_palette;
+    }
+
+    if (depth == 8 && sk_is_gray(pal)) {
+        uint8_t *s = bm->line[y];
+        for (int x = 0; x < bm->w; x++) {
+            if (format == SK_GRAY) {
+                *row++ = s[x];
+            } else {
+                *row++ = s[x];
+                *row++ = s[x];
+                *row++ = s[x];
+                if (format == SK_RGBA) {
+                    *row++ = 0xFF;
+                }
+            }
+        }
+        return;
+    }
+
+    for (int x = 0; x < bm->w; x++) {
+        int r, g, b;
+        switch (depth) {
+            case 8: {
+                int c = bm->line[y][x];
+                r = _rgb_scale_6[pal[c].r];
+                g = _rgb_scale_6[pal[c].g];
+                b = _rgb_scale_6[pal[c].b];
+            } break;
+            case 15: {
+                int c = ((uint16_t *)bm->line[y])[x];
+                r = getr15(c);
+                g = getg15(c);
+                b = getb15(c);
+            } break;
+            case 16: {
+                int c = ((uint16_t *)bm->line[y])[x];
+                r = getr16(c);
+                g = getg16(c);
+                b = getb16(c);
+            } break;
+            case 24: {
+                int c = READ3BYTES(bm->line[y] + x * 3);
+                r = getr24(c);
+                g = getg24(c);
+                b = getb24(c);
+            } break;
+            default: {
+                uint32_t c = ((uint32_t *)bm->line[y])[x];
+                r = getr32(c);
+                g = getg32(c);
+                b = getb32(c);
+            } break;
+        }
+
+        if (format == SK_GRAY) {
+            *row++ = sk_luma(r, g, b);
+        } else {
+            *row++ = r;
+            *row++ = g;
+            *row++ = b;
+            if (format == SK_RGBA) {
+                *row++ = 0xFF;
+            }
+        }
+    }
+}
+
+/**
+ * @brief mirror a bitmap horizontally and/or vertically in place.
+ *
+ * @param bm the bitmap (memory bitmap).
+ * @param mirror_h mirror left and right.
+ * @param mirror_v mirror top and bottom.
+ *
+ * @return false if there was no memory for a temporary row.
+ */
+static bool sk_mirror(BITMAP *bm, bool mirror_h, bool mirror_v) {
+    int bpp = (bitmap_color_depth(bm) + 7) / 8;
+    int len = bm->w * bpp;
+
+    if (mirror_h) {
+        uint8_t px[4];
+        for (int y = 0; y < bm->h; y++) {
+            uint8_t *line = bm->line[y];
+            for (int l = 0, r = bm->w - 1; l < r; l++, r--) {
+                memcpy(px, &line[l * bpp], bpp);
+                memcpy(&line[l * bpp], &line[r * bpp], bpp);
+                memcpy(&line[r * bpp], px, bpp);
+            }
+        }
+    }
+    if (mirror_v) {
+        uint8_t *tmp = malloc(len);
+        if (!tmp) {
+            return false;
+        }
+        for (int top = 0, bottom = bm->h - 1; top < bottom; top++, bottom--) {
+            memcpy(tmp, bm->line[top], len);
+            memcpy(bm->line[top], bm->line[bottom], len);
+            memcpy(bm->line[bottom], tmp, len);
+        }
+        free(tmp);
+    }
+    return true;
+}
+
+/**
+ * @brief copy a bitmap transposed (dst(x, y) = src(y, x)), optionally mirrored afterwards. The copy is done in square blocks,
+ * so the source columns read for a block are in the cache for all of its rows.
+ *
+ * @param src the bitmap.
+ * @param dst a bitmap of the same depth with width and height swapped.
+ * @param mirror_h mirror the result left and right.
+ * @param mirror_v mirror the result top and bottom.
+ */
+static void sk_transpose(BITMAP *src, BITMAP *dst, bool mirror_h, bool mirror_v) {
+    int bpp = (bitmap_color_depth(src) + 7) / 8;
+    for (int by = 0; by < dst->h; by += SK_ORIENT_BLOCK) {
+        for (int bx = 0; bx < dst->w; bx += SK_ORIENT_BLOCK) {
+            int ey = MIN(by + SK_ORIENT_BLOCK, dst->h);
+            int ex = MIN(bx + SK_ORIENT_BLOCK, dst->w);
+            for (int y = by; y < ey; y++) {
+                uint8_t *d = dst->line[y];
+                int sx = mirror_v ? src->w - 1 - y : y;
+                for (int x = bx; x < ex; x++) {
+                    const uint8_t *s = src->line[mirror_h ? src->h - 1 - x : x];
+                    switch (bpp) {
+                        case 4:
+                            ((uint32_t *)d)[x] = ((const uint32_t *)s)[sx];
+                            break;
+                        case 2:
+                            ((uint16_t *)d)[x] = ((const uint16_t *)s)[sx];
+                            break;
+                        case 1:
+                            d[x] = s[sx];
+                            break;
+                        default:
+                            memcpy(&d[x * bpp], &s[sx * bpp], bpp);
+                            break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief create the bitmap for a loader in the color depth requested by 'load_depth'.
+ * Gray images are always kept as 8bpp with a gray palette (see sk_gray_palette()), whatever 'load_depth' says.
+ * For other images at 8bpp a 3-3-2 palette is put into 'pal', sk_write_row() dithers to it.
+ *
+ * @param w width.
+ * @param h height.
+ * @param pal palette passed to the loader (may be NULL).
+ * @param format the format of the rows that will be written (SK_GRAY, SK_RGB or SK_RGBA).
+ *
+ * @return the bitmap or NULL if out of memory.
+ */
+BITMAP *sk_create_bitmap(int w, int h, RGB *pal, int format) {
+    int depth = load_depth;
+
+    if (format == SK_GRAY) {
+        depth = 8;
+    } else if (depth != 8 && depth != 15 && depth != 16 && depth != 24 && depth != 32) {
+        depth = 32;
+    }
+
+    BITMAP *bm = create_bitmap_ex(depth, w, h);
+    if (!bm) {
+        DEBUGF("Can't create %dx%dx%d bitmap: %s\n", w, h, depth, allegro_error);
+        return NULL;
+    }
+
+    if (depth < 24) {
+        sk_init_dither();
+    }
+
+    if (format == SK_GRAY) {
+        if (pal) {
+            sk_gray_palette(pal);
+        }
+    } else if (depth == 8 && pal) {
+        for (int i = 0; i < PAL_SIZE; i++) {
+            pal[i].r = ((i >> 5) & 0x07) * 63 / 7;
+            pal[i].g = ((i >> 2) & 0x07) * 63 / 7;
+            pal[i].b = (i & 0x03) * 63 / 3;
+        }
+    }
+
+    return bm;
+}
+
+/**
+ * @brief convert a decoded row into the format of the bitmap, 8/15/16bpp are ordered dithered.
+ * SK_GRAY rows are copied unchanged into 8bpp bitmaps, sk_create_bitmap() gave them a gray palette.
+ *
+ * @param bm a bitmap created by sk_create_bitmap().
+ * @param y the row.
+ * @param row the pixels, bm->w pixels in 'format'.
+ * @param format SK_GRAY, SK_RGB or SK_RGBA. The alpha channel is only kept for 32bpp, all other formats are stored as opaque.
+ */
+void sk_write_row(BITMAP *bm, int y, const uint8_t *row, int format) {
+    int step = format;
+    int g_off = (format == SK_GRAY) ? 0 : 1;
+    int b_off = (format == SK_GRAY) ? 0 : 2;
+    const uint8_t *bayer = sk_bayer[y & 3];
+
+    switch (bitmap_color_depth(bm)) {
+        case 8: {
+            uint8_t *d = bm->line[y];
+            if (format == SK_GRAY) {
+                memcpy(d, row, bm->w);
+                break;
+            }
+            for (int x = 0; x < bm->w; x++, row += step) {
+                int t = bayer[x & 3];
+                *d++ = (sk_dither3[t][row[0]] << 5) | (sk_dither3[t][row[g_off]] << 2) | sk_dither2[t][row[b_off]];
+            }
+        } break;
+        case 15: {
+            uint16_t *d = (uint16_t *)bm->line[y];
+            for (int x = 0; x < bm->w; x++, row += step) {
+                int t = bayer[x & 3];
+                *d++ = (sk_dither5[t][row[0]] << _rgb_r_shift_15) | (sk_dither5[t][row[g_off]] << _rgb_g_shift_15) | (sk_dither5[t][row[b_off]] << _rgb_b_shift_15);
+            }
+        } break;
+        case 16: {
+            uint16_t *d = (uint16_t *)bm->line[y];
+            for (int x = 0; x < bm->w; x++, row += step) {
+                int t = bayer[x & 3];
+                *d++ = (sk_dither5[t][row[0]] << _rgb_r_shift_16) | (sk_dither6[t][row[g_off]] << _rgb_g_shift_16) | (sk_dither5[t][row[b_off]] << _rgb_b_shift_16);
+            }
+        } break;
+        case 24: {
+            uint8_t *d = bm->line[y];
+            for (int x = 0; x < bm->w; x++, row += step, d += 3) {
+                int c = (row[0] << _rgb_r_shift_24) | (row[g_off] << _rgb_g_shift_24) | (row[b_off] << _rgb_b_shift_24);
+                WRITE3BYTES(d, c);
+            }
+        } break;
+        case 32: {
+            uint32_t *d = (uint32_t *)bm->line[y];
+            for (int x = 0; x < bm->w; x++, row += step) {
+                uint32_t a = (format == SK_RGBA) ? row[3] : 0xFF;
+                *d++ = ((uint32_t)row[0] << _rgb_r_shift_32) | ((uint32_t)row[g_off] << _rgb_g_shift_32) | ((uint32_t)row[b_off] << _rgb_b_shift_32) | (a << _rgb_a_shift_32);
+            }
+        } break;
+    }
+}
+
+/**
+ * @brief start receiving the rows of a decoded image.
+ * The bitmap is created with sk_create_bitmap() in the size of the image divided by 'shrink' (rounded up).
+ * If 'load_tiles' is set the full size image is also written into that tile store, the bitmap is only an overview then.
+ *
+ * @param sk the sink.
+ * @param w width of the decoded image.
+ * @param h height of the decoded image.
+ * @param pal palette passed to the loader (may be NULL).
+ * @param format format of the rows (SK_GRAY, SK_RGB or SK_RGBA).
+ * @param shrink reduction factor (1 for full size).
+ *
+ * @return true if the bitmap could be created.
+ */
+bool sk_begin(sink_t *sk, int w, int h, RGB *pal, int format, int shrink) {
+    memset(sk, 0, sizeof(sink_t));
+    sk->format = format;
+    sk->shrink = MAX(shrink, 1);
+    sk->width = w;
+    sk->height = h;
+
+    int out_w = (w + sk->shrink - 1) / sk->shrink;
+    int out_h = (h + sk->shrink - 1) / sk->shrink;
+    if (sk->shrink > 1) {
+        DEBUGF("sink reduces %dx%d to %dx%d\n", w, h, out_w, out_h);
+        sk->acc = calloc(out_w * format, sizeof(uint32_t));
+        sk->avg = malloc(out_w * format);
+        if (!sk->acc || !sk->avg) {
+            sk_abort(sk);
+            return false;
+        }
+    }
+
+    sk->bm = sk_create_bitmap(out_w, out_h, pal, format);
+    if (!sk->bm) {
+        sk_abort(sk);
+        return false;
+    }
+
+    if (load_tiles) {
+        sk->tiles = load_tiles;
+        if (!ts_begin(sk->tiles, w, h, bitmap_color_depth(sk->bm), format == SK_GRAY)) {
+            sk_abort(sk);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief store the next decoded row. Rows must be put in order from top to bottom.
+ *
+ * @param sk the sink.
+ * @param y number of the row in the decoded image.
+ * @param row the pixels, width pixels in the format given to sk_begin().
+ */
+void sk_put_row(sink_t *sk, int y, const uint8_t *row) {
+    if (sk->tiles) {
+        ts_put_row(sk->tiles, y, row, sk->format);
+    }
+
+    st_push(ST_CONVERT);
+    if (sk->shrink == 1) {
+        sk_write_row(sk->bm, y, row, sk->format);
+    } else {
+        sk_shrink_row(sk, y, row);
+    }
+    st_pop();
+}
+
+/**
+ * @brief report how far decoding is to load_progress() (if set). It is only called when the progress changed noticeably,
+ * so loaders may report every row. A new image starts with done = 0. The time spent in it does not count as decoding.
+ *
+ * @param done work done, in any unit the loader likes (rows, strips, bytes...).
+ * @param total total work in the same unit.
+ *
+ * @return false if loading should be aborted, the loader frees everything and returns NULL then.
+ */
+bool sk_progress(uint32_t done, uint32_t total) {
+    if (!load_progress || !total) {
+        return true;
+    }
+    uint32_t step = (uint32_t)((uint64_t)MIN(done, total) * SK_PROGRESS_STEPS / total);
+    if ((step == sk_progress_step) && done) {
+        return true;
+    }
+    sk_progress_step = step;
+
+    st_push(ST_OTHER);
+    bool go_on = load_progress(done, total);
+    st_pop();
+    return go_on;
+}
+
+/**
+ * @brief end receiving rows.
+ *
+ * @param sk the sink.
+ *
+ * @return the bitmap, it now belongs to the caller.
+ */
+BITMAP *sk_finish(sink_t *sk) {
+    BITMAP *bm = sk->bm;
+    sk->bm = NULL;
+    sk->tiles = NULL;
+    sk_abort(sk);
+    return bm;
+}
+
+/**
+ * @brief free everything allocated by the sink, including the bitmap and the contents of the tile store.
+ *
+ * @param sk the sink.
+ */
+void sk_abort(sink_t *sk) {
+    if (sk->bm) {
+        destroy_bitmap(sk->bm);
+        sk->bm = NULL;
+    }
+    if (sk->tiles) {
+        ts_exit(sk->tiles);
+        sk->tiles = NULL;
+    }
+    free(sk->acc);
+    free(sk->avg);
+    sk->acc = NULL;
+    sk->avg = NULL;
+}
+
+/**
+ * @brief turn a bitmap the way it is meant to be shown, e.g. for the EXIF orientation of a photo.
+ * The result is the source transposed (if requested), then mirrored. Mirroring works in place, transposing needs
+ * a second bitmap for a moment. If there is no memory for that the bitmap is returned unchanged.
+ *
+ * @param bm the bitmap (memory bitmap), it is destroyed if a new one is returned.
+ * @param transpose swap rows and columns.
+ * @param mirror_h mirror left and right.
+ * @param mirror_v mirror top and bottom.
+ *
+ * @return the turned bitmap.
+ */
+BITMAP *sk_orient(BITMAP *bm, bool transpose, bool mirror_h, bool mirror_v) {
+    st_push(ST_CONVERT);
+    if (transpose) {
+        BITMAP *dst = create_bitmap_ex(bitmap_color_depth(bm), bm->h, bm->w);
+        if (dst) {
+            sk_transpose(bm, dst, mirror_h, mirror_v);
+            destroy_bitmap(bm);
+            bm = dst;
+        } else {
+            DEBUGF("No memory to turn a %dx%d bitmap\n", bm->w, bm->h);
+        }
+    } else if (mirror_h || mirror_v) {
+        if (!sk_mirror(bm, mirror_h, mirror_v)) {
+            DEBUGF("No memory to mirror a %dx%d bitmap\n", bm->w, bm->h);
+        }
+    }
+    st_pop();
+    return bm;
+}
+
+/**
+ * @brief expand a row of a bitmap of any color depth into bytes, e.g. for an encoder.
+ * Pixels of 8bpp bitmaps with a gray palette are their gray value, this keeps the full 8bit of gray images.
+ *
+ * @param bm the bitmap (memory bitmap).
+ * @param y the row.
+ * @param row output buffer, bm->w pixels in 'format'.
+ * @param format SK_GRAY, SK_RGB or SK_RGBA. Alpha is always 0xFF.
+ * @param pal palette for 8bpp bitmaps or NULL to use the current palette.
+ */
+void sk_read_row(BITMAP *bm, int y, uint8_t *row, int format, AL_CONST RGB *pal) {
+    st_push(ST_CONVERT);
+    sk_read_pixels(bm, y, row, format, pal);
+    st_pop();
+}
+
+/**
+ * @brief create the palette used for gray images: index i is gray value i.
+ *
+ * @param pal the palette to fill.
+ */
+void sk_gray_palette(RGB *pal) {
+    for (int i = 0; i < PAL_SIZE; i++) {
+        pal[i].r = pal[i].g = pal[i].b = i >> 2;
+    }
+}
+
+/**
+ * @brief check if a palette is the gray palette created by sk_gray_palette().
+ *
+ * @param pal the palette.
+ *
+ * @return true if pixel values are gray values.
+ */
+bool sk_is_gray(AL_CONST RGB *pal) {
+    for (int i = 0; i < PAL_SIZE; i++) {
+        if (pal[i].r != (i >> 2) || pal[i].g != (i >> 2) || pal[i].b != (i >> 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief set the palette for showing/converting 8bpp images.
+ * Allegro palettes only have 6bit per channel, for the gray palette the table blit() uses to expand 8bpp to the
+ * screen depth is replaced with the exact 8bit grays.
+ *
+ * @param pal the palette.
+ */
+void sk_set_palette(AL_CONST RGB *pal) {
+    set_palette(pal);
+
+    if ((get_color_depth() > 8) && sk_is_gray(pal)) {
+        for (int i = 0; i < PAL_SIZE; i++) {
+            palette_color[i] = makecol(i, i, i);
+        }
+    }
+}
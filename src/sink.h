@@ -0,0 +1,68 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __SINK_H__
+#define __SINK_H__
+
+#include "main.h"
+#include "tilestore.h"
+
+/************
+** defines **
+************/
+#define SK_GRAY 1  //!< row format: one byte gray per pixel
+#define SK_RGB 3   //!< row format: R, G, B bytes per pixel
+#define SK_RGBA 4  //!< row format: R, G, B, A bytes per pixel
+
+/************
+** structs **
+************/
+//! receives the decoded rows of an image and stores them in a bitmap, optionally reduced in size
+typedef struct __sink {
+    BITMAP *bm;           //!< the resulting bitmap
+    int format;           //!< format of the rows put into the sink
+    int shrink;           //!< reduction factor, every shrink x shrink block of pixels is averaged into one
+    int width;            //!< width of the decoded rows
+    int height;           //!< number of decoded rows
+    uint32_t *acc;        //!< per channel sums of the output row being collected (shrink > 1)
+    uint8_t *avg;         //!< averaged output row (shrink > 1)
+    int rows;             //!< number of decoded rows summed up in acc
+    tile_store_t *tiles;  //!< the full size rows are stored here as well or NULL
+} sink_t;
+
+/***********************
+** exported functions **
+***********************/
+extern BITMAP *sk_create_bitmap(int w, int h, RGB *pal, int format);
+extern bool sk_begin(sink_t *sk, int w, int h, RGB *pal, int format, int shrink);
+extern void sk_put_row(sink_t *sk, int y, const uint8_t *row);
+extern bool sk_progress(uint32_t done, uint32_t total);
+extern BITMAP *sk_finish(sink_t *sk);
+extern void sk_abort(sink_t *sk);
+extern BITMAP *sk_orient(BITMAP *bm, bool transpose, bool mirror_h, bool mirror_v);
+extern void sk_write_row(BITMAP *bm, int y, const uint8_t *row, int format);
+extern void sk_read_row(BITMAP *bm, int y, uint8_t *row, int format, AL_CONST RGB *pal);
+extern void sk_gray_palette(RGB *pal);
+extern bool sk_is_gray(AL_CONST RGB *pal);
+extern void sk_set_palette(AL_CONST RGB *pal);
+
+#endif  // __SINK_H__
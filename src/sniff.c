@@ -0,0 +1,270 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <ctype.h>
+#include <string.h>
+
+#include "sniff.h"
+#include "util.h"
+#include "sink.h"
+#include "alpng.h"
+#include "format-gif.h"
+#include "format-qoi.h"
+#include "format-webp.h"
+#include "format-jpeg.h"
+#include "format-tiff.h"
+#include "format-jasper.h"
+#include "format-stb.h"
+
+/************
+** structs **
+************/
+//! a format we can load
+typedef struct __sn_format {
+    const char *format;  //!< name of the format (and its usual extension)
+    sn_loader_t load;    //!< the loader
+} sn_format_t;
+
+//! other extensions that are used for a format
+typedef struct __sn_alias {
+    const char *ext;     //!< the extension
+    const char *format;  //!< name of the format
+} sn_alias_t;
+
+/************
+** globals **
+************/
+static BITMAP *sn_load_bmp(input_t *in, RGB *pal);
+static BITMAP *sn_load_pcx(input_t *in, RGB *pal);
+static BITMAP *sn_load_tga(input_t *in, RGB *pal);
+static BITMAP *sn_load_png(input_t *in, RGB *pal);
+static BITMAP *sn_load_lbm(input_t *in, RGB *pal);
+static BITMAP *sn_load_gif(input_t *in, RGB *pal);
+
+static const sn_format_t sn_formats[] = {
+    {"BMP", sn_load_bmp},    {"PCX", sn_load_pcx},    {"TGA", sn_load_tga},    {"LBM", sn_load_lbm},    {"PNG", sn_load_png},
+    {"GIF", sn_load_gif},    {"QOI", load_qoi_in},    {"WEB", load_webp_in},   {"JPG", load_jpeg_in},   {"TIF", load_tiff_in},
+    {"JP2", load_jasper_in}, {"RAS", load_jasper_in}, {"PNM", load_jasper_in}, {"PBM", load_jasper_in}, {"PGM", load_jasper_in},
+    {"PPM", load_jasper_in}, {"PSD", load_stb_in},    {"HDR", load_stb_in},    {"PIC", load_stb_in},    {NULL, NULL},
+};
+
+static const sn_alias_t sn_aliases[] = {
+    {"JPEG", "JPG"}, {"JPE", "JPG"}, {"JFIF", "JPG"}, {"TIFF", "TIF"}, {"WEBP", "WEB"}, {"J2K", "JP2"}, {"JPC", "JP2"},
+    {"JPX", "JP2"},  {"IFF", "LBM"}, {"PPT", "PPM"},  {NULL, NULL},
+};
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief load an image with one of Allegro's PACKFILE loaders, the input is wrapped into a PACKFILE.
+ *
+ * @param in the file.
+ * @param pal returns the palette of 8bpp images.
+ * @param load the loader.
+ *
+ * @return the image or NULL.
+ */
+static BITMAP *sn_load_pf(input_t *in, RGB *pal, BITMAP *(*load)(PACKFILE *f, RGB *pal)) {
+    in_seek(in, 0);
+    PACKFILE *f = in_packfile(in);
+    if (!f) {
+        return NULL;
+    }
+    BITMAP *bm = load(f, pal);
+    pack_fclose(f);
+    return bm;
+}
+
+// Allegro's and alpng's PACKFILE loaders read the input directly
+static BITMAP *sn_load_bmp(input_t *in, RGB *pal) { return sn_load_pf(in, pal, load_bmp_pf); }
+static BITMAP *sn_load_pcx(input_t *in, RGB *pal) { return sn_load_pf(in, pal, load_pcx_pf); }
+static BITMAP *sn_load_tga(input_t *in, RGB *pal) { return sn_load_pf(in, pal, load_tga_pf); }
+
+/**
+ * @brief pass alpng's inflate progress on to load_progress().
+ */
+static int sn_png_progress(unsigned long done, unsigned long total) { return sk_progress(done, total); }
+
+/**
+ * @brief load a PNG, the progress of inflating the image data is reported.
+ */
+static BITMAP *sn_load_png(input_t *in, RGB *pal) {
+    alpng_progress = sn_png_progress;
+    BITMAP *bm = sn_load_pf(in, pal, load_png_pf);
+    alpng_progress = NULL;
+    return bm;
+}
+
+// Allegro has no PACKFILE loader for LBM and algif only opens files by name, these read the file on their own
+static BITMAP *sn_load_lbm(input_t *in, RGB *pal) { return load_lbm(in->filename, pal); }
+static BITMAP *sn_load_gif(input_t *in, RGB *pal) { return load_gif8(in->filename, pal); }
+
+/**
+ * @brief identify the format by the signature at the start of the file.
+ *
+ * @param b the first bytes of the file.
+ * @param n number of bytes in b.
+ *
+ * @return name of the format or NULL if it is unknown. TGA has no signature and is never detected.
+ */
+static const char *sn_detect(const uint8_t *b, size_t n) {
+    if (n < 4) {
+        return NULL;
+    }
+
+    if ((b[0] == 0xFF) && (b[1] == 0xD8) && (b[2] == 0xFF)) {
+        return "JPG";
+    } else if ((n >= 8) && !memcmp(b, "\x89PNG\r\n\x1A\n", 8)) {
+        return "PNG";
+    } else if ((n >= 6) && (!memcmp(b, "GIF87a", 6) || !memcmp(b, "GIF89a", 6))) {
+        return "GIF";
+    } else if ((n >= 12) && !memcmp(b, "RIFF", 4) && !memcmp(&b[8], "WEBP", 4)) {
+        return "WEB";
+    } else if (!memcmp(b, "II*\0", 4) || !memcmp(b, "MM\0*", 4)) {
+        return "TIF";
+    } else if ((n >= 12) && !memcmp(b, "\0\0\0\x0CjP  \r\n\x87\n", 12)) {
+        return "JP2";
+    } else if (!memcmp(b, "\xFF\x4F\xFF\x51", 4)) {
+        return "JP2";
+    } else if (!memcmp(b, "qoif", 4)) {
+        return "QOI";
+    } else if (!memcmp(b, "8BPS", 4)) {
+        return "PSD";
+    } else if (((n >= 10) && !memcmp(b, "#?RADIANCE", 10)) || ((n >= 6) && !memcmp(b, "#?RGBE", 6))) {
+        return "HDR";
+    } else if ((n >= 92) && !memcmp(b, "\x53\x80\xF6\x34", 4) && !memcmp(&b[88], "PICT", 4)) {
+        return "PIC";
+    } else if (!memcmp(b, "\x59\xA6\x6A\x95", 4)) {
+        return "RAS";
+    } else if ((n >= 12) && !memcmp(b, "FORM", 4) && (!memcmp(&b[8], "ILBM", 4) || !memcmp(&b[8], "PBM ", 4))) {
+        return "LBM";
+    } else if ((n >= 18) && (b[0] == 'B') && (b[1] == 'M') && (b[15] == 0) && (b[16] == 0) && (b[17] == 0) &&
+               ((b[14] == 12) || (b[14] == 40) || (b[14] == 52) || (b[14] == 56) || (b[14] == 64) || (b[14] == 108) || (b[14] == 124))) {
+        // the size of the info header is checked as well, "BM" alone is too weak
+        return "BMP";
+    } else if ((b[0] == 'P') && (b[1] >= '1') && (b[1] <= '6') && isspace(b[2])) {
+        static const char *pnm[] = {"PBM", "PGM", "PPM"};
+        return pnm[(b[1] - '1') % 3];
+    } else if ((n >= 66) && (b[0] == 0x0A) && (b[1] <= 5) && (b[2] <= 1) && ((b[3] == 1) || (b[3] == 2) || (b[3] == 4) || (b[3] == 8)) &&
+               (b[64] == 0) && (b[65] >= 1) && (b[65] <= 4)) {
+        return "PCX";
+    }
+    return NULL;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief identify the format of an open file, formats without signature are taken from the extension.
+ *
+ * @param in the file, its first buffer is reused by the codec afterwards.
+ * @param s the result, the header bytes can be used instead of reading them again.
+ *
+ * @return false if the file can't be read.
+ */
+bool sn_sniff_in(input_t *in, sniff_t *s) {
+    memset(s, 0, sizeof(sniff_t));
+    in_seek(in, 0);
+    s->size = in_read(in, s->header, sizeof(s->header));
+    s->file_size = in->size;
+
+    const char *format = sn_detect(s->header, s->size);
+    if (format) {
+        s->detected = true;
+        strcpy(s->format, format);
+    } else {
+        const char *ext = ut_getFilenameExt(in->filename);
+        for (int i = 0; ext[i] && i < (int)sizeof(s->format) - 1; i++) {
+            s->format[i] = toupper((unsigned char)ext[i]);
+        }
+        for (int i = 0; sn_aliases[i].ext; i++) {
+            if (!strcmp(s->format, sn_aliases[i].ext)) {
+                strcpy(s->format, sn_aliases[i].format);
+                break;
+            }
+        }
+    }
+    DEBUGF("sniffed %s: %s%s\n", in->filename, s->format, s->detected ? "" : " (by extension)");
+    return true;
+}
+
+/**
+ * @brief read the start of a file and identify its format, formats without signature are taken from the extension.
+ *
+ * @param filename the file.
+ * @param s the result, the header bytes can be used instead of reading them again.
+ *
+ * @return false if the file can't be read.
+ */
+bool sn_sniff(const char *filename, sniff_t *s) {
+    input_t in;
+
+    if (!in_open(&in, filename)) {
+        memset(s, 0, sizeof(sniff_t));
+        return false;
+    }
+    bool ret = sn_sniff_in(&in, s);
+    in_close(&in);
+    return ret;
+}
+
+/**
+ * @brief get the loader for a format.
+ *
+ * @param format name of the format (see sniff_t).
+ *
+ * @return the loader or NULL if the format is unknown.
+ */
+sn_loader_t sn_loader(const char *format) {
+    for (int i = 0; sn_formats[i].format; i++) {
+        if (!strcmp(format, sn_formats[i].format)) {
+            return sn_formats[i].load;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief load an image with the loader for its actual format, whatever the extension says.
+ *
+ * @param filename the image file.
+ * @param pal returns the palette of 8bpp images.
+ *
+ * @return the image or NULL.
+ */
+BITMAP *sn_load(const char *filename, RGB *pal) {
+    input_t in;
+    sniff_t s;
+
+    if (!in_open(&in, filename)) {
+        return NULL;
+    }
+    BITMAP *bm = NULL;
+    if (sn_sniff_in(&in, &s)) {
+        sn_loader_t load = sn_loader(s.format);
+        bm = load ? load(&in, pal) : load_bitmap(filename, pal);
+    }
+    in_close(&in);
+    return bm;
+}
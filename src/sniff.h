@@ -0,0 +1,57 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __SNIFF_H__
+#define __SNIFF_H__
+
+#include "main.h"
+#include "input.h"
+
+/************
+** defines **
+************/
+#define SN_HEADER_SIZE 128  //!< number of bytes read from the start of the file
+
+//! an image loader reading from an input
+typedef in_loader_t sn_loader_t;
+
+/************
+** structs **
+************/
+//! the start of a file and the format detected from it
+typedef struct __sniff {
+    char format[8];                  //!< file format (e.g. "JPG"), the upper case extension if it was not detected
+    bool detected;                   //!< the format was found by its signature
+    uint8_t header[SN_HEADER_SIZE];  //!< the first bytes of the file
+    size_t size;                     //!< number of bytes in header
+    uint64_t file_size;              //!< size of the file in bytes
+} sniff_t;
+
+/***********************
+** exported functions **
+***********************/
+extern bool sn_sniff(const char *filename, sniff_t *s);
+extern bool sn_sniff_in(input_t *in, sniff_t *s);
+extern sn_loader_t sn_loader(const char *format);
+extern BITMAP *sn_load(const char *filename, RGB *pal);
+
+#endif  // __SNIFF_H__
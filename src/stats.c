@@ -0,0 +1,313 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "probe.h"
+#include "trace.h"
+#include "util.h"
+
+/************
+** defines **
+************/
+#define ST_MAGIC 0x44564D41  //!< marks heap blocks allocated through the counting wrapper, checked in debug builds
+#define ST_MAX_NESTING 8     //!< max number of nested stages
+
+/************
+** structs **
+************/
+//! header in front of every heap block, keeps the alignment of malloc()
+typedef struct __st_header {
+    uint64_t size;   //!< requested size
+    uint32_t magic;  //!< ST_MAGIC
+    uint32_t pad;    //!< keeps the header at 16 bytes on 32 and 64 bit
+} st_header_t;
+
+/************
+** globals **
+************/
+static size_t st_heap_now;   //!< bytes allocated right now
+static size_t st_heap_max;   //!< highest value of st_heap_now since st_heap_reset_peak()
+static st_report_t st_rep;   //!< the numbers collected since st_reset()
+static uint64_t st_start;    //!< time of st_reset() [us]
+static uint64_t st_last;     //!< time the current stage was entered or resumed [us]
+static int st_stack[ST_MAX_NESTING];  //!< nested stages, st_stack[st_depth - 1] is the current one
+static int st_depth;         //!< number of entries in st_stack
+
+static const char *st_names[ST_NUM_STAGES] = {"other", "probe", "decode", "convert", "scale", "cache", "encode"};
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief get the stage entered last.
+ *
+ * @return the current stage.
+ */
+static inline int st_current(void) { return st_depth ? st_stack[MIN(st_depth, ST_MAX_NESTING) - 1] : ST_OTHER; }
+
+/**
+ * @brief account for a changed heap size.
+ *
+ * @param now bytes allocated now.
+ */
+static inline void st_heap_update(size_t now) {
+    st_heap_now = now;
+    if (now > st_heap_max) {
+        st_heap_max = now;
+    }
+    if (now > st_rep.heap_peak) {
+        st_rep.heap_peak = now;
+    }
+    int stage = st_current();
+    if (now > st_rep.peak[stage]) {
+        st_rep.peak[stage] = now;
+    }
+}
+
+/**
+ * @brief get the part of a heap size above the heap in use at st_reset().
+ *
+ * @param r the report.
+ * @param heap the heap size.
+ *
+ * @return the difference in bytes, 0 if the heap was smaller.
+ */
+static unsigned long st_above_base(const st_report_t *r, size_t heap) { return (heap > r->heap_base) ? (unsigned long)(heap - r->heap_base) : 0; }
+
+/**
+ * @brief add the time since the last switch to the current stage.
+ *
+ * @return the current time [us].
+ */
+static uint64_t st_account(void) {
+    uint64_t now = ut_time_us();
+    st_rep.us[st_current()] += now - st_last;
+    st_last = now;
+    return now;
+}
+
+/***********************
+** exported functions **
+***********************/
+/*
+ * The linker redirects malloc() and friends of all objects (including the libraries) to these functions
+ * (-Wl,--wrap=malloc,...). Every block that is freed or reallocated through them must carry the header, nothing is guessed
+ * from the bytes in front of a pointer. With DJGPP the C library is linked statically and its own calls are redirected as well.
+ * A shared C library allocates with its own malloc(), so its functions that hand out heap blocks are wrapped too: strdup() is
+ * the only one used by dosview and the bundled libraries (Allegro).
+ */
+extern void *__real_malloc(size_t size);
+extern void *__real_realloc(void *ptr, size_t size);
+extern void __real_free(void *ptr);
+extern void *__wrap_malloc(size_t size);
+extern void *__wrap_calloc(size_t num, size_t size);
+extern void *__wrap_realloc(void *ptr, size_t size);
+extern void __wrap_free(void *ptr);
+extern char *__wrap_strdup(const char *str);
+
+/**
+ * @brief get the header of a block allocated by __wrap_malloc().
+ *
+ * @param ptr the block.
+ *
+ * @return the header.
+ */
+static inline st_header_t *st_header(void *ptr) {
+    st_header_t *h = (st_header_t *)ptr - 1;
+#ifdef DEBUG_ENABLED
+    if (h->magic != ST_MAGIC) {
+        DEBUGF("heap block %p was not allocated through the wrapper\n", ptr);
+        abort();
+    }
+#endif
+    return h;
+}
+
+void *__wrap_malloc(size_t size) {
+    st_header_t *h = __real_malloc(sizeof(st_header_t) + size);
+    if (!h) {
+        return NULL;
+    }
+    h->size = size;
+    h->magic = ST_MAGIC;
+    st_heap_update(st_heap_now + size);
+    return h + 1;
+}
+
+void *__wrap_calloc(size_t num, size_t size) {
+    if (size && (num > SIZE_MAX / size)) {
+        return NULL;
+    }
+    void *ptr = __wrap_malloc(num * size);
+    if (ptr) {
+        memset(ptr, 0, num * size);
+    }
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (!ptr) {
+        return __wrap_malloc(size);
+    }
+    st_header_t *h = st_header(ptr);
+    size_t old = h->size;
+    st_header_t *n = __real_realloc(h, sizeof(st_header_t) + size);
+    if (!n) {
+        return NULL;
+    }
+    n->size = size;
+    st_heap_update(st_heap_now - old + size);
+    return n + 1;
+}
+
+void __wrap_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    st_header_t *h = st_header(ptr);
+    h->magic = 0;
+    st_heap_now -= h->size;
+    __real_free(h);
+}
+
+char *__wrap_strdup(const char *str) {
+    size_t len = strlen(str) + 1;
+    char *copy = __wrap_malloc(len);
+    if (copy) {
+        memcpy(copy, str, len);
+    }
+    return copy;
+}
+
+/**
+ * @brief start collecting the numbers of a new image.
+ */
+void st_reset(void) {
+    memset(&st_rep, 0, sizeof(st_rep));
+    st_rep.heap_base = st_heap_now;
+    st_rep.heap_peak = st_heap_now;
+    st_depth = 0;
+    st_start = st_last = ut_time_us();
+}
+
+/**
+ * @brief enter a stage, must be paired with st_pop().
+ *
+ * @param stage the stage.
+ */
+void st_push(int stage) {
+    st_account();
+    TRACE_BEGIN(st_stage_name(stage));
+    if (st_depth < ST_MAX_NESTING) {
+        st_stack[st_depth] = stage;
+    }
+    st_depth++;
+    if (st_heap_now > st_rep.peak[stage]) {
+        st_rep.peak[stage] = st_heap_now;
+    }
+}
+
+/**
+ * @brief leave the stage entered last.
+ */
+void st_pop(void) {
+    st_account();
+    if (st_depth > 0) {
+        st_depth--;
+        TRACE_END(st_depth < ST_MAX_NESTING ? st_stage_name(st_stack[st_depth]) : "?");
+    }
+}
+
+/**
+ * @brief get the numbers collected since st_reset(), the time of the current stage is included.
+ *
+ * @param r the result.
+ */
+void st_get(st_report_t *r) {
+    st_rep.total = st_account() - st_start;
+    *r = st_rep;
+}
+
+/**
+ * @brief get the name of a stage.
+ *
+ * @param stage the stage.
+ *
+ * @return the name.
+ */
+const char *st_stage_name(int stage) { return (stage >= 0 && stage < ST_NUM_STAGES) ? st_names[stage] : "?"; }
+
+/**
+ * @brief print a report as table or as one JSON object per line.
+ * Heap numbers are the peak above the heap in use when the image was started.
+ *
+ * @param out the stream.
+ * @param filename the image.
+ * @param r the report.
+ * @param json true for JSON, else a table.
+ */
+void st_print(FILE *out, const char *filename, const st_report_t *r, bool json) {
+    if (json) {
+        fputs("{\"file\":", out);
+        pr_print_string(out, filename, false);
+        fprintf(out, ",\"total_ms\":%.3f,\"peak_heap\":%lu", r->total / 1000.0, st_above_base(r, r->heap_peak));
+        for (int i = 0; i < ST_NUM_STAGES; i++) {
+            fprintf(out, ",\"%s_ms\":%.3f,\"%s_heap\":%lu", st_names[i], r->us[i] / 1000.0, st_names[i],
+                    st_above_base(r, r->peak[i]));
+        }
+        fputs("}\n", out);
+    } else {
+        fprintf(out, "%-8s %10s %7s %14s\n", "stage", "time [ms]", "", "peak heap [KiB]");
+        for (int i = 0; i < ST_NUM_STAGES; i++) {
+            if (!r->us[i] && !r->peak[i]) {
+                continue;
+            }
+            fprintf(out, "%-8s %10.1f %6.1f%% %14lu\n", st_names[i], r->us[i] / 1000.0, r->us[i] * 100.0 / MAX(r->total, 1),
+                    st_above_base(r, r->peak[i]) >> 10);
+        }
+        fprintf(out, "%-8s %10.1f %6.1f%% %14lu (%lu KiB in use before)\n", "total", r->total / 1000.0, 100.0, st_above_base(r, r->heap_peak) >> 10,
+                (unsigned long)(r->heap_base >> 10));
+    }
+}
+
+/**
+ * @brief get the heap in use.
+ *
+ * @return number of bytes allocated through malloc() and friends.
+ */
+size_t st_heap_current(void) { return st_heap_now; }
+
+/**
+ * @brief get the peak heap use since st_heap_reset_peak().
+ *
+ * @return number of bytes.
+ */
+size_t st_heap_peak(void) { return st_heap_max; }
+
+/**
+ * @brief restart the peak heap measurement of st_heap_peak() at the current heap use.
+ */
+void st_heap_reset_peak(void) { st_heap_max = st_heap_now; }
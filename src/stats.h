@@ -0,0 +1,68 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+//! pipeline stages that are timed, time in a nested stage is not counted for the outer one
+typedef enum {
+    ST_OTHER = 0,  //!< everything outside of the other stages
+    ST_PROBE,      //!< reading the header and planning
+    ST_DECODE,     //!< the decoder itself
+    ST_CONVERT,    //!< storing decoded rows in the bitmap, reading rows for an encoder, color depth conversion
+    ST_SCALE,      //!< resampling
+    ST_CACHE,      //!< reading and writing the disk cache
+    ST_ENCODE,     //!< the encoder itself
+    ST_NUM_STAGES  //!< number of stages
+} st_stage_t;
+
+/************
+** structs **
+************/
+//! time and heap use of each stage since st_reset()
+typedef struct __st_report {
+    uint64_t us[ST_NUM_STAGES];  //!< time spent in each stage [us]
+    size_t peak[ST_NUM_STAGES];  //!< peak heap while in each stage [bytes]
+    uint64_t total;              //!< time since st_reset() [us]
+    size_t heap_base;            //!< heap in use at st_reset() [bytes]
+    size_t heap_peak;            //!< peak heap since st_reset() [bytes]
+} st_report_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void st_reset(void);
+extern void st_push(int stage);
+extern void st_pop(void);
+extern void st_get(st_report_t *r);
+extern const char *st_stage_name(int stage);
+extern void st_print(FILE *out, const char *filename, const st_report_t *r, bool json);
+extern size_t st_heap_current(void);
+extern size_t st_heap_peak(void);
+extern void st_heap_reset_peak(void);
+
+#endif  // __STATS_H__
@@ -0,0 +1,433 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "thumbs.h"
+#include "probe.h"
+#include "resample.h"
+#include "sniff.h"
+
+/************
+** defines **
+************/
+#define TH_MAGIC "DVT1"     //!< first bytes of every entry in the index
+#define TH_TMP_EXT "TMP"    //!< extension of the index while it is rewritten (replaces IDX, the name must stay 8.3)
+
+/************
+** structs **
+************/
+//! header of an entry in the index file, followed by the file name and the RGB pixels of the thumbnail
+typedef struct __th_header {
+    char magic[4];       //!< TH_MAGIC
+    uint32_t name_len;   //!< length of the name following the header
+    uint64_t file_size;  //!< size of the image file
+    int64_t mtime;       //!< modification time of the image file
+    uint32_t width;      //!< width of the thumbnail
+    uint32_t height;     //!< height of the thumbnail
+} th_header_t;
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief find the newest entry for a file name.
+ *
+ * @param idx the index.
+ * @param name file name without directory.
+ *
+ * @return the entry or NULL.
+ */
+static th_entry_t *th_find(th_index_t *idx, const char *name) {
+    for (int i = idx->num_entries - 1; i >= 0; i--) {
+        if (!strcmp(idx->entries[i].name, name)) {
+            return &idx->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief add an entry to the in memory table.
+ *
+ * @param idx the index.
+ * @param hdr header of the entry.
+ * @param name file name without directory.
+ * @param offset position of the pixels in the index file.
+ *
+ * @return false if there is not enough memory.
+ */
+static bool th_add(th_index_t *idx, th_header_t *hdr, const char *name, long offset) {
+    bool replaces = (th_find(idx, name) != NULL);
+    th_entry_t *e = realloc(idx->entries, (idx->num_entries + 1) * sizeof(th_entry_t));
+    if (!e) {
+        return false;
+    }
+    idx->entries = e;
+    e = &idx->entries[idx->num_entries++];
+
+    if (replaces) {
+        idx->num_stale++;
+    }
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    e->name[sizeof(e->name) - 1] = 0;
+    e->file_size = hdr->file_size;
+    e->mtime = hdr->mtime;
+    e->width = hdr->width;
+    e->height = hdr->height;
+    e->offset = offset;
+    return true;
+}
+
+/**
+ * @brief read the pixels of an entry.
+ *
+ * @param f the index file.
+ * @param w width of the thumbnail.
+ * @param h height of the thumbnail.
+ *
+ * @return a 24bpp bitmap or NULL.
+ */
+static BITMAP *th_read_pixels(FILE *f, int w, int h) {
+    BITMAP *bm = create_bitmap_ex(24, w, h);
+    if (!bm) {
+        return NULL;
+    }
+    for (int y = 0; y < h; y++) {
+        if (fread(bm->line[y], w * 3, 1, f) != 1) {
+            destroy_bitmap(bm);
+            return NULL;
+        }
+    }
+    return bm;
+}
+
+/**
+ * @brief append an entry to an index file.
+ *
+ * @param f the index file.
+ * @param hdr header of the entry.
+ * @param name file name without directory.
+ * @param bm the thumbnail (24bpp).
+ *
+ * @return the position of the pixels in the file or -1 for an error.
+ */
+static long th_write(FILE *f, th_header_t *hdr, const char *name, BITMAP *bm) {
+    if ((fwrite(hdr, sizeof(th_header_t), 1, f) != 1) || (fwrite(name, hdr->name_len, 1, f) != 1)) {
+        return -1;
+    }
+    long offset = ftell(f);
+    for (int y = 0; y < bm->h; y++) {
+        if (fwrite(bm->line[y], bm->w * 3, 1, f) != 1) {
+            return -1;
+        }
+    }
+    return offset;
+}
+
+/**
+ * @brief rewrite the index file with only the newest entry of each image that still exists.
+ * Errors are ignored, the index is only an optimization.
+ *
+ * @param idx the index.
+ */
+static void th_compact(th_index_t *idx) {
+    char tmp[TH_NAME_MAX];
+    char path[TH_NAME_MAX];
+
+    replace_extension(tmp, idx->path, TH_TMP_EXT, sizeof(tmp));
+    FILE *in = fopen(idx->path, "rb");
+    FILE *out = fopen(tmp, "wb");
+    if (!in || !out) {
+        if (in) {
+            fclose(in);
+        }
+        if (out) {
+            fclose(out);
+        }
+        return;
+    }
+
+    bool ok = true;
+    int num = 0;
+    for (int i = 0; ok && (i < idx->num_entries); i++) {
+        th_entry_t *e = &idx->entries[i];
+        struct stat st;
+        replace_filename(path, idx->path, e->name, sizeof(path));
+        if ((th_find(idx, e->name) != e) || (stat(path, &st) != 0)) {
+            continue;
+        }
+
+        // unreadable entries are dropped
+        th_header_t hdr = {TH_MAGIC, strlen(e->name), e->file_size, e->mtime, e->width, e->height};
+        BITMAP *bm = (fseek(in, e->offset, SEEK_SET) == 0) ? th_read_pixels(in, e->width, e->height) : NULL;
+        if (!bm) {
+            continue;
+        }
+        long offset = th_write(out, &hdr, e->name, bm);
+        destroy_bitmap(bm);
+        if (offset < 0) {
+            ok = false;
+        } else {
+            idx->entries[num] = *e;
+            idx->entries[num++].offset = offset;
+        }
+    }
+    fclose(in);
+    if (fclose(out) != 0) {
+        ok = false;
+    }
+
+    if (ok) {
+        remove(idx->path);
+    }
+    if (!ok || (rename(tmp, idx->path) != 0)) {
+        DEBUGF("Can't rewrite thumbnail index %s\n", idx->path);
+        remove(tmp);
+        idx->num_entries = 0;
+    } else {
+        DEBUGF("compacted %s from %d to %d entries\n", idx->path, idx->num_entries, num);
+        idx->num_entries = num;
+    }
+    idx->num_stale = 0;
+}
+
+/**
+ * @brief close the index and clean it up if too many entries were replaced.
+ *
+ * @param idx the index.
+ */
+static void th_close(th_index_t *idx) {
+    if (idx->num_stale > idx->num_entries / 2) {
+        th_compact(idx);
+    }
+    free(idx->entries);
+    th_init(idx);
+}
+
+/**
+ * @brief read the table of contents of the index in the directory of an image.
+ *
+ * @param idx the index.
+ * @param filename an image in the directory.
+ */
+static void th_open(th_index_t *idx, const char *filename) {
+    char path[TH_NAME_MAX];
+    char name[TH_NAME_MAX];
+    th_header_t hdr;
+
+    replace_filename(path, filename, TH_INDEX, sizeof(path));
+    if (!strcmp(path, idx->path)) {
+        return;
+    }
+    th_close(idx);
+    strcpy(idx->path, path);
+
+    struct stat st;
+    FILE *f = fopen(idx->path, "rb");
+    if (!f) {
+        return;
+    }
+    if (stat(idx->path, &st) != 0) {
+        fclose(f);
+        return;
+    }
+
+    // an interrupted write leaves a partial entry at the end, entries appended after it could not be read
+    bool broken = false;
+    long offset = 0;
+    while (offset < st.st_size) {
+        if ((fread(&hdr, sizeof(hdr), 1, f) != 1) || memcmp(hdr.magic, TH_MAGIC, sizeof(hdr.magic)) || (hdr.name_len >= sizeof(name)) ||
+            (fread(name, hdr.name_len, 1, f) != 1)) {
+            broken = true;
+            break;
+        }
+        name[hdr.name_len] = 0;
+        offset = ftell(f);
+        long next = offset + (long)hdr.width * hdr.height * 3;
+        if ((next > st.st_size) || (fseek(f, next, SEEK_SET) != 0) || !th_add(idx, &hdr, name, offset)) {
+            broken = true;
+            break;
+        }
+        offset = next;
+    }
+    fclose(f);
+    DEBUGF("thumbnail index %s has %d entries (%d stale)%s\n", idx->path, idx->num_entries, idx->num_stale, broken ? ", broken" : "");
+
+    if (broken) {
+        th_compact(idx);
+    }
+}
+
+/**
+ * @brief decode an image as cheaply as possible and scale it to thumbnail size.
+ * JPEGs with a large enough EXIF thumbnail are not decoded at all, the other loaders reduce while decoding
+ * (JPEG 1/8 DCT scaling, WebP scaled decode, the sink for everything else)
+ * and may skip work that only matters at full quality (see load_preview).
+ *
+ * @param filename the image file.
+ *
+ * @return a 24bpp bitmap or NULL.
+ */
+static BITMAP *th_create(const char *filename) {
+    probe_t probe;
+    PALETTE pal;
+    input_t in;
+
+    if (!in_open(&in, filename)) {
+        return NULL;
+    }
+
+    // the loader is chosen by the format found in the header, which pr_probe_in() has read already
+    int shrink = 1;
+    if (pr_probe_in(&in, &probe) && probe.width && probe.height) {
+        while (MAX(probe.width, probe.height) / (shrink * 2) >= TH_SIZE) {
+            shrink *= 2;
+        }
+    }
+
+    // thumbnails are loaded between images of the viewer, every load parameter is put back afterwards
+    int old_depth = load_depth;
+    int old_shrink = load_shrink;
+    bool old_preview = load_preview;
+    int old_quality = load_quality;
+    struct __tile_store *old_tiles = load_tiles;
+    bool (*old_scan)(BITMAP *, RGB *, bool) = load_scan;
+    bool (*old_progress)(uint32_t, uint32_t) = load_progress;
+    load_depth = 32;
+    load_shrink = shrink;
+    load_preview = true;
+    load_quality = LOAD_FAST;
+    load_tiles = NULL;
+    load_scan = NULL;
+    load_progress = NULL;
+    sn_loader_t load = sn_loader(probe.format);
+    BITMAP *bm = load ? load(&in, pal) : load_bitmap(filename, pal);
+    in_close(&in);
+    load_depth = old_depth;
+    load_shrink = old_shrink;
+    load_preview = old_preview;
+    load_quality = old_quality;
+    load_tiles = old_tiles;
+    load_scan = old_scan;
+    load_progress = old_progress;
+    if (!bm) {
+        return NULL;
+    }
+
+    int w = bm->w;
+    int h = bm->h;
+    if (w >= h) {
+        w = MIN(w, TH_SIZE);
+        h = MAX(1, bm->h * w / bm->w);
+    } else {
+        h = MIN(h, TH_SIZE);
+        w = MAX(1, bm->w * h / bm->h);
+    }
+    BITMAP *thumb = create_bitmap_ex(24, w, h);
+    if (thumb) {
+        if (bitmap_color_depth(bm) == 8) {
+            select_palette(pal);
+        }
+        rs_stretch(bm, thumb, 0, 0, bm->w, bm->h, 0, 0, w, h, RS_BOX, false);
+        if (bitmap_color_depth(bm) == 8) {
+            unselect_palette();
+        }
+    }
+    DEBUGF("thumbnail of %s: 1/%d %dx%d -> %dx%d\n", filename, shrink, bm->w, bm->h, w, h);
+    destroy_bitmap(bm);
+    return thumb;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize an empty thumbnail index, the index file is read when it is used.
+ *
+ * @param idx the index.
+ */
+void th_init(th_index_t *idx) { memset(idx, 0, sizeof(th_index_t)); }
+
+/**
+ * @brief get the thumbnail of an image from the index in its directory.
+ * Entries are keyed by name, size and modification time, so a changed image gets a new thumbnail.
+ *
+ * @param idx the index, switches to another directory if needed.
+ * @param filename the image file.
+ * @param create decode the image and add it to the index if it has no valid entry.
+ *
+ * @return a 24bpp bitmap (to be freed by the caller) or NULL if there is no thumbnail.
+ */
+BITMAP *th_get(th_index_t *idx, const char *filename, bool create) {
+    struct stat st;
+
+    if (stat(filename, &st) != 0) {
+        return NULL;
+    }
+    th_open(idx, filename);
+
+    const char *name = get_filename(filename);
+    th_entry_t *e = th_find(idx, name);
+    if (e && (e->file_size == (uint64_t)st.st_size) && (e->mtime == st.st_mtime)) {
+        BITMAP *bm = NULL;
+        FILE *f = fopen(idx->path, "rb");
+        if (f) {
+            if (fseek(f, e->offset, SEEK_SET) == 0) {
+                bm = th_read_pixels(f, e->width, e->height);
+            }
+            fclose(f);
+        }
+        if (bm || !create) {
+            return bm;
+        }
+    } else if (!create) {
+        return NULL;
+    }
+
+    BITMAP *bm = th_create(filename);
+    if (!bm) {
+        return NULL;
+    }
+
+    // errors are ignored, the index is only an optimization
+    th_header_t hdr = {TH_MAGIC, strlen(name), st.st_size, st.st_mtime, bm->w, bm->h};
+    FILE *f = fopen(idx->path, "ab");
+    if (f) {
+        long offset = th_write(f, &hdr, name, bm);
+        if ((fclose(f) == 0) && (offset >= 0)) {
+            th_add(idx, &hdr, name, offset);
+        } else {
+            DEBUGF("Can't write thumbnail index %s\n", idx->path);
+        }
+    }
+    return bm;
+}
+
+/**
+ * @brief close the index.
+ *
+ * @param idx the index.
+ */
+void th_exit(th_index_t *idx) { th_close(idx); }
@@ -0,0 +1,63 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __THUMBS_H__
+#define __THUMBS_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#define TH_SIZE 96                //!< max width/height of a thumbnail
+#define TH_INDEX "DOSVIEW.IDX"    //!< name of the thumbnail index in each directory
+#define TH_NAME_MAX 260           //!< max length of a file name in the index
+
+/************
+** structs **
+************/
+//! a thumbnail in the index file
+typedef struct __th_entry {
+    char name[TH_NAME_MAX];  //!< file name without directory
+    uint64_t file_size;      //!< size of the image file
+    int64_t mtime;           //!< modification time of the image file
+    int width;               //!< width of the thumbnail
+    int height;              //!< height of the thumbnail
+    long offset;             //!< position of the pixels in the index file
+} th_entry_t;
+
+//! the thumbnail index of a directory
+typedef struct __th_index {
+    char path[TH_NAME_MAX];  //!< path of the index file
+    th_entry_t *entries;     //!< all entries, newer entries for the same name come later
+    int num_entries;         //!< number of entries
+    int num_stale;           //!< number of entries replaced by newer ones
+} th_index_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void th_init(th_index_t *idx);
+extern BITMAP *th_get(th_index_t *idx, const char *filename, bool create);
+extern void th_exit(th_index_t *idx);
+
+#endif  // __THUMBS_H__
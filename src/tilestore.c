@@ -0,0 +1,396 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <limits.h>
+
+#include "tilestore.h"
+#include "mipmap.h"
+#include "sink.h"
+
+/************
+** defines **
+************/
+#define TS_MIN_SLOTS 8  //!< tiles needed in memory besides one row of level 0 tiles
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief write a tile back to the swap file if it was changed.
+ *
+ * @param ts the tile store.
+ * @param s the slot holding the tile.
+ */
+static void ts_flush(tile_store_t *ts, ts_slot_t *s) {
+    if (!s->dirty) {
+        return;
+    }
+    s->dirty = false;
+
+    if (fseek(ts->swap, s->tile * ts->tile_bytes, SEEK_SET) != 0) {
+        ts->error = true;
+        return;
+    }
+    int line_bytes = ts->tile_bytes / TS_TILE_SIZE;
+    for (int y = 0; y < TS_TILE_SIZE; y++) {
+        if (fwrite(s->bm->line[y], line_bytes, 1, ts->swap) != 1) {
+            DEBUGF("Can't write tile %d\n", s->tile);
+            ts->error = true;
+            return;
+        }
+    }
+    ts->stored[s->tile] = 1;
+    ts->writes++;
+}
+
+/**
+ * @brief read a tile from the swap file, tiles that were never written are black.
+ *
+ * @param ts the tile store.
+ * @param s the slot to read the tile into.
+ */
+static void ts_fetch(tile_store_t *ts, ts_slot_t *s) {
+    if (!ts->stored[s->tile]) {
+        clear_to_color(s->bm, 0);
+        return;
+    }
+
+    if (fseek(ts->swap, s->tile * ts->tile_bytes, SEEK_SET) != 0) {
+        ts->error = true;
+        clear_to_color(s->bm, 0);
+        return;
+    }
+    int line_bytes = ts->tile_bytes / TS_TILE_SIZE;
+    for (int y = 0; y < TS_TILE_SIZE; y++) {
+        if (fread(s->bm->line[y], line_bytes, 1, ts->swap) != 1) {
+            DEBUGF("Can't read tile %d\n", s->tile);
+            ts->error = true;
+            clear_to_color(s->bm, 0);
+            return;
+        }
+    }
+    ts->reads++;
+}
+
+/**
+ * @brief find the slot holding a tile. If it is not in memory the least recently used slot is written back and reused.
+ * The pixels of a reused slot are undefined.
+ *
+ * @param ts the tile store.
+ * @param tile the tile index.
+ * @param cached returns true if the tile was already in memory.
+ *
+ * @return the slot or NULL if out of memory.
+ */
+static ts_slot_t *ts_slot(tile_store_t *ts, int tile, bool *cached) {
+    ts->use_count++;
+
+    if (ts->slot_of[tile] >= 0) {
+        ts_slot_t *s = &ts->slots[ts->slot_of[tile]];
+        s->last_use = ts->use_count;
+        *cached = true;
+        return s;
+    }
+    *cached = false;
+
+    // prefer empty slots, else the one unused for the longest time
+    int best = 0;
+    for (int i = 0; i < ts->num_slots; i++) {
+        if (ts->slots[i].tile < 0) {
+            best = i;
+            break;
+        }
+        if (ts->slots[i].last_use < ts->slots[best].last_use) {
+            best = i;
+        }
+    }
+
+    ts_slot_t *s = &ts->slots[best];
+    if (s->tile >= 0) {
+        ts_flush(ts, s);
+        ts->slot_of[s->tile] = -1;
+        s->tile = -1;
+    }
+    if (!s->bm) {
+        s->bm = create_bitmap_ex(ts->depth, TS_TILE_SIZE, TS_TILE_SIZE);
+        if (!s->bm) {
+            DEBUGF("Can't create tile: %s\n", allegro_error);
+            return NULL;
+        }
+    }
+
+    s->tile = tile;
+    s->last_use = ts->use_count;
+    s->dirty = false;
+    ts->slot_of[tile] = s - ts->slots;
+    return s;
+}
+
+/**
+ * @brief get a tile. Tiles of reduced levels are created from the four tiles below them on first use.
+ * The bitmap is only valid until the next call into the tile store.
+ *
+ * @param ts the tile store.
+ * @param level the pyramid level.
+ * @param tx tile column.
+ * @param ty tile row.
+ * @param write the caller is going to change the tile.
+ *
+ * @return the tile bitmap or NULL if out of memory.
+ */
+static BITMAP *ts_get_tile(tile_store_t *ts, int level, int tx, int ty, bool write) {
+    int tile = ts->first_tile[level] + ty * ts->tiles_x[level] + tx;
+    bool cached;
+
+    if ((level > 0) && !ts->stored[tile] && (ts->slot_of[tile] < 0)) {
+        // reduce the four tiles below first, getting them may evict any slot
+        BITMAP *part[4] = {NULL, NULL, NULL, NULL};
+        for (int q = 0; q < 4; q++) {
+            int cx = tx * 2 + (q & 1);
+            int cy = ty * 2 + (q >> 1);
+            if ((cx < ts->tiles_x[level - 1]) && (cy < ts->tiles_y[level - 1])) {
+                BITMAP *child = ts_get_tile(ts, level - 1, cx, cy, false);
+                if (child) {
+                    part[q] = mm_reduce(child, ts->gray);
+                }
+            }
+        }
+
+        ts_slot_t *s = ts_slot(ts, tile, &cached);
+        if (s) {
+            clear_to_color(s->bm, 0);
+            s->dirty = true;
+        }
+        for (int q = 0; q < 4; q++) {
+            if (part[q]) {
+                if (s) {
+                    blit(part[q], s->bm, 0, 0, (q & 1) * TS_TILE_SIZE / 2, (q >> 1) * TS_TILE_SIZE / 2, part[q]->w, part[q]->h);
+                }
+                destroy_bitmap(part[q]);
+            }
+        }
+        return s ? s->bm : NULL;
+    }
+
+    ts_slot_t *s = ts_slot(ts, tile, &cached);
+    if (!s) {
+        return NULL;
+    }
+    if (!cached) {
+        ts_fetch(ts, s);
+    }
+    if (write) {
+        s->dirty = true;
+    }
+    return s->bm;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize an empty tile store, nothing is allocated until ts_begin().
+ *
+ * @param ts the tile store.
+ * @param cache_bytes memory that may be used to keep tiles in memory.
+ */
+void ts_init(tile_store_t *ts, uint64_t cache_bytes) {
+    memset(ts, 0, sizeof(tile_store_t));
+    ts->cache_bytes = cache_bytes;
+}
+
+/**
+ * @brief get the memory needed to store an image into a tile store without thrashing.
+ * Rows are written from top to bottom, so a complete row of tiles must fit into memory.
+ *
+ * @param width width of the image.
+ * @param depth color depth of the tiles.
+ *
+ * @return bytes.
+ */
+uint64_t ts_min_cache(int width, int depth) {
+    uint64_t tile_bytes = (uint64_t)TS_TILE_SIZE * TS_TILE_SIZE * ((depth + 7) / 8);
+    return ((width + TS_TILE_SIZE - 1) / TS_TILE_SIZE + TS_MIN_SLOTS) * tile_bytes;
+}
+
+/**
+ * @brief create the swap file and the tile cache for an image.
+ *
+ * @param ts the tile store.
+ * @param width width of the image.
+ * @param height height of the image.
+ * @param depth color depth of the tiles.
+ * @param gray 8bpp pixels are gray values (see sk_gray_palette()).
+ *
+ * @return true for success.
+ */
+bool ts_begin(tile_store_t *ts, int width, int height, int depth, bool gray) {
+    ts->width = width;
+    ts->height = height;
+    ts->depth = depth;
+    ts->gray = gray;
+    ts->tile_bytes = (long)TS_TILE_SIZE * TS_TILE_SIZE * ((depth + 7) / 8);
+
+    // levels down to the one that fits into a single tile
+    int w = width;
+    int h = height;
+    ts->num_tiles = 0;
+    ts->num_levels = 0;
+    while (ts->num_levels < TS_MAX_LEVELS) {
+        int l = ts->num_levels++;
+        ts->level_w[l] = w;
+        ts->level_h[l] = h;
+        ts->tiles_x[l] = (w + TS_TILE_SIZE - 1) / TS_TILE_SIZE;
+        ts->tiles_y[l] = (h + TS_TILE_SIZE - 1) / TS_TILE_SIZE;
+        ts->first_tile[l] = ts->num_tiles;
+        ts->num_tiles += ts->tiles_x[l] * ts->tiles_y[l];
+        if (w <= TS_TILE_SIZE && h <= TS_TILE_SIZE) {
+            break;
+        }
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    if ((uint64_t)ts->num_tiles * ts->tile_bytes > LONG_MAX) {
+        DEBUGF("Image too large for swap file\n");
+        return false;
+    }
+
+    ts->num_slots = MAX(ts->cache_bytes / ts->tile_bytes, ts_min_cache(width, depth) / ts->tile_bytes);
+    ts->num_slots = MIN(ts->num_slots, ts->num_tiles);
+    DEBUGF("tile store %dx%dx%d: %d levels, %d tiles, %d slots\n", width, height, depth, ts->num_levels, ts->num_tiles, ts->num_slots);
+
+    ts->slot_of = malloc(ts->num_tiles * sizeof(int));
+    ts->stored = calloc(ts->num_tiles, 1);
+    ts->slots = calloc(ts->num_slots, sizeof(ts_slot_t));
+    ts->pad = malloc(TS_TILE_SIZE * SK_RGBA);
+    if (!ts->slot_of || !ts->stored || !ts->slots || !ts->pad) {
+        ts_exit(ts);
+        return false;
+    }
+    for (int i = 0; i < ts->num_tiles; i++) {
+        ts->slot_of[i] = -1;
+    }
+    for (int i = 0; i < ts->num_slots; i++) {
+        ts->slots[i].tile = -1;
+    }
+
+    ts->swap = tmpfile();
+    if (!ts->swap) {
+        DEBUGF("Can't create swap file\n");
+        ts_exit(ts);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief store a decoded row of the full size image.
+ * The last column and row are repeated up to the tile border so reduced levels don't get dark edges.
+ *
+ * @param ts the tile store.
+ * @param y the row.
+ * @param row the pixels, width pixels in 'format'.
+ * @param format SK_GRAY, SK_RGB or SK_RGBA.
+ */
+void ts_put_row(tile_store_t *ts, int y, const uint8_t *row, int format) {
+    int ty = y / TS_TILE_SIZE;
+    int last = (y == ts->height - 1) ? TS_TILE_SIZE - 1 : y % TS_TILE_SIZE;
+
+    for (int tx = 0; tx < ts->tiles_x[0]; tx++) {
+        const uint8_t *src = &row[tx * TS_TILE_SIZE * format];
+        int n = MIN(TS_TILE_SIZE, ts->width - tx * TS_TILE_SIZE);
+        if (n < TS_TILE_SIZE) {
+            memcpy(ts->pad, src, n * format);
+            for (int x = n; x < TS_TILE_SIZE; x++) {
+                memcpy(&ts->pad[x * format], &src[(n - 1) * format], format);
+            }
+            src = ts->pad;
+        }
+
+        BITMAP *tile = ts_get_tile(ts, 0, tx, ty, true);
+        if (tile) {
+            for (int ly = y % TS_TILE_SIZE; ly <= last; ly++) {
+                sk_write_row(tile, ly, src, format);
+            }
+        }
+    }
+}
+
+/**
+ * @brief copy an area of a level into a new bitmap.
+ *
+ * @param ts the tile store.
+ * @param level the pyramid level.
+ * @param x left column of the area in level coordinates.
+ * @param y top row of the area.
+ * @param w width of the area.
+ * @param h height of the area.
+ *
+ * @return a new bitmap, NULL if out of memory.
+ */
+BITMAP *ts_read_area(tile_store_t *ts, int level, int x, int y, int w, int h) {
+    BITMAP *bm = create_bitmap_ex(ts->depth, w, h);
+    if (!bm) {
+        DEBUGF("Can't create %dx%d area: %s\n", w, h, allegro_error);
+        return NULL;
+    }
+
+    int tx_end = MIN(ts->tiles_x[level], (x + w + TS_TILE_SIZE - 1) / TS_TILE_SIZE);
+    int ty_end = MIN(ts->tiles_y[level], (y + h + TS_TILE_SIZE - 1) / TS_TILE_SIZE);
+    for (int ty = y / TS_TILE_SIZE; ty < ty_end; ty++) {
+        for (int tx = x / TS_TILE_SIZE; tx < tx_end; tx++) {
+            BITMAP *tile = ts_get_tile(ts, level, tx, ty, false);
+            if (tile) {
+                blit(tile, bm, 0, 0, tx * TS_TILE_SIZE - x, ty * TS_TILE_SIZE - y, TS_TILE_SIZE, TS_TILE_SIZE);
+            }
+        }
+    }
+    return bm;
+}
+
+/**
+ * @brief free all memory and delete the swap file.
+ *
+ * @param ts the tile store.
+ */
+void ts_exit(tile_store_t *ts) {
+    if (ts->swap) {
+        fclose(ts->swap);
+        ts->swap = NULL;
+    }
+    if (ts->slots) {
+        for (int i = 0; i < ts->num_slots; i++) {
+            if (ts->slots[i].bm) {
+                destroy_bitmap(ts->slots[i].bm);
+            }
+        }
+        free(ts->slots);
+        ts->slots = NULL;
+    }
+    free(ts->slot_of);
+    free(ts->stored);
+    free(ts->pad);
+    ts->slot_of = NULL;
+    ts->stored = NULL;
+    ts->pad = NULL;
+    ts->num_levels = 0;
+}
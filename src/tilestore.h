@@ -0,0 +1,82 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __TILESTORE_H__
+#define __TILESTORE_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#define TS_TILE_SIZE 128  //!< width and height of a tile in pixels
+#define TS_MAX_LEVELS 16  //!< max number of levels in the tile pyramid
+
+/************
+** structs **
+************/
+//! a tile held in memory
+typedef struct __ts_slot {
+    BITMAP *bm;         //!< the pixels or NULL if the slot was never used
+    int tile;           //!< index of the tile held by this slot, -1 if empty
+    uint32_t last_use;  //!< value of the use counter when the tile was last accessed
+    bool dirty;         //!< the tile was changed since it was read from the swap file
+} ts_slot_t;
+
+//! an image kept in fixed size tiles in a swap file, with a pyramid of reduced levels created on demand
+typedef struct __tile_store {
+    FILE *swap;                      //!< the swap file, NULL until ts_begin() was called
+    int width;                       //!< width of the image (level 0)
+    int height;                      //!< height of the image (level 0)
+    int depth;                       //!< color depth of the tiles
+    bool gray;                       //!< 8bpp pixels are gray values, not palette indices
+    int num_levels;                  //!< number of levels in the pyramid
+    int level_w[TS_MAX_LEVELS];      //!< width of each level in pixels
+    int level_h[TS_MAX_LEVELS];      //!< height of each level in pixels
+    int tiles_x[TS_MAX_LEVELS];      //!< number of tile columns of each level
+    int tiles_y[TS_MAX_LEVELS];      //!< number of tile rows of each level
+    int first_tile[TS_MAX_LEVELS];   //!< index of the first tile of each level
+    int num_tiles;                   //!< number of tiles in all levels
+    long tile_bytes;                 //!< size of one tile in the swap file
+    int *slot_of;                    //!< slot holding each tile or -1
+    uint8_t *stored;                 //!< flag for each tile: it has valid pixels in the swap file
+    uint8_t *pad;                    //!< row buffer for the tiles at the right border
+    uint64_t cache_bytes;            //!< memory that may be used for tiles
+    ts_slot_t *slots;                //!< the tile cache
+    int num_slots;                   //!< number of entries in slots
+    uint32_t use_count;              //!< incremented on every tile access (LRU)
+    uint32_t reads;                  //!< number of tiles read from the swap file
+    uint32_t writes;                 //!< number of tiles written to the swap file
+    bool error;                      //!< an I/O error happened, tiles may be missing
+} tile_store_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void ts_init(tile_store_t *ts, uint64_t cache_bytes);
+extern uint64_t ts_min_cache(int width, int depth);
+extern bool ts_begin(tile_store_t *ts, int width, int height, int depth, bool gray);
+extern void ts_put_row(tile_store_t *ts, int y, const uint8_t *row, int format);
+extern BITMAP *ts_read_area(tile_store_t *ts, int level, int x, int y, int w, int h);
+extern void ts_exit(tile_store_t *ts);
+
+#endif  // __TILESTORE_H__
@@ -0,0 +1,191 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/*
+ * Writes begin/end events in the Chrome trace event format (chrome://tracing, Perfetto, speedscope).
+ * Events are time stamped with the CPU cycle counter where there is one and kept in memory, they are only written
+ * to the file when the buffer is full and at exit. Everything here is compiled out unless TRACE_ENABLED is defined.
+ */
+#ifdef TRACE_ENABLED
+
+#include <stdlib.h>
+
+#include "trace.h"
+#include "util.h"
+
+/************
+** defines **
+************/
+#define TR_MAX_EVENTS 16384    //!< events buffered before they are written
+#define TR_CALIBRATE 20000     //!< time used to measure the cycle counter frequency [us]
+
+/************
+** structs **
+************/
+//! one begin or end event
+typedef struct __tr_event {
+    const char *name;  //!< name of the event
+    uint64_t ticks;    //!< time stamp in cycles (or us without cycle counter)
+    int32_t arg;       //!< argument, -1 for none
+    char phase;        //!< 'B' or 'E'
+} tr_event_t;
+
+/************
+** globals **
+************/
+static FILE *tr_file;             //!< the trace file or NULL
+static tr_event_t *tr_events;     //!< buffered events
+static int tr_num_events;         //!< number of buffered events
+static bool tr_first = true;      //!< no event written yet (no comma needed)
+static bool tr_have_tsc;          //!< rdtsc can be used
+static uint64_t tr_start;         //!< ticks at tr_open()
+static double tr_ticks_per_us;    //!< cycle counter frequency [MHz]
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief read the time stamp.
+ *
+ * @return CPU cycles if there is a cycle counter, else us.
+ */
+static inline uint64_t tr_ticks(void) {
+#if defined(__i386__) || defined(__x86_64__)
+    if (tr_have_tsc) {
+        uint32_t lo, hi;
+        __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+        return ((uint64_t)hi << 32) | lo;
+    }
+#endif
+    return ut_time_us();
+}
+
+/**
+ * @brief check for a cycle counter and measure its frequency.
+ */
+static void tr_calibrate(void) {
+#if defined(__DJGPP__)
+    // every Pentium has one, 386/486 don't
+    check_cpu();
+    tr_have_tsc = (cpu_family >= 5);
+#elif defined(__i386__) || defined(__x86_64__)
+    tr_have_tsc = true;
+#endif
+    tr_ticks_per_us = 1.0;
+    if (tr_have_tsc) {
+        uint64_t us = ut_time_us();
+        uint64_t ticks = tr_ticks();
+        uint64_t elapsed;
+        while ((elapsed = ut_time_us() - us) < TR_CALIBRATE) {
+        }
+        tr_ticks_per_us = (double)(tr_ticks() - ticks) / elapsed;
+    }
+    DEBUGF("trace clock: %s, %.1f ticks/us\n", tr_have_tsc ? "rdtsc" : "uclock", tr_ticks_per_us);
+}
+
+/**
+ * @brief write all buffered events to the file.
+ */
+static void tr_flush(void) {
+    for (int i = 0; i < tr_num_events; i++) {
+        tr_event_t *e = &tr_events[i];
+        fprintf(tr_file, "%s{\"name\":\"%s\",\"cat\":\"dosview\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1", tr_first ? "" : ",\n", e->name, e->phase,
+                (e->ticks - tr_start) / tr_ticks_per_us);
+        if (e->arg >= 0) {
+            fprintf(tr_file, ",\"args\":{\"n\":%ld}", (long)e->arg);
+        }
+        fputc('}', tr_file);
+        tr_first = false;
+    }
+    tr_num_events = 0;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief start writing a trace file, it is completed at exit.
+ *
+ * @param filename the file.
+ *
+ * @return true for success.
+ */
+bool tr_open(const char *filename) {
+    tr_events = malloc(TR_MAX_EVENTS * sizeof(tr_event_t));
+    if (!tr_events) {
+        return false;
+    }
+    tr_file = fopen(filename, "w");
+    if (!tr_file) {
+        free(tr_events);
+        tr_events = NULL;
+        return false;
+    }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", tr_file);
+    tr_calibrate();
+    tr_start = tr_ticks();
+    atexit(tr_close);
+    return true;
+}
+
+/**
+ * @brief record an event, use the TRACE_xxx() macros.
+ *
+ * @param name name of the event, must be a string constant.
+ * @param phase 'B' for begin or 'E' for end.
+ * @param arg a number shown with the event or -1.
+ */
+void tr_event(const char *name, char phase, int arg) {
+    if (!tr_file) {
+        return;
+    }
+    if (tr_num_events >= TR_MAX_EVENTS) {
+        // the time needed for writing is visible in the trace
+        uint64_t start = tr_ticks();
+        tr_flush();
+        tr_events[tr_num_events++] = (tr_event_t){"trace flush", start, -1, 'B'};
+        tr_events[tr_num_events++] = (tr_event_t){"trace flush", tr_ticks(), -1, 'E'};
+    }
+    tr_event_t *e = &tr_events[tr_num_events++];
+    e->name = name;
+    e->phase = phase;
+    e->arg = arg;
+    e->ticks = tr_ticks();
+}
+
+/**
+ * @brief write the remaining events and close the file.
+ */
+void tr_close(void) {
+    if (!tr_file) {
+        return;
+    }
+    tr_flush();
+    fputs("\n]}\n", tr_file);
+    fclose(tr_file);
+    tr_file = NULL;
+    free(tr_events);
+    tr_events = NULL;
+}
+
+#endif  // TRACE_ENABLED
@@ -0,0 +1,57 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "main.h"
+
+/************
+** defines **
+************/
+#ifdef TRACE_ENABLED
+//! start a scoped event, name must be a string constant
+#define TRACE_BEGIN(name) tr_event(name, 'B', -1)
+
+//! start a scoped event with a number shown as argument (row, offset, size...)
+#define TRACE_BEGIN_ARG(name, arg) tr_event(name, 'B', arg)
+
+//! end the event started last with the same name
+#define TRACE_END(name) tr_event(name, 'E', -1)
+
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_BEGIN_ARG(name, arg)
+#define TRACE_END(name)
+#endif
+
+/***********************
+** exported functions **
+***********************/
+#ifdef TRACE_ENABLED
+extern bool tr_open(const char *filename);
+extern void tr_event(const char *name, char phase, int arg);
+extern void tr_close(void);
+#endif
+
+#endif  // __TRACE_H__
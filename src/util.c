@@ -24,6 +24,7 @@ SOFTWARE.
 
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 
 /***********************
 ** exported functions **
@@ -154,3 +155,19 @@ bool ut_read_file(const char *fname, void **buf, size_t *size) {
     *size = n;
     return true;
 }
+
+/**
+ * @brief get a monotonic timestamp with the best resolution available.
+ * DJGPP uses uclock() (~0.8us resolution), everything else clock_gettime().
+ *
+ * @return the current time in microseconds.
+ */
+uint64_t ut_time_us(void) {
+#ifdef __DJGPP__
+    return (uint64_t)uclock() * 1000000ULL / UCLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#endif
+}
@@ -33,5 +33,6 @@ extern const char *ut_getFilenameExt(const char *filename);
 extern bool ut_file_exists(const char *filename);
 extern bool ut_read_file(const char *fname, void **buf, size_t *size);
 extern char *ut_clone_string(const char *str);
+extern uint64_t ut_time_us(void);
 
 #endif  // __UTIL_H__
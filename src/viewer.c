@@ -0,0 +1,811 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "viewer.h"
+#include "display.h"
+#include "resample.h"
+#include "util.h"
+#include "trace.h"
+
+/************
+** defines **
+************/
+#define MIN_ZOOM 100        //!< the image is never scaled below 1/MIN_ZOOM of the screen size
+#define FRAME_BUDGET 50000  //!< max time [us] spent collecting queued keys before the next frame is drawn
+#define CACHE_BAND 32       //!< number of screen lines rendered into the cache between keyboard checks
+#define TILE_PAD 8          //!< pixels read from the tile store around an area for the resampling filter
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief convert an image coordinate to a coordinate in the scaled image.
+ *
+ * @param factor zoom factor.
+ * @param pos image coordinate.
+ *
+ * @return the scaled coordinate.
+ */
+static inline int vw_scaled(float factor, int pos) { return (int)(pos * factor); }
+
+/**
+ * @brief calculate the visible part of the scaled image and where it goes on screen.
+ *
+ * @param v the view.
+ * @param vis visible rectangle in scaled image coordinates (x, y, w, h).
+ * @param dest top left corner of the visible rectangle on screen (x, y).
+ */
+static void vw_visible(view_t *v, int vis[4], int dest[2]) {
+    if (v->scaled_width <= v->screen_width) {
+        DEBUG("W1\n");
+        vis[0] = 0;
+        vis[2] = v->scaled_width;
+        dest[0] = (v->screen_width / 2 - v->scaled_width / 2);
+    } else {
+        DEBUG("W2\n");
+        vis[0] = vw_scaled(v->factor, v->x_start);
+        vis[2] = v->screen_width;
+        dest[0] = 0;
+    }
+
+    if (v->scaled_height <= v->screen_height) {
+        DEBUG("H1\n");
+        vis[1] = 0;
+        vis[3] = v->scaled_height;
+        dest[1] = (v->screen_height / 2 - v->scaled_height / 2);
+    } else {
+        DEBUG("H2\n");
+        vis[1] = vw_scaled(v->factor, v->y_start);
+        vis[3] = v->screen_height;
+        dest[1] = 0;
+    }
+}
+
+/**
+ * @brief calculate the image area around the visible part, extended by 'margin' screen pixels on each side.
+ *
+ * @param v the view.
+ * @param margin margin in screen pixels.
+ * @param src image area (x, y, w, h).
+ */
+static void vw_source_area(view_t *v, int margin, int src[4]) {
+    if (v->scaled_width <= v->screen_width) {
+        src[0] = 0;
+        src[2] = v->width;
+    } else {
+        int x_end = MIN(v->width, v->x_start + (int)((v->screen_width + margin) / v->factor) + 2);
+        src[0] = MAX(0, v->x_start - (int)(margin / v->factor) - 1);
+        src[2] = x_end - src[0];
+    }
+
+    if (v->scaled_height <= v->screen_height) {
+        src[1] = 0;
+        src[3] = v->height;
+    } else {
+        int y_end = MIN(v->height, v->y_start + (int)((v->screen_height + margin) / v->factor) + 2);
+        src[1] = MAX(0, v->y_start - (int)(margin / v->factor) - 1);
+        src[3] = y_end - src[1];
+    }
+}
+
+/**
+ * @brief draw part of the image scaled by 'factor' into a bitmap.
+ * Every image row y always ends up at the scaled position vw_scaled(y) - vw_scaled(src[1]), no matter how the area is split into bands.
+ * When zoomed out the pixels are taken from the matching level of the image pyramid. Levels with more resolution than the overview
+ * of a tiled image are read from the tile store.
+ * Everything outside dst is clipped. The resampler reads pixels around the area, so bands scaled with a filter fit together without seams.
+ *
+ * @param v the view.
+ * @param dst destination bitmap.
+ * @param factor zoom factor.
+ * @param src image area (x, y, w, h).
+ * @param dest_x x position of the top left corner of the area in dst.
+ * @param dest_y y position of the top left corner of the area in dst.
+ * @param first first image row to draw.
+ * @param last last image row (exclusive) to draw.
+ * @param filter resampling filter.
+ */
+static void vw_draw_scaled(view_t *v, BITMAP *dst, float factor, int src[4], int dest_x, int dest_y, int first, int last, int filter) {
+    // use the smallest pyramid level that still has enough resolution, so the cost depends on the screen and not on the image size
+    float base_factor = factor * (1 << v->base_level);
+    int level = mm_select_level(&v->mipmap, base_factor);
+    BITMAP *lvl = NULL;
+    int lvl_w, lvl_h;
+    if (v->tiles && (level == 0) && (base_factor > 1.0f)) {
+        // the overview would be enlarged, use the tile store instead
+        while ((level + 1 < v->base_level) && (factor * (1 << (level + 1)) <= 1.0f)) {
+            level++;
+        }
+        lvl_w = v->tiles->level_w[level];
+        lvl_h = v->tiles->level_h[level];
+    } else {
+        lvl = mm_get_level(&v->mipmap, &level);
+        level += v->base_level;
+        lvl_w = lvl->w;
+        lvl_h = lvl->h;
+    }
+    v->mipmap_level = level;
+
+    // the area in level coordinates, rounded outwards
+    int x0 = src[0] >> level;
+    int x1 = MIN(lvl_w, (src[0] + src[2] + (1 << level) - 1) >> level);
+    int y0 = first >> level;
+    int y1 = MIN(lvl_h, (last + (1 << level) - 1) >> level);
+
+    // map the level area back to image coordinates to find where it goes
+    int dx0 = vw_scaled(factor, x0 << level) - vw_scaled(factor, src[0]);
+    int dx1 = vw_scaled(factor, MIN(v->width, x1 << level)) - vw_scaled(factor, src[0]);
+    int dy0 = vw_scaled(factor, y0 << level) - vw_scaled(factor, src[1]);
+    int dy1 = vw_scaled(factor, MIN(v->height, y1 << level)) - vw_scaled(factor, src[1]);
+
+    if (x1 <= x0 || y1 <= y0 || dx1 <= dx0 || dy1 <= dy0) {
+        return;
+    }
+
+    // copy the area from the tiles, with the pixels around it the filter needs to blend seamlessly with the neighbouring bands
+    BITMAP *area = NULL;
+    int sx = x0;
+    int sy = y0;
+    if (!lvl) {
+        int ax = MAX(0, x0 - TILE_PAD);
+        int ay = MAX(0, y0 - TILE_PAD);
+        area = ts_read_area(v->tiles, level, ax, ay, MIN(lvl_w, x1 + TILE_PAD) - ax, MIN(lvl_h, y1 + TILE_PAD) - ay);
+        if (!area) {
+            return;
+        }
+        lvl = area;
+        sx -= ax;
+        sy -= ay;
+    }
+
+    DEBUGF("rs_stretch(L%d: %d, %d, %d, %d ==> %d, %d, %d, %d, %s)\n", level, x0, y0, x1 - x0, y1 - y0, dest_x + dx0, dest_y + dy0, dx1 - dx0, dy1 - dy0, rs_filter_name(filter));
+    if (!rs_stretch(lvl, dst, sx, sy, x1 - x0, y1 - y0, dest_x + dx0, dest_y + dy0, dx1 - dx0, dy1 - dy0, filter, v->linear)) {
+        // not enough memory for the filter tables, nearest neighbour needs none
+        stretch_blit(lvl, dst, sx, sy, x1 - x0, y1 - y0, dest_x + dx0, dest_y + dy0, dx1 - dx0, dy1 - dy0);
+    }
+
+    if (area) {
+        destroy_bitmap(area);
+    }
+}
+
+/**
+ * @brief check if the cache holds the visible part of the image at the current zoom factor.
+ *
+ * @param v the view.
+ * @param vis visible rectangle in scaled image coordinates.
+ * @param pos returns the position of the visible rectangle inside the cache bitmap.
+ *
+ * @return true if the cache can be used to draw the view.
+ */
+static bool vw_cache_covers(view_t *v, int vis[4], int pos[2]) {
+    view_cache_t *c = &v->cache;
+
+    if (!c->bm || (c->factor != v->factor) || (c->filter != v->filter)) {
+        return false;
+    }
+
+    pos[0] = vis[0] - vw_scaled(c->factor, c->src[0]);
+    pos[1] = vis[1] - vw_scaled(c->factor, c->src[1]);
+
+    return (pos[0] >= 0) && (pos[1] >= 0) && (pos[0] + vis[2] <= c->bm->w) && (pos[1] + vis[3] <= c->bm->h);
+}
+
+/**
+ * @brief check if the cache should be refilled, i.e. it is missing/outdated or the view is close to its border.
+ * Without margin the cache is only used to show the visible area with the resampling filter.
+ *
+ * @param v the view.
+ *
+ * @return true if the cache should be refilled.
+ */
+static bool vw_cache_stale(view_t *v) {
+    view_cache_t *c = &v->cache;
+    int vis[4], dest[2], pos[2];
+
+    if ((v->cache_margin <= 0) && (v->filter == RS_NEAREST)) {
+        return false;
+    }
+
+    vw_visible(v, vis, dest);
+    if (!vw_cache_covers(v, vis, pos)) {
+        return true;
+    }
+
+    // only care about borders where there is more image to show
+    int min_slack = v->cache_margin / 2;
+    if ((c->src[0] > 0) && (pos[0] < min_slack)) {
+        return true;
+    }
+    if ((c->src[0] + c->src[2] < v->width) && (c->bm->w - pos[0] - vis[2] < min_slack)) {
+        return true;
+    }
+    if ((c->src[1] > 0) && (pos[1] < min_slack)) {
+        return true;
+    }
+    if ((c->src[1] + c->src[3] < v->height) && (c->bm->h - pos[1] - vis[3] < min_slack)) {
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief free the cache bitmap.
+ *
+ * @param v the view.
+ */
+static void vw_cache_free(view_t *v) {
+    if (v->cache.bm) {
+        destroy_bitmap(v->cache.bm);
+        v->cache.bm = NULL;
+    }
+}
+
+/**
+ * @brief render the visible part of the image plus margin into a new cache bitmap.
+ * The work is done in bands, if a key is pressed in between the refill is abandoned and the old cache is kept.
+ *
+ * @param v the view.
+ *
+ * @return true if the cache was refilled, false if it was interrupted or there was not enough memory.
+ */
+static bool vw_cache_refill(view_t *v) {
+    int src[4];
+
+    vw_source_area(v, v->cache_margin, src);
+    int cache_w = vw_scaled(v->factor, src[0] + src[2]) - vw_scaled(v->factor, src[0]);
+    int cache_h = vw_scaled(v->factor, src[1] + src[3]) - vw_scaled(v->factor, src[1]);
+    if (cache_w <= 0 || cache_h <= 0) {
+        return false;
+    }
+
+    // the cache keeps the image depth, blitting it converts. Filtered palette images would lose colors, they are cached in screen depth.
+    int depth = bitmap_color_depth(v->img);
+    if ((depth == 8) && !v->mipmap.gray && (v->filter != RS_NEAREST) && dp_get_buffer()) {
+        depth = bitmap_color_depth(dp_get_buffer());
+    }
+    BITMAP *bm = create_bitmap_ex(depth, cache_w, cache_h);
+    if (!bm) {
+        DEBUGF("Can't allocate %dx%d cache\n", cache_w, cache_h);
+        return false;
+    }
+
+    int band = MAX(1, (int)(CACHE_BAND / v->factor));
+    for (int y = src[1]; y < src[1] + src[3]; y += band) {
+        if (keypressed()) {
+            DEBUG("cache refill interrupted\n");
+            destroy_bitmap(bm);
+            return false;
+        }
+        TRACE_BEGIN_ARG("cache band", y);
+        vw_draw_scaled(v, bm, v->factor, src, 0, 0, y, MIN(y + band, src[1] + src[3]), v->filter);
+        TRACE_END("cache band");
+    }
+
+    vw_cache_free(v);
+    v->cache.bm = bm;
+    v->cache.factor = v->factor;
+    v->cache.filter = v->filter;
+    memcpy(v->cache.src, src, sizeof(src));
+    DEBUGF("cache refilled with %dx%d at %d/%d\n", cache_w, cache_h, src[0], src[1]);
+
+    return true;
+}
+
+/**
+ * @brief calculate the "fit on screen" zoom factor.
+ *
+ * @param v the view.
+ *
+ * @return the zoom factor.
+ */
+static float vw_fit_factor(view_t *v) {
+    if (v->width > v->height) {
+        return (float)v->screen_width / (float)v->width;
+    } else {
+        return (float)v->screen_height / (float)v->height;
+    }
+}
+
+/**
+ * @brief recalculate the scaled image size and keep the image position inside the image.
+ *
+ * @param v the view.
+ */
+static void vw_sanitize(view_t *v) {
+    v->scaled_width = v->width * v->factor;
+    v->scaled_height = v->height * v->factor;
+
+    if (v->scaled_width > v->screen_width) {
+        int src_w = (v->width * v->screen_width) / v->scaled_width;
+        if (v->x_start + src_w >= v->width) {
+            v->x_start = v->width - src_w - 1;
+        }
+    }
+
+    if (v->scaled_height > v->screen_height) {
+        int src_h = (v->height * v->screen_height) / v->scaled_height;
+        if (v->y_start + src_h >= v->height) {
+            v->y_start = v->height - src_h - 1;
+        }
+    }
+
+    if (v->x_start < 0) {
+        v->x_start = 0;
+    }
+    if (v->y_start < 0) {
+        v->y_start = 0;
+    }
+}
+
+/**
+ * @brief draw the image info box.
+ *
+ * @param v the view.
+ * @param target the bitmap to draw to.
+ */
+static void vw_draw_info(view_t *v, BITMAP *target) {
+    int depth = bitmap_color_depth(target);
+    int ySpacing = font->height + 1;
+    int xPos = 20;
+    int yPos = 10;
+    int width = 25 * 8;
+    int height = ySpacing * 17;
+    if (strlen(v->filename) > 9) {
+        width += (strlen(v->filename) - 9) * 8;
+    }
+    if (v->num_images > 1) {
+        width += 12 * 8;
+    }
+
+    // time of the load stages, the same numbers as -v prints
+    char load[128] = "unknown";
+    char heap[64] = "unknown";
+    if (v->stats) {
+        st_report_t *r = v->stats;
+        snprintf(load, sizeof(load), "%lums (probe %lu, decode %lu, convert %lu, cache %lu)", (unsigned long)(r->total / 1000),
+                 (unsigned long)(r->us[ST_PROBE] / 1000), (unsigned long)(r->us[ST_DECODE] / 1000), (unsigned long)(r->us[ST_CONVERT] / 1000),
+                 (unsigned long)(r->us[ST_CACHE] / 1000));
+        snprintf(heap, sizeof(heap), "%lu KiB (decode %lu KiB)", (unsigned long)((r->heap_peak - r->heap_base) >> 10),
+                 (unsigned long)((r->peak[ST_DECODE] > r->heap_base) ? (r->peak[ST_DECODE] - r->heap_base) >> 10 : 0));
+    }
+    width = MAX(width, (14 + (int)strlen(load)) * 8 + 8);
+
+    rectfill(target, xPos, yPos, xPos + width, yPos + height, makecol_depth(depth, 32, 32, 32));
+    rect(target, xPos, yPos, xPos + width, yPos + height, makecol_depth(depth, 227, 198, 34));
+
+    xPos += 8;
+    yPos += 8;
+    int txt_col = makecol_depth(depth, 161, 21, 158);
+    if (v->num_images > 1) {
+        textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Filename    : %s (%d/%d)", v->filename, v->image_index + 1, v->num_images);
+    } else {
+        textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Filename    : %s", v->filename);
+    }
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Image size  : %04dx%04d %dbpp", v->width, v->height, bitmap_color_depth(v->img));
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Screen size : %04dx%04d", v->screen_width, v->screen_height);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Screen bpp  : %dbpp", depth);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Display     : %s", dp_get_mode());
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Scaled size : %04dx%04d", v->scaled_width, v->scaled_height);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Image pos   : %04dx%04d", v->x_start, v->y_start);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Factor      : %.5f", v->factor);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Load time   : %s", load);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Peak heap   : %s", heap);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Frame time  : %lums (%d keys)", (unsigned long)(v->frame_time / 1000), v->frame_keys);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Cache       : %s", v->cache_hit ? "hit" : "miss");
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Mipmap      : level %d", v->mipmap_level);
+    yPos += ySpacing;
+    textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Filter      : %s%s", rs_filter_name(v->filter), v->linear ? " (linear)" : "");
+    yPos += ySpacing;
+    if (v->tiles) {
+        textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Tiles       : %lu read, %lu written%s", (unsigned long)v->tiles->reads, (unsigned long)v->tiles->writes,
+                      v->tiles->error ? " (I/O error)" : "");
+    } else {
+        textprintf_ex(target, font, xPos, yPos, txt_col, -1, "Tiles       : not used");
+    }
+    yPos += ySpacing;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize the view with "fit on screen" zoom.
+ *
+ * @param v the view to initialize.
+ * @param img the image in display color depth or 8bpp (using the current palette).
+ * @param tiles the full size image if img is only a reduced overview of it, else NULL.
+ * @param filename name of the image file (for the info box).
+ * @param screen_width width of the output.
+ * @param screen_height height of the output.
+ * @param cache_margin number of pixels pre-scaled around the visible area for fast panning (0 to disable).
+ * @param filter resampling filter for the cache, frames that miss the cache are always scaled with nearest neighbour.
+ * @param linear resample in linear light.
+ */
+void vw_init(view_t *v, BITMAP *img, tile_store_t *tiles, const char *filename, int screen_width, int screen_height, int cache_margin, int filter,
+             bool linear) {
+    memset(v, 0, sizeof(view_t));
+    v->img = img;
+    v->width = img->w;
+    v->height = img->h;
+    if (tiles) {
+        // the overview takes the place of the pyramid level with the same size
+        v->tiles = tiles;
+        v->width = tiles->width;
+        v->height = tiles->height;
+        int w = v->width;
+        while ((w > img->w) && (v->base_level < tiles->num_levels)) {
+            w = (w + 1) / 2;
+            v->base_level++;
+        }
+    }
+    v->filename = filename;
+    v->screen_width = screen_width;
+    v->screen_height = screen_height;
+    v->cache_margin = cache_margin;
+    v->filter = filter;
+    v->linear = linear;
+    v->num_images = 1;
+    mm_init(&v->mipmap, img);
+    v->factor = vw_fit_factor(v);
+    vw_sanitize(v);
+}
+
+/**
+ * @brief free all resources of the view (but not the image).
+ *
+ * @param v the view.
+ */
+void vw_exit(view_t *v) {
+    vw_cache_free(v);
+    mm_exit(&v->mipmap);
+}
+
+/**
+ * @brief compose a complete frame of the current view.
+ * This only draws into the given bitmap, so it works with the back buffer as well as with any memory bitmap.
+ *
+ * @param v the view.
+ * @param target the bitmap to draw to, must have the size of the screen.
+ */
+void vw_render(view_t *v, BITMAP *target) {
+    int vis[4], dest[2], pos[2];
+
+    clear_to_color(target, 0);
+
+    DEBUGF("start = %dx%d, factor=%f, scaled=%dx%d\n", v->x_start, v->y_start, v->factor, v->scaled_width, v->scaled_height);
+    vw_visible(v, vis, dest);
+
+    if (vw_cache_covers(v, vis, pos)) {
+        // panning inside the cache is a plain blit
+        blit(v->cache.bm, target, pos[0], pos[1], dest[0], dest[1], vis[2], vis[3]);
+        v->cache_hit = true;
+    } else {
+        // scale the visible part directly, the cache is refilled when the user is idle
+        int src[4];
+        vw_source_area(v, 0, src);
+        int off_x = dest[0] + vw_scaled(v->factor, src[0]) - vis[0];
+        int off_y = dest[1] + vw_scaled(v->factor, src[1]) - vis[1];
+        vw_draw_scaled(v, target, v->factor, src, off_x, off_y, src[1], src[1] + src[3], RS_NEAREST);
+        v->cache_hit = false;
+    }
+
+    if (v->image_info) {
+        vw_draw_info(v, target);
+    }
+}
+
+/**
+ * @brief reset the collected input for the next frame.
+ *
+ * @param in the input to reset.
+ */
+void vw_clear_input(view_input_t *in) {
+    memset(in, 0, sizeof(view_input_t));
+    in->zoom = 1.0f;
+}
+
+/**
+ * @brief add a key press to the input collected for the next frame.
+ * Movement and zoom are accumulated so a burst of key presses results in a single redraw.
+ *
+ * @param in the collected input.
+ * @param key the key as returned by readkey().
+ * @param shifts the modifier flags (key_shifts).
+ */
+void vw_handle_key(view_input_t *in, int key, int shifts) {
+    int key_upper = (key >> 8);
+    char key_lower = (char)(key & 0xFF);
+
+    DEBUGF("key=%04X\n", key);
+
+    in->num_keys++;
+
+    // modifiers
+    int stepsize = 2;
+    float scale_step = 1.1f;
+    if (shifts & KB_SHIFT_FLAG) {
+        stepsize *= 2;
+        scale_step *= 2;
+    }
+    if (shifts & KB_CTRL_FLAG) {
+        stepsize *= 4;
+        scale_step *= 4;
+    }
+    if (shifts & KB_ALT_FLAG) {
+        stepsize *= 8;
+        scale_step *= 8;
+    }
+
+    // keys
+    if ((key_upper == KEY_ESC) || (key_lower == 'Q') || (key_lower == 'q')) {
+        in->quit = true;
+    } else if ((key_upper == KEY_LEFT) || (key_lower == '4')) {
+        in->dx -= stepsize;
+    } else if ((key_upper == KEY_RIGHT) || (key_lower == '6')) {
+        in->dx += stepsize;
+    } else if ((key_upper == KEY_UP) || (key_lower == '8')) {
+        in->dy -= stepsize;
+    } else if ((key_upper == KEY_DOWN) || (key_lower == '2')) {
+        in->dy += stepsize;
+    } else if ((key_upper == KEY_PGDN) || (key_lower == '3')) {
+        in->zoom /= scale_step;
+    } else if ((key_upper == KEY_PGUP) || (key_lower == '9')) {
+        in->zoom *= scale_step;
+    } else if ((key_lower == 'F') || (key_lower == 'f')) {
+        // fit on screen, zooming before this key press is void
+        in->fit = true;
+        in->full = false;
+        in->zoom = 1.0f;
+    } else if ((key_lower == 'Z') || (key_lower == 'z')) {
+        // full zoom, zooming before this key press is void
+        in->full = true;
+        in->fit = false;
+        in->zoom = 1.0f;
+    } else if ((key_lower == 'I') || (key_lower == 'i')) {
+        in->info = !in->info;
+    } else if (key_lower == ' ') {
+        in->step++;
+    } else if (key_upper == KEY_BACKSPACE) {
+        in->step--;
+    }
+}
+
+/**
+ * @brief apply the collected input to the view.
+ *
+ * @param v the view.
+ * @param in the collected input.
+ *
+ * @return false if the user wants to quit or to see another image, else true.
+ */
+bool vw_apply_input(view_t *v, view_input_t *in) {
+    if (in->quit) {
+        return false;
+    }
+
+    if (v->num_images <= 1) {
+        in->step = 0;
+    } else if (in->step) {
+        return false;
+    }
+
+    if (in->fit) {
+        v->factor = vw_fit_factor(v);
+    } else if (in->full) {
+        v->factor = 1.0f;
+    }
+
+    if (in->zoom != 1.0f) {
+        DEBUGF("factor = %f, zoom = %f, new_factor = %f\n", v->factor, in->zoom, v->factor * in->zoom);
+        float new_factor = v->factor * in->zoom;
+        if ((in->zoom > 1.0f) || ((v->width * new_factor >= v->screen_width / MIN_ZOOM) && (v->height * new_factor >= v->screen_height / MIN_ZOOM))) {
+            v->factor = new_factor;
+        }
+    }
+
+    if (in->info) {
+        v->image_info = !v->image_info;
+    }
+
+    v->x_start += in->dx;
+    v->y_start += in->dy;
+    v->frame_keys = in->num_keys;
+
+    vw_sanitize(v);
+
+    return true;
+}
+
+/**
+ * @brief take over zoom, position and info box of another view of the same image, e.g. the one that showed it while it was decoded.
+ *
+ * @param v the view.
+ * @param from the other view, nothing is taken if the image size differs.
+ */
+void vw_take_position(view_t *v, const view_t *from) {
+    if ((from->width != v->width) || (from->height != v->height)) {
+        return;
+    }
+    v->factor = from->factor;
+    v->x_start = from->x_start;
+    v->y_start = from->y_start;
+    v->image_info = from->image_info;
+    vw_sanitize(v);
+}
+
+/**
+ * @brief add all queued key presses to the collected input without waiting, e.g. while an image is loading.
+ *
+ * @param in the collected input.
+ */
+void vw_read_keys(view_input_t *in) {
+    if (keyboard_needs_poll()) {
+        poll_keyboard();
+    }
+    while (!in->quit && keypressed()) {
+        int key = readkey();
+        vw_handle_key(in, key, key_shifts);
+    }
+}
+
+/**
+ * @brief show the image again after its pixels changed (e.g. the next scan of a progressive JPEG was decoded), without waiting for input.
+ * The keys pressed since the last call are applied first, so the user can zoom and pan while the image is still loading.
+ * Frames are always scaled with nearest neighbour, the cache is not used.
+ *
+ * @param v the view.
+ * @param in input collected since the last call (e.g. by a progress hook), the queued keys are added. It is cleared afterwards.
+ * @param step returns what vw_show() would return when the user quits or wants to see another image.
+ *
+ * @return false if the user wants to quit or to see another image, else true.
+ */
+bool vw_refresh(view_t *v, view_input_t *in, int *step) {
+    // the pyramid levels are built on demand, the outdated ones are dropped
+    mm_exit(&v->mipmap);
+    mm_init(&v->mipmap, v->img);
+    vw_cache_free(v);
+
+    vw_read_keys(in);
+    bool go_on = vw_apply_input(v, in);
+    *step = in->quit ? 0 : in->step;
+    vw_clear_input(in);
+    if (!go_on) {
+        return false;
+    }
+
+    uint64_t start = ut_time_us();
+    TRACE_BEGIN("viewer redraw");
+    vw_render(v, dp_get_buffer());
+    dp_present();
+    TRACE_END("viewer redraw");
+    v->frame_time = ut_time_us() - start;
+    return true;
+}
+
+/**
+ * @brief draw a progress bar for an image that is loading at the bottom of the target, the rest of the target is left alone.
+ *
+ * @param target the bitmap to draw to.
+ * @param filename the image.
+ * @param done work done.
+ * @param total total work.
+ */
+void vw_draw_progress(BITMAP *target, const char *filename, uint32_t done, uint32_t total) {
+    int depth = bitmap_color_depth(target);
+    int ySpacing = font->height + 1;
+    int xPos = 20;
+    int width = target->w - 2 * xPos;
+    int height = ySpacing * 2 + 16;
+    int yPos = target->h - height - 10;
+    int percent = total ? (int)((uint64_t)MIN(done, total) * 100 / total) : 0;
+
+    rectfill(target, xPos, yPos, xPos + width, yPos + height, makecol_depth(depth, 32, 32, 32));
+    rect(target, xPos, yPos, xPos + width, yPos + height, makecol_depth(depth, 227, 198, 34));
+
+    xPos += 8;
+    yPos += 8;
+    width -= 16;
+    textprintf_ex(target, font, xPos, yPos, makecol_depth(depth, 161, 21, 158), -1, "Loading %s: %d%% (ESC aborts)", filename, percent);
+    yPos += ySpacing;
+    rect(target, xPos, yPos, xPos + width, yPos + font->height, makecol_depth(depth, 161, 21, 158));
+    if (percent) {
+        rectfill(target, xPos, yPos, xPos + width * percent / 100, yPos + font->height, makecol_depth(depth, 161, 21, 158));
+    }
+}
+
+/**
+ * @brief show the image until the user quits or wants to see another image.
+ * Frames are composed in the back buffer and then presented in one go to avoid flicker.
+ * All keys that queued up while a frame was rendered (e.g. by auto repeat) are combined into the next frame,
+ * so the view stops moving as soon as a key is released. Frames drawn while the user is busy use nearest neighbour, the
+ * filtered cache replaces them as soon as the user is idle. After that the idle function is called.
+ *
+ * @param v the view.
+ *
+ * @return the number of images to move forward in the list (backward if negative), 0 if the user wants to quit.
+ */
+int vw_show(view_t *v) {
+    view_input_t in;
+
+    while (true) {
+        uint64_t start = ut_time_us();
+        TRACE_BEGIN("viewer redraw");
+        vw_render(v, dp_get_buffer());
+        dp_present();
+        TRACE_END("viewer redraw");
+        v->frame_time = ut_time_us() - start;
+        DEBUGF("frame took %lluus for %d keys\n", v->frame_time, v->frame_keys);
+
+        // use the time until the next key press to prepare the cache
+        vw_clear_input(&in);
+        if (keyboard_needs_poll()) {
+            poll_keyboard();
+        }
+        if (!keypressed() && vw_cache_stale(v) && vw_cache_refill(v) && (v->filter != RS_NEAREST)) {
+            // replace the quick nearest neighbour frame with the filtered one
+            TRACE_BEGIN("viewer redraw");
+            vw_render(v, dp_get_buffer());
+            dp_present();
+            TRACE_END("viewer redraw");
+        }
+        while (v->idle && !keypressed() && v->idle(v->idle_ctx)) {
+            if (keyboard_needs_poll()) {
+                poll_keyboard();
+            }
+        }
+
+        // block until there is input
+        int key = readkey();
+        vw_handle_key(&in, key, key_shifts);
+
+        // drain everything that is already queued, but never longer than one frame budget
+        start = ut_time_us();
+        while (!in.quit && (ut_time_us() - start < FRAME_BUDGET)) {
+            if (keyboard_needs_poll()) {
+                poll_keyboard();
+            }
+            if (!keypressed()) {
+                break;
+            }
+            key = readkey();
+            vw_handle_key(&in, key, key_shifts);
+        }
+
+        if (!vw_apply_input(v, &in)) {
+            return in.quit ? 0 : in.step;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+MIT License
+
+Copyright (c) 2025 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __VIEWER_H__
+#define __VIEWER_H__
+
+#include "main.h"
+#include "mipmap.h"
+#include "tilestore.h"
+#include "stats.h"
+
+/************
+** structs **
+************/
+//! pre-scaled part of the image around the visible area
+typedef struct __view_cache {
+    BITMAP *bm;    //!< the scaled pixels or NULL
+    float factor;  //!< zoom factor the cache was drawn with
+    int filter;    //!< resampling filter the cache was drawn with
+    int src[4];    //!< image area in the cache (x, y, w, h)
+} view_cache_t;
+
+//! state of the image viewer
+typedef struct __view {
+    BITMAP *img;           //!< the image in display color depth or 8bpp with the current palette, an overview if tiles is set
+    tile_store_t *tiles;   //!< the full size image if it did not fit into memory or NULL
+    int base_level;        //!< pyramid level of img, levels below it come from the tile store
+    int width;             //!< width of the full size image
+    int height;            //!< height of the full size image
+    const char *filename;  //!< name of the image file
+    int screen_width;      //!< width of the output
+    int screen_height;     //!< height of the output
+    float factor;          //!< zoom factor
+    int x_start;           //!< left image column shown when zoomed in
+    int y_start;           //!< top image row shown when zoomed in
+    int scaled_width;      //!< width of the image at the current zoom factor
+    int scaled_height;     //!< height of the image at the current zoom factor
+    bool image_info;       //!< show the image info overlay
+    uint64_t frame_time;   //!< time needed to render the last frame [us]
+    int frame_keys;        //!< number of key presses combined into the last frame
+    int cache_margin;      //!< number of screen pixels cached on each side of the visible area
+    view_cache_t cache;    //!< pre-scaled image around the visible area
+    bool cache_hit;        //!< last frame was drawn from the cache
+    mipmap_t mipmap;       //!< reduced copies of the image for zooming out
+    int mipmap_level;      //!< pyramid level used for the last frame
+    int filter;            //!< resampling filter used to fill the cache
+    bool linear;           //!< resample in linear light
+    int image_index;       //!< number of the image in the list shown
+    int num_images;        //!< number of images in the list, next/previous image keys are ignored if there is only one
+    st_report_t *stats;    //!< how long loading the image took (info overlay) or NULL
+    bool (*idle)(void *);  //!< called while the user is idle until it returns false (or NULL)
+    void *idle_ctx;        //!< argument for idle()
+} view_t;
+
+//! net effect of all key presses collected for the next frame
+typedef struct __view_input {
+    int dx;          //!< horizontal movement in image pixels
+    int dy;          //!< vertical movement in image pixels
+    float zoom;      //!< factor to multiply the zoom factor with
+    bool fit;        //!< set zoom to "fit on screen" before applying zoom
+    bool full;       //!< set zoom to 1.0 before applying zoom
+    bool info;       //!< toggle image info
+    bool quit;       //!< user wants to quit
+    int step;        //!< move this many images forward in the list (backward if negative)
+    int num_keys;    //!< number of keys combined
+} view_input_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void vw_init(view_t *v, BITMAP *img, tile_store_t *tiles, const char *filename, int screen_width, int screen_height, int cache_margin, int filter,
+                    bool linear);
+extern void vw_exit(view_t *v);
+extern void vw_render(view_t *v, BITMAP *target);
+extern void vw_clear_input(view_input_t *in);
+extern void vw_handle_key(view_input_t *in, int key, int shifts);
+extern bool vw_apply_input(view_t *v, view_input_t *in);
+extern void vw_take_position(view_t *v, const view_t *from);
+extern void vw_read_keys(view_input_t *in);
+extern bool vw_refresh(view_t *v, view_input_t *in, int *step);
+extern void vw_draw_progress(BITMAP *target, const char *filename, uint32_t done, uint32_t total);
+extern int vw_show(view_t *v);
+
+#endif  // __VIEWER_H__